@@ -0,0 +1,486 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <termios.h>
+#include <time.h>
+#include "inc/modbus.h"
+#include "inc/relogio.h"
+
+// Emulador dos escravos MODBUS do Térreo (câmeras LPR 0x11/0x12 e placar 0x20)
+// sobre um pseudo-terminal. Permite rodar e medir modbus.c/lpr_terreo.c sem
+// o barramento RS485 real:
+//
+//   bin/emulador_modbus -l /tmp/ttyMODBUS -t 2 -P 40 -e "ABC1D23:95,ERRO" &
+//   MODBUS_SERIAL_PORT=/tmp/ttyMODBUS bin/main t
+
+#define EMU_MAX_SCRIPT      32
+#define EMU_REGS_CAMERA     8
+#define EMU_QUADRO_MAX      260
+
+// Uma entrada do roteiro de leituras da câmera
+typedef struct {
+    char placa[9];
+    int confianca;
+    bool erro;          // true = câmera termina em LPR_STATUS_ERRO
+} EmuLeitura;
+
+// Estado de uma câmera LPR emulada
+typedef struct {
+    uint8_t endereco;
+    uint16_t regs[EMU_REGS_CAMERA];     // status, trigger, placa[4], confiança, erro
+    EmuLeitura roteiro[EMU_MAX_SCRIPT];
+    int tamanho_roteiro;
+    int proxima;                        // Próxima leitura do roteiro
+    double inicio_processamento_ms;     // relogio_agora_ms do trigger
+    int processamento_ms;
+} EmuCamera;
+
+// Contadores do emulador
+typedef struct {
+    unsigned long quadros;
+    unsigned long respondidos;
+    unsigned long descartados;          // Falha simulada (sem resposta)
+    unsigned long crc_corrompido;       // Resposta enviada com CRC errado
+    unsigned long erro_crc;             // Requisição com CRC inválido
+    unsigned long erro_matricula;       // Requisição sem a matrícula esperada
+    unsigned long outro_endereco;       // Endereço que não é emulado
+    unsigned long triggers;
+} EmuEstatisticas;
+
+static EmuCamera cameras[2];
+static uint16_t regs_placar[PLACAR_NUM_REGS];
+static EmuEstatisticas estat;
+
+// Parâmetros de linha de comando
+static int latencia_ms = 2;
+static int percentual_descarte = 0;
+static int percentual_crc = 0;
+static bool verbose = false;
+static bool suporta_leitura_escrita = true;    // Função 0x17 (desligável com -x)
+static const char *link_pty = NULL;
+static volatile sig_atomic_t encerrar = 0;
+
+static void trata_sinal(int sig) {
+    (void)sig;
+    encerrar = 1;
+}
+
+static void dorme_ms(int ms) {
+    if (ms > 0) {
+        usleep(ms * 1000);
+    }
+}
+
+/**
+ * @brief Lê um roteiro no formato "PLACA:CONF,PLACA:CONF,ERRO"
+ */
+static int carrega_roteiro(const char *texto, EmuLeitura *roteiro) {
+    char copia[512];
+    snprintf(copia, sizeof(copia), "%s", texto);
+
+    int n = 0;
+    char *salvo = NULL;
+    for (char *item = strtok_r(copia, ",", &salvo); item && n < EMU_MAX_SCRIPT;
+         item = strtok_r(NULL, ",", &salvo)) {
+        memset(&roteiro[n], 0, sizeof(EmuLeitura));
+        if (strcmp(item, "ERRO") == 0) {
+            roteiro[n].erro = true;
+        } else {
+            char *sep = strchr(item, ':');
+            roteiro[n].confianca = sep ? atoi(sep + 1) : 95;
+            if (sep) {
+                *sep = '\0';
+            }
+            snprintf(roteiro[n].placa, sizeof(roteiro[n].placa), "%-8s", item);
+        }
+        n++;
+    }
+    return n;
+}
+
+static void inicializa_camera(EmuCamera *cam, uint8_t endereco, const char *roteiro, int processamento_ms) {
+    memset(cam, 0, sizeof(*cam));
+    cam->endereco = endereco;
+    cam->processamento_ms = processamento_ms;
+    cam->tamanho_roteiro = carrega_roteiro(roteiro, cam->roteiro);
+    cam->regs[0] = LPR_STATUS_PRONTO;
+}
+
+static EmuCamera *busca_camera(uint8_t endereco) {
+    for (int i = 0; i < 2; i++) {
+        if (cameras[i].endereco == endereco) {
+            return &cameras[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Avança a máquina de estados PRONTO → PROCESSANDO → OK/ERRO
+ * 
+ * O processamento conta no relógio (RELOGIO), como o polling do Térreo. O
+ * relógio virtual é de cada processo e aqui não anda: nesse modo a câmera
+ * conclui na primeira consulta.
+ */
+static void atualiza_camera(EmuCamera *cam) {
+    if (cam->regs[0] != LPR_STATUS_PROCESSANDO) {
+        return;
+    }
+
+    if (relogio_modo() != RELOGIO_VIRTUAL &&
+        relogio_agora_ms() - cam->inicio_processamento_ms < cam->processamento_ms) {
+        return;
+    }
+
+    EmuLeitura *leitura = &cam->roteiro[cam->proxima];
+    cam->proxima = (cam->proxima + 1) % cam->tamanho_roteiro;
+
+    if (leitura->erro) {
+        cam->regs[0] = LPR_STATUS_ERRO;
+        cam->regs[7] = 1;
+        memset(&cam->regs[2], 0, 4 * sizeof(uint16_t));
+        cam->regs[6] = 0;
+    } else {
+        cam->regs[0] = LPR_STATUS_OK;
+        cam->regs[7] = 0;
+        for (int i = 0; i < 4; i++) {
+            cam->regs[2 + i] = (uint8_t)leitura->placa[2 * i] | ((uint8_t)leitura->placa[2 * i + 1] << 8);
+        }
+        cam->regs[6] = leitura->confianca;
+    }
+
+    if (verbose) {
+        printf("[EMU 0x%02X] Processamento concluído: %s\n", cam->endereco,
+               leitura->erro ? "ERRO" : leitura->placa);
+    }
+}
+
+/**
+ * @brief Aplica a escrita de um registro da câmera (trigger no offset 1)
+ */
+static void escreve_camera(EmuCamera *cam, int offset, uint16_t valor) {
+    if (offset == 1) {
+        if (valor != 0 && cam->regs[0] == LPR_STATUS_PRONTO) {
+            cam->regs[0] = LPR_STATUS_PROCESSANDO;
+            cam->inicio_processamento_ms = relogio_agora_ms();
+            estat.triggers++;
+        } else if (valor == 0) {
+            // Zerar o trigger devolve a câmera ao estado pronto
+            cam->regs[0] = LPR_STATUS_PRONTO;
+        }
+    }
+    cam->regs[offset] = valor;
+}
+
+/**
+ * @brief Tamanho total de uma requisição (com matrícula e CRC) a partir do cabeçalho
+ * @return tamanho, 0 se ainda faltam bytes, -1 se função não suportada
+ */
+static int tamanho_requisicao(const uint8_t *q, int len) {
+    if (len < 2) {
+        return 0;
+    }
+    switch (q[1]) {
+        case MODBUS_FUNC_READ_HOLDING:
+            return 6 + 4 + 2;
+        case MODBUS_FUNC_WRITE_MULTIPLE:
+            return (len < 7) ? 0 : 7 + q[6] + 4 + 2;
+        case MODBUS_FUNC_READ_WRITE_MULTIPLE:
+            if (!suporta_leitura_escrita) {
+                return -1;
+            }
+            return (len < 11) ? 0 : 11 + q[10] + 4 + 2;
+        default:
+            return -1;
+    }
+}
+
+/**
+ * @brief Envia a resposta aplicando latência, descarte e corrupção configurados
+ */
+static void responde(int fd, uint8_t *resp, int len) {
+    uint16_t crc = modbus_crc16(resp, len);
+    resp[len] = crc & 0xFF;
+    resp[len + 1] = (crc >> 8) & 0xFF;
+    len += 2;
+
+    if (rand() % 100 < percentual_descarte) {
+        estat.descartados++;
+        if (verbose) {
+            printf("[EMU] Resposta descartada (simulação)\n");
+        }
+        return;
+    }
+
+    if (rand() % 100 < percentual_crc) {
+        resp[len - 1] ^= 0x5A;
+        estat.crc_corrompido++;
+    }
+
+    dorme_ms(latencia_ms);
+    if (write(fd, resp, len) != len) {
+        fprintf(stderr, "[EMU] Erro ao responder: %s\n", strerror(errno));
+        return;
+    }
+    estat.respondidos++;
+}
+
+static void responde_excecao(int fd, uint8_t endereco, uint8_t funcao, uint8_t codigo) {
+    uint8_t resp[5] = { endereco, funcao | 0x80, codigo };
+    responde(fd, resp, 3);
+}
+
+/**
+ * @brief Valida e executa uma requisição completa
+ */
+static void processa_quadro(int fd, uint8_t *q, int len) {
+    estat.quadros++;
+
+    uint16_t crc_recebido = q[len - 2] | (q[len - 1] << 8);
+    if (crc_recebido != modbus_crc16(q, len - 2)) {
+        estat.erro_crc++;
+        fprintf(stderr, "[EMU] CRC inválido na requisição para 0x%02X\n", q[0]);
+        return;
+    }
+
+    if (memcmp(&q[len - 6], MODBUS_MATRICULA, 4) != 0) {
+        estat.erro_matricula++;
+        fprintf(stderr, "[EMU] Matrícula ausente/errada na requisição para 0x%02X\n", q[0]);
+        return;
+    }
+
+    uint8_t endereco = q[0];
+    uint8_t funcao = q[1];
+    int inicio = q[2] | (q[3] << 8);
+    int quantidade = q[4] | (q[5] << 8);
+
+    EmuCamera *cam = busca_camera(endereco);
+    uint16_t *regs;
+    int total_regs;
+    if (cam) {
+        atualiza_camera(cam);
+        regs = cam->regs;
+        total_regs = EMU_REGS_CAMERA;
+    } else if (endereco == MODBUS_ADDR_PLACAR) {
+        regs = regs_placar;
+        total_regs = PLACAR_NUM_REGS;
+    } else {
+        // Outro escravo no barramento: fica em silêncio, como no RS485 real
+        estat.outro_endereco++;
+        return;
+    }
+
+    if (quantidade == 0 || inicio + quantidade > total_regs) {
+        responde_excecao(fd, endereco, funcao, 0x02);  // Endereço de dados ilegal
+        return;
+    }
+
+    // 0x17: a área de escrita vem depois da de leitura e é aplicada antes dela
+    int inicio_escrita = 0;
+    int quantidade_escrita = 0;
+    if (funcao == MODBUS_FUNC_READ_WRITE_MULTIPLE) {
+        inicio_escrita = q[6] | (q[7] << 8);
+        quantidade_escrita = q[8] | (q[9] << 8);
+        if (quantidade_escrita == 0 || inicio_escrita + quantidade_escrita > total_regs) {
+            responde_excecao(fd, endereco, funcao, 0x02);
+            return;
+        }
+        for (int i = 0; i < quantidade_escrita; i++) {
+            uint16_t valor = q[11 + 2 * i] | (q[12 + 2 * i] << 8);
+            if (cam) {
+                escreve_camera(cam, inicio_escrita + i, valor);
+            } else {
+                regs[inicio_escrita + i] = valor;
+            }
+        }
+    }
+
+    uint8_t resp[EMU_QUADRO_MAX];
+    if (funcao == MODBUS_FUNC_READ_HOLDING || funcao == MODBUS_FUNC_READ_WRITE_MULTIPLE) {
+        resp[0] = endereco;
+        resp[1] = funcao;
+        resp[2] = quantidade * 2;
+        for (int i = 0; i < quantidade; i++) {
+            resp[3 + 2 * i] = regs[inicio + i] & 0xFF;
+            resp[4 + 2 * i] = (regs[inicio + i] >> 8) & 0xFF;
+        }
+        responde(fd, resp, 3 + quantidade * 2);
+    } else {
+        for (int i = 0; i < quantidade; i++) {
+            uint16_t valor = q[7 + 2 * i] | (q[8 + 2 * i] << 8);
+            if (cam) {
+                escreve_camera(cam, inicio + i, valor);
+            } else {
+                regs[inicio + i] = valor;
+            }
+        }
+        memcpy(resp, q, 6);
+        responde(fd, resp, 6);
+    }
+
+    if (verbose) {
+        printf("[EMU 0x%02X] func=0x%02X inicio=%d qtd=%d\n", endereco, funcao, inicio, quantidade);
+    }
+}
+
+static void imprime_estatisticas() {
+    printf("[EMU] quadros=%lu respondidos=%lu descartados=%lu crc_corrompido=%lu "
+           "erro_crc=%lu erro_matricula=%lu outro_endereco=%lu triggers=%lu\n",
+           estat.quadros, estat.respondidos, estat.descartados, estat.crc_corrompido,
+           estat.erro_crc, estat.erro_matricula, estat.outro_endereco, estat.triggers);
+    printf("[EMU] Placar: ");
+    for (int i = 0; i < PLACAR_NUM_REGS; i++) {
+        printf("%d ", regs_placar[i]);
+    }
+    printf("\n");
+}
+
+static void uso(const char *prog) {
+    printf("Uso: %s [opções]\n", prog);
+    printf("  -l <caminho>  Cria link simbólico para o pty (ex: /tmp/ttyMODBUS)\n");
+    printf("  -t <ms>       Latência de resposta dos escravos (padrão 2)\n");
+    printf("  -P <ms>       Tempo de processamento das câmeras (padrão 40)\n");
+    printf("  -e <roteiro>  Leituras da câmera de entrada (ex: \"ABC1D23:95,XYZ9K88:55,ERRO\")\n");
+    printf("  -s <roteiro>  Leituras da câmera de saída\n");
+    printf("  -d <pct>      Percentual de respostas descartadas\n");
+    printf("  -c <pct>      Percentual de respostas com CRC corrompido\n");
+    printf("  -r <semente>  Semente do gerador aleatório (reprodutibilidade)\n");
+    printf("  -x            Não implementa a função 0x17 (testa o fallback do mestre)\n");
+    printf("  -v            Mostra cada transação\n");
+}
+
+int main(int argc, char **argv) {
+    const char *roteiro_entrada = "ABC1D23:95";
+    const char *roteiro_saida = "ABC1D23:92";
+    int processamento_ms = 40;
+    unsigned int semente = 1;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "l:t:P:e:s:d:c:r:xvh")) != -1) {
+        switch (opt) {
+            case 'l': link_pty = optarg; break;
+            case 't': latencia_ms = atoi(optarg); break;
+            case 'P': processamento_ms = atoi(optarg); break;
+            case 'e': roteiro_entrada = optarg; break;
+            case 's': roteiro_saida = optarg; break;
+            case 'd': percentual_descarte = atoi(optarg); break;
+            case 'c': percentual_crc = atoi(optarg); break;
+            case 'r': semente = (unsigned int)atoi(optarg); break;
+            case 'x': suporta_leitura_escrita = false; break;
+            case 'v': verbose = true; break;
+            default: uso(argv[0]); return 1;
+        }
+    }
+    srand(semente);
+
+    inicializa_camera(&cameras[0], MODBUS_ADDR_LPR_ENTRADA, roteiro_entrada, processamento_ms);
+    inicializa_camera(&cameras[1], MODBUS_ADDR_LPR_SAIDA, roteiro_saida, processamento_ms);
+    if (cameras[0].tamanho_roteiro == 0 || cameras[1].tamanho_roteiro == 0) {
+        fprintf(stderr, "[EMU] Roteiro de câmera vazio\n");
+        return 1;
+    }
+
+    int mestre = posix_openpt(O_RDWR | O_NOCTTY);
+    if (mestre < 0 || grantpt(mestre) < 0 || unlockpt(mestre) < 0) {
+        perror("[EMU] Erro ao criar pseudo-terminal");
+        return 1;
+    }
+
+    // Lado mestre em modo raw: nenhum byte é reinterpretado pelo terminal
+    struct termios tio;
+    tcgetattr(mestre, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(mestre, TCSANOW, &tio);
+
+    const char *escravo = ptsname(mestre);
+    if (link_pty) {
+        unlink(link_pty);
+        if (symlink(escravo, link_pty) < 0) {
+            perror("[EMU] Erro ao criar link do pty");
+            return 1;
+        }
+    }
+
+    signal(SIGINT, trata_sinal);
+    signal(SIGTERM, trata_sinal);
+
+    printf("[EMU] Escravos 0x%02X, 0x%02X e 0x%02X em %s%s%s\n",
+           MODBUS_ADDR_LPR_ENTRADA, MODBUS_ADDR_LPR_SAIDA, MODBUS_ADDR_PLACAR, escravo,
+           link_pty ? " → " : "", link_pty ? link_pty : "");
+    printf("[EMU] latência=%d ms processamento=%d ms descarte=%d%% crc=%d%%\n",
+           latencia_ms, processamento_ms, percentual_descarte, percentual_crc);
+    fflush(stdout);
+
+    uint8_t quadro[EMU_QUADRO_MAX];
+    int len = 0;
+    struct pollfd pfd = { .fd = mestre, .events = POLLIN };
+
+    while (!encerrar) {
+        // Com quadro parcial, 3,5 caracteres de silêncio encerram o quadro
+        struct timespec espera = { 1, 0 };
+        if (len > 0) {
+            espera.tv_sec = 0;
+            espera.tv_nsec = MODBUS_SILENCIO_T35_US * 1000L;
+        }
+
+        int pronto = ppoll(&pfd, 1, &espera, NULL);
+        if (pronto < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("[EMU] Erro no poll");
+            break;
+        }
+        if (pronto == 0) {
+            if (len > 0) {
+                fprintf(stderr, "[EMU] Quadro incompleto descartado (%d bytes)\n", len);
+                len = 0;
+            }
+            continue;
+        }
+        if (pfd.revents & POLLHUP) {
+            // Nenhum cliente com o pty aberto: aguarda sem consumir CPU
+            dorme_ms(50);
+            continue;
+        }
+
+        int n = read(mestre, quadro + len, sizeof(quadro) - len);
+        if (n <= 0) {
+            continue;
+        }
+        len += n;
+
+        // Processa todas as requisições completas que já chegaram
+        while (len > 0) {
+            int esperado = tamanho_requisicao(quadro, len);
+            if (esperado < 0 || esperado > EMU_QUADRO_MAX) {
+                bool emulado = busca_camera(quadro[0]) || quadro[0] == MODBUS_ADDR_PLACAR;
+                if (len >= 2 && emulado) {
+                    responde_excecao(mestre, quadro[0], quadro[1], 0x01);  // Função ilegal
+                }
+                len = 0;
+                break;
+            }
+            if (esperado == 0 || len < esperado) {
+                break;
+            }
+            processa_quadro(mestre, quadro, esperado);
+            memmove(quadro, quadro + esperado, len - esperado);
+            len -= esperado;
+        }
+    }
+
+    imprime_estatisticas();
+    if (link_pty) {
+        unlink(link_pty);
+    }
+    close(mestre);
+    return 0;
+}
@@ -0,0 +1,137 @@
+#ifndef BARRAMENTO_H
+#define BARRAMENTO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+// Árbitro do barramento RS485: uma única thread é dona da porta serial e
+// executa as transações MODBUS de todas as outras threads, uma por vez,
+// em ordem de prioridade. Evita que quadros de LPR e placar se misturem no fio.
+
+// Prioridades (menor valor = atendido primeiro)
+typedef enum {
+    BARRAMENTO_PRIO_LPR_ENTRADA = 0,
+    BARRAMENTO_PRIO_LPR_SAIDA   = 1,
+    BARRAMENTO_PRIO_PLACAR      = 2,
+    BARRAMENTO_NUM_PRIORIDADES
+} BarramentoPrioridade;
+
+// Prazo máximo na fila antes de o pedido ser descartado (ms)
+#define BARRAMENTO_DEADLINE_LPR_MS      1000
+#define BARRAMENTO_DEADLINE_PLACAR_MS   2000
+
+// Capacidade da fila de cada prioridade
+#define BARRAMENTO_TAM_FILA             8
+
+// Intervalo entre relatórios de ocupação do barramento (segundos)
+#define BARRAMENTO_RELATORIO_S          60
+
+struct BarramentoPedido;
+
+/**
+ * @brief Callback chamado pela thread do barramento ao concluir um pedido
+ */
+typedef void (*BarramentoCallback)(struct BarramentoPedido *pedido);
+
+// Pedido de transação MODBUS na fila do barramento
+typedef struct BarramentoPedido {
+    uint8_t *request;                   // Quadro completo (com matrícula e CRC)
+    int req_len;
+    uint8_t *response;                  // Buffer da resposta
+    int resp_len;                       // Tamanho esperado da resposta
+    const char *rotulo;                 // Prefixo de debug
+    BarramentoPrioridade prioridade;
+    struct timespec submetido;          // Instante de entrada na fila
+    struct timespec deadline;           // Descartado se não iniciar até aqui; os retries também param nele
+    BarramentoCallback callback;        // Opcional (NULL = só futuro)
+    void *contexto;                     // Livre para o dono do pedido
+    volatile bool concluido;            // Futuro: true quando terminou
+    bool sucesso;
+    bool expirado;                      // true se descartado pelo deadline
+} BarramentoPedido;
+
+// Estatísticas de uso do barramento
+typedef struct {
+    unsigned long executados[BARRAMENTO_NUM_PRIORIDADES];
+    unsigned long falhas[BARRAMENTO_NUM_PRIORIDADES];
+    unsigned long expirados[BARRAMENTO_NUM_PRIORIDADES];
+    unsigned long rejeitados[BARRAMENTO_NUM_PRIORIDADES];  // Fila cheia
+    double espera_max_ms[BARRAMENTO_NUM_PRIORIDADES];      // Maior tempo na fila
+    double ocupado_ms;                  // Tempo total com transação no fio
+    double janela_ms;                   // Tempo total observado
+} BarramentoEstatisticas;
+
+/**
+ * @brief Abre a porta serial e inicia a thread dona do barramento
+ * @param porta Caminho da porta serial (ex: "/dev/serial0")
+ * @return true se o barramento está ativo (também se já estava)
+ */
+bool barramento_init(const char *porta);
+
+/**
+ * @brief Para a thread do barramento e fecha a porta serial
+ */
+void barramento_finalizar();
+
+/**
+ * @brief Retorna o file descriptor da porta do barramento (-1 se inativo)
+ */
+int barramento_fd();
+
+/**
+ * @brief Indica se uma transação em fd deve ser encaminhada ao árbitro
+ * @return true se fd é a porta do barramento e o chamador não é a thread dona
+ */
+bool barramento_deve_encaminhar(int fd);
+
+/**
+ * @brief Prioridade padrão de um escravo MODBUS (câmeras antes do placar)
+ */
+BarramentoPrioridade barramento_prioridade_endereco(uint8_t slave_addr);
+
+/**
+ * @brief Define a prioridade de um escravo (câmeras das faixas extras do térreo)
+ * @note Chamar antes de submeter pedidos ao escravo
+ */
+void barramento_definir_prioridade(uint8_t slave_addr, BarramentoPrioridade prioridade);
+
+/**
+ * @brief Preenche um pedido com prioridade e deadline padrão do escravo
+ */
+void barramento_preparar_pedido(BarramentoPedido *pedido, uint8_t *request, int req_len,
+                                uint8_t *response, int resp_len, const char *rotulo);
+
+/**
+ * @brief Coloca o pedido na fila sem bloquear
+ *
+ * O pedido (e seus buffers) deve continuar válido até concluido == true
+ * ou até o callback ser chamado.
+ *
+ * @return true se entrou na fila, false se a fila está cheia ou inativa
+ */
+bool barramento_submeter(BarramentoPedido *pedido);
+
+/**
+ * @brief Bloqueia até o pedido ser concluído (futuro)
+ * @return true se a transação teve sucesso
+ */
+bool barramento_aguardar(BarramentoPedido *pedido);
+
+/**
+ * @brief Submete e aguarda o pedido
+ * @return true se a transação teve sucesso
+ */
+bool barramento_executar(BarramentoPedido *pedido);
+
+/**
+ * @brief Copia as estatísticas acumuladas do barramento
+ */
+void barramento_obter_estatisticas(BarramentoEstatisticas *out);
+
+/**
+ * @brief Imprime ocupação do barramento e folga disponível
+ */
+void barramento_imprimir_estatisticas();
+
+#endif // BARRAMENTO_H
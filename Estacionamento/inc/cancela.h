@@ -0,0 +1,235 @@
+#ifndef CANCELA_H
+#define CANCELA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "hal_gpio.h"
+#include "histograma.h"
+
+// Controlador de uma cancela (sensor de abertura antes da cancela, sensor de
+// fechamento depois dela, motor). Máquina de estados explícita, avançada pelas
+// bordas dos sensores (hal_gpio_eventos_*) e por prazos, sem dormir no meio de um carro:
+//
+//   ociosa    ──chegada/comando──▶  lendo      (ticket, placa, autorização)
+//   lendo     ──autorizado──────▶  abrindo    (motor ligado)
+//   lendo     ──carro foi embora─▶  ociosa     (recusado; reconsulta a cada CANCELA_ESPERA_MS)
+//   abrindo   ──tempos.abertura──▶  aberta
+//   aberta    ──sensor de fechamento▶ passando
+//   aberta    ──timeout_aberta───▶  fechando   (ninguém passou) ou falha (carro parado na frente)
+//   passando  ──fechamento livre─▶  fechando   (carro passou; fila vazia)
+//   passando  ──fechamento livre─▶  aberta     (carro passou; o próximo já foi autorizado)
+//   passando  ──timeout_passagem─▶  falha      (sensor preso ou carro parado sob a cancela)
+//   fechando  ──tempos.fechamento▶  ociosa     (volta a abrir se um carro entrar embaixo)
+//   falha     ──sensores livres──▶  fechando   (carro passou pelo sensor de fechamento)
+//   falha     ──sensores livres──▶  aberta     (carro deixou a abertura sem chegar ao fechamento)
+//
+// Na falha o motor continua ligado: a cancela nunca desce sobre um carro. Um
+// comando manual (Central) entra como uma chegada; se o carro não aciona o
+// sensor de abertura, a passagem é dada como feita em tempos.passagem_manual.
+//
+// Faixa em pipeline: cada carro que chega ao sensor de abertura entra numa fila
+// (VeiculoCancela) e é consultado na hora, mesmo com o carro anterior ainda
+// passando. A leitura da placa do próximo corre durante a passagem do anterior,
+// e, se ele já estiver autorizado quando o anterior deixa o sensor de
+// fechamento, a cancela fica em cima em vez de descer e subir de novo.
+//
+// O nó recebe avisos por callback (chegada, liberada, passou, fechando) com o
+// veículo, cujo id (ticket, evento de saída) o nó preenche na chegada. Estado,
+// vazão e tempos de cada fase (histogramas) podem ser lidos de qualquer thread.
+//
+// Várias faixas: as cancelas rodam num pool pequeno de trabalhadores, cada um
+// com uma assinatura das bordas de até CANCELA_POR_TRABALHADOR cancelas. O
+// trabalhador dorme até a primeira borda, prazo ou comando de qualquer uma delas;
+// como nada nas cancelas bloqueia, quatro faixas por direção cabem em duas threads.
+
+// Padrões dos tempos; CANCELA_ABERTURA_MS, CANCELA_FECHAMENTO_MS, CANCELA_TIMEOUT_ABERTURA
+// e CANCELA_TIMEOUT_PASSAGEM no ambiente (config.env) os substituem (cancela_tempos_do_ambiente)
+#define CANCELA_ABERTURA_MS             1000    // Motor ligado até a cancela ficar em cima
+#define CANCELA_FECHAMENTO_MS           1000    // Motor desligado até a cancela ficar embaixo
+#define CANCELA_TIMEOUT_ABERTURA_S      10      // Cancela aberta sem carro passando
+#define CANCELA_TIMEOUT_PASSAGEM_S      30      // Carro sobre o sensor de fechamento
+#define CANCELA_PASSAGEM_MANUAL_MS      2000    // Passagem presumida num comando manual sem sensor
+#define CANCELA_ESPERA_MS               1000    // Espera máxima sem borda nem prazo
+#define CANCELA_MAX_FILA                4       // Carros entre o sensor de abertura e o de fechamento
+#define CANCELA_HIST_BASE_US            10000   // Primeira faixa dos histogramas das fases
+#define CANCELA_POR_TRABALHADOR         (HAL_GPIO_MAX_PINOS_EVENTOS / 2)    // Dois sensores por cancela
+
+// Trabalhadores para n cancelas
+#define CANCELA_TRABALHADORES(n)        (((n) + CANCELA_POR_TRABALHADOR - 1) / CANCELA_POR_TRABALHADOR)
+
+typedef enum {
+    CANCELA_OCIOSA,
+    CANCELA_LENDO,
+    CANCELA_ABRINDO,
+    CANCELA_ABERTA,
+    CANCELA_PASSANDO,
+    CANCELA_FECHANDO,
+    CANCELA_FALHA,
+    CANCELA_NUM_ESTADOS
+} EstadoCancela;
+
+// Avisos ao nó
+typedef enum {
+    CANCELA_AVISO_CHEGADA,              // Retorno true autoriza a abertura
+    CANCELA_AVISO_LIBERADA,             // Cancela abrindo (ou mantida aberta) para o veículo
+    CANCELA_AVISO_PASSOU,
+    CANCELA_AVISO_FECHANDO              // Sem veículo
+} AvisoCancela;
+
+// Tempos e timeouts de uma cancela (ms)
+typedef struct {
+    unsigned int abertura_ms;
+    unsigned int fechamento_ms;
+    unsigned int timeout_aberta_ms;
+    unsigned int timeout_passagem_ms;
+    unsigned int passagem_manual_ms;
+} TemposCancela;
+
+#define TEMPOS_CANCELA_PADRAO { CANCELA_ABERTURA_MS, CANCELA_FECHAMENTO_MS,            \
+                                CANCELA_TIMEOUT_ABERTURA_S * 1000,                     \
+                                CANCELA_TIMEOUT_PASSAGEM_S * 1000, CANCELA_PASSAGEM_MANUAL_MS }
+
+// Fiação de uma cancela
+typedef struct {
+    const char *nome;
+    uint8_t sensor_abertura;
+    uint8_t sensor_fechamento;
+    uint8_t motor;
+    TemposCancela tempos;
+} CancelaConfig;
+
+// Veículo na faixa, da chegada ao sensor de abertura até deixar o de fechamento
+typedef struct {
+    int id;                             // Preenchido pelo nó na chegada (ticket, evento de saída)
+    bool manual;                        // Comando do Central
+    bool visto;                         // Passou pelo sensor de abertura
+    bool autorizado;
+    bool recusado;                      // Já recusado uma vez
+    double chegada_ms;
+    double consulta_ms;                 // Última consulta ao nó
+} VeiculoCancela;
+
+typedef struct Cancela Cancela;
+
+/**
+ * @brief Aviso de uma cancela ao nó (chamado na thread da cancela)
+ * @param v Veículo do aviso (NULL em CANCELA_AVISO_FECHANDO)
+ * @return Só em CANCELA_AVISO_CHEGADA: true para abrir
+ */
+typedef bool (*CancelaCallback)(Cancela *c, AvisoCancela aviso, VeiculoCancela *v);
+
+// Contadores e tempos das fases
+typedef struct {
+    EstadoCancela estado;
+    unsigned long chegadas;             // Carros no sensor de abertura e comandos
+    unsigned long carros;               // Passagens concluídas
+    unsigned long recusas;
+    unsigned long desistencias;         // Recusados que foram embora
+    unsigned long timeouts;             // Cancela aberta sem ninguém passar
+    unsigned long falhas;
+    unsigned long descartados;          // Fila cheia
+    unsigned long seguidos;             // Passagens sem a cancela descer para o próximo
+    int fila;                           // Veículos na faixa agora
+    int fila_max;
+    Histograma fases[CANCELA_NUM_ESTADOS];  // Tempo em cada estado por visita
+    Histograma atendimento;             // Chegada do veículo até a passagem
+    Histograma intervalo;               // Entre passagens consecutivas
+} CancelaEstatisticas;
+
+// Thread do pool e as cancelas que ela avança
+typedef struct {
+    Cancela *cancelas[CANCELA_POR_TRABALHADOR];
+    int num_cancelas;
+    HalGpioEventos *eventos;            // Bordas de todas as suas cancelas
+    pthread_t thread;
+} TrabalhadorCancelas;
+
+struct Cancela {
+    const CancelaConfig *cfg;
+    CancelaCallback callback;
+    EstadoCancela estado;
+    double desde_ms;                    // Entrada no estado atual
+    VeiculoCancela fila[CANCELA_MAX_FILA];  // fila[0] é o próximo a passar
+    int num_fila;
+    EstadoCancela falha_origem;         // Estado que levou à falha (passando se o carro chegou
+                                        // ao sensor de fechamento durante ela)
+    double ultima_passagem_ms;
+    uint8_t abertura, fechamento;       // Últimos níveis dos sensores
+    HalGpioEventos *eventos;            // Assinatura do trabalhador (compartilhada)
+    double relatorio_ms;                // Último relatório (vazão do período)
+    unsigned long relatorio_carros;
+
+    pthread_mutex_t mutex;              // Comando e estatísticas
+    bool comando;                       // Comando manual pendente
+    CancelaEstatisticas estatisticas;
+};
+
+/**
+ * @brief Substitui os tempos pelos definidos no ambiente (config.env)
+ * @note Variáveis ausentes ou inválidas mantêm o valor recebido
+ */
+void cancela_tempos_do_ambiente(TemposCancela *t);
+
+/**
+ * @brief Prepara a cancela (motor desligado)
+ * @note Chamar depois de hal_gpio_init e da configuração dos pinos; as bordas
+ *       são assinadas por cancela_iniciar_trabalhadores
+ */
+void cancela_init(Cancela *c, const CancelaConfig *cfg, CancelaCallback callback);
+
+/**
+ * @brief Processa uma borda de um dos sensores da cancela
+ * @return false se o pino não é desta cancela
+ */
+bool cancela_borda(Cancela *c, const HalGpioEvento *e);
+
+/**
+ * @brief Avança os prazos e atende o comando manual pendente
+ * @return Tempo até o próximo prazo (ms)
+ */
+unsigned int cancela_avancar(Cancela *c, double agora_ms);
+
+/**
+ * @brief Bordas a partir de uma leitura (backend sem eventos)
+ * @param niveis Retrato do GPIO (hal_gpio_lev_todos)
+ * @return Número de bordas (até duas), carimbadas com o relógio atual
+ */
+int cancela_bordas_da_leitura(const Cancela *c, uint32_t niveis, HalGpioEvento bordas[2]);
+
+/**
+ * @brief Distribui as cancelas entre os trabalhadores e inicia suas threads
+ * @param cancelas Cancelas já preparadas por cancela_init
+ * @param trabalhadores Espaço para CANCELA_TRABALHADORES(num_cancelas) trabalhadores
+ * @return Número de trabalhadores iniciados
+ * @note As faixas são intercaladas (cancela i no trabalhador i % n), espalhando
+ *       entradas e saídas vizinhas por threads diferentes
+ */
+int cancela_iniciar_trabalhadores(Cancela *cancelas, int num_cancelas, TrabalhadorCancelas *trabalhadores);
+
+/**
+ * @brief Estado atual (qualquer thread; ex: escolher a faixa de um comando manual)
+ */
+EstadoCancela cancela_estado(Cancela *c);
+
+/**
+ * @brief Pede a abertura manual (qualquer thread)
+ */
+void cancela_comandar(Cancela *c);
+
+/**
+ * @brief Copia estado e estatísticas (qualquer thread)
+ */
+void cancela_estatisticas_obter(Cancela *c, CancelaEstatisticas *out);
+
+/**
+ * @brief Imprime estado, vazão (carros/min desde o último relatório), contadores e tempos das fases
+ */
+void cancela_imprimir_estatisticas(Cancela *c);
+
+/**
+ * @brief Nome de um estado para o log
+ */
+const char *cancela_nome_estado(EstadoCancela estado);
+
+#endif // CANCELA_H
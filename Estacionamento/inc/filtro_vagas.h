@@ -0,0 +1,94 @@
+#ifndef FILTRO_VAGAS_H
+#define FILTRO_VAGAS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "varredura.h"
+
+// Filtro das leituras dos sensores de vaga. Uma leitura isolada errada (ruído,
+// pessoa passando na frente do sensor) não pode virar entrada ou cobrança: a
+// vaga só muda de estado quando as leituras confirmam a mudança e o estado
+// anterior já durou o tempo mínimo de permanência. Dois modos:
+//
+//   N de M      muda quando N das últimas M leituras discordam do estado atual
+//   integrador  contador que sobe com "ocupada" e desce com "livre"; a vaga só
+//               fica ocupada no máximo e só fica livre no zero (histerese)
+//
+// O estado de cada vaga cabe em um byte (histórico ou contador) mais o instante
+// da última mudança. Uma varredura sem novidade custa um XOR e um teste: só as
+// vagas com leitura divergente ou confirmação pendente são visitadas.
+
+#define FILTRO_JANELA               4       // M: leituras consideradas (até 8)
+#define FILTRO_CONFIRMACOES         3       // N: leituras que confirmam a mudança
+#define FILTRO_INTEGRADOR_MAX       3       // Passos do integrador entre livre e ocupada
+#define FILTRO_PERMANENCIA_MS       1000    // Tempo mínimo em um estado antes de mudar
+
+typedef enum {
+    FILTRO_N_DE_M      = 0,
+    FILTRO_INTEGRADOR  = 1
+} FiltroModo;
+
+// Configuração do filtro de um andar
+typedef struct {
+    FiltroModo modo;
+    uint8_t janela;                 // M (modo N de M)
+    uint8_t confirmacoes;           // N (modo N de M)
+    uint8_t integrador_max;         // Modo integrador
+    unsigned int permanencia_ms;
+} FiltroVagasConfig;
+
+#define FILTRO_VAGAS_PADRAO { FILTRO_N_DE_M, FILTRO_JANELA, FILTRO_CONFIRMACOES, \
+                              FILTRO_INTEGRADOR_MAX, FILTRO_PERMANENCIA_MS }
+
+// Estado do filtro de um andar
+typedef struct {
+    FiltroVagasConfig cfg;
+    MapaVagas todas;                                // Vagas que existem no andar
+    MapaVagas estavel;                              // Saída do filtro
+    MapaVagas pendentes;                            // Vagas com histórico divergente
+    MapaVagas origem;                               // Estado de cada vaga quando a divergência começou
+    uint8_t amostras[VARREDURA_MAX_VAGAS];          // Histórico (bit 0 = última) ou contador
+    uint32_t mudanca_ms[VARREDURA_MAX_VAGAS];       // Última mudança de estado
+    uint32_t divergencia_ms[VARREDURA_MAX_VAGAS];   // Primeira leitura da divergência atual (ou da última)
+    unsigned long mudancas;                         // Mudanças entregues
+    unsigned long rejeitadas;                       // Divergências descartadas como ruído
+} FiltroVagas;
+
+/**
+ * @brief Substitui a configuração pela definida no ambiente (config.env)
+ * @note Variáveis ausentes ou inválidas mantêm o valor recebido; uma combinação
+ *       inválida (ex.: N <= M/2) descarta as variáveis e mantém a configuração toda
+ */
+void filtro_vagas_config_do_ambiente(FiltroVagasConfig *cfg);
+
+/**
+ * @brief Prepara o filtro com todas as vagas livres
+ * @return false se a configuração for inválida
+ */
+bool filtro_vagas_init(FiltroVagas *f, const FiltroVagasConfig *cfg, int num_vagas);
+
+/**
+ * @brief Passa uma varredura pelo filtro
+ * @param lidas Mapa lido dos sensores
+ * @param agora_ms Instante da varredura (relogio_agora_ms)
+ * @return Mapa filtrado das vagas ocupadas
+ */
+MapaVagas filtro_vagas_aplicar(FiltroVagas *f, MapaVagas lidas, double agora_ms);
+
+/**
+ * @brief Instante em ms truncado para 32 bits (as diferenças toleram a volta)
+ * @note A conversão passa por 64 bits: double → uint32_t é indefinida acima de 2^32
+ */
+static inline uint32_t filtro_vagas_instante(double agora_ms) {
+    return (uint32_t)(uint64_t)agora_ms;
+}
+
+/**
+ * @brief Tempo desde a primeira leitura que levou à última mudança da vaga
+ * @param agora_ms Instante atual (relogio_agora_ms)
+ */
+static inline uint32_t filtro_vagas_atraso_ms(const FiltroVagas *f, int vaga, double agora_ms) {
+    return filtro_vagas_instante(agora_ms) - f->divergencia_ms[vaga];
+}
+
+#endif // FILTRO_VAGAS_H
@@ -0,0 +1,160 @@
+#ifndef HAL_GPIO_H
+#define HAL_GPIO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Camada de abstração do GPIO usada por todos os nós (térreo, andares e central).
+// Dois backends, escolhidos na compilação:
+//   - src/hal_gpio_bcm2835.c: Raspberry Pi real (biblioteca bcm2835)
+//   - src/hal_gpio_sim.c:     placa simulada em processo (make SIMULADO=1),
+//                             ver hal_gpio_sim.h
+// Os pinos usam a numeração BCM do GPIO.
+//
+// Acesso em lote: hal_gpio_write_mask muda vários pinos de saída num só acesso
+// aos registradores (endereços do multiplexador) e hal_gpio_lev_todos devolve o
+// nível dos GPIO 0 a 31 num só retrato do GPLEV0, para que os sensores lidos
+// juntos (ex: os dois sensores de passagem) venham do mesmo instante.
+//
+// Eventos de borda: no Raspberry Pi vêm do GPIO character device do kernel
+// (/dev/gpiochipN, API v2) com carimbo de tempo do kernel; na placa simulada, das
+// mudanças de nível geradas pela simulação. Uma thread espera as bordas dos seus
+// pinos em vez de ler os níveis em intervalos fixos.
+
+#ifndef HIGH
+#define HIGH 0x1
+#endif
+#ifndef LOW
+#define LOW  0x0
+#endif
+
+// Direção do pino
+typedef enum {
+    HAL_GPIO_ENTRADA = 0,
+    HAL_GPIO_SAIDA   = 1
+} HalGpioModo;
+
+// Bit de um pino nas palavras de hal_gpio_write_mask e hal_gpio_lev_todos
+#define HAL_GPIO_BIT(pino)              ((uint32_t)1 << (pino))
+// Nível de um pino num retrato de hal_gpio_lev_todos (HIGH ou LOW)
+#define HAL_GPIO_NIVEL(niveis, pino)    (((niveis) >> (pino)) & 1)
+
+// Resistor interno
+typedef enum {
+    HAL_PUD_OFF  = 0,
+    HAL_PUD_DOWN = 1,
+    HAL_PUD_UP   = 2
+} HalGpioPud;
+
+// Chip do GPIO character device (Raspberry Pi 5: /dev/gpiochip4)
+#define HAL_GPIO_CHIP                   "/dev/gpiochip0"
+#define HAL_GPIO_MAX_PINOS_EVENTOS      8
+// Sem eventos (chip indisponível): a espera vira uma leitura periódica
+#define HAL_GPIO_ESPERA_SEM_EVENTOS_MS  50
+
+// Bordas que geram eventos
+typedef enum {
+    HAL_BORDA_SUBIDA  = 1,
+    HAL_BORDA_DESCIDA = 2,
+    HAL_BORDA_AMBAS   = 3
+} HalGpioBorda;
+
+// Evento de borda
+typedef struct {
+    uint8_t pino;
+    uint8_t nivel;                  // Nível depois da borda (HIGH = subida)
+    uint64_t instante_ns;           // Carimbo de tempo (monotônico) da borda
+} HalGpioEvento;
+
+// Assinatura de eventos de um grupo de pinos (uma por thread)
+typedef struct HalGpioEventos HalGpioEventos;
+
+// Placa que o processo controla (define a fiação da placa simulada)
+typedef enum {
+    HAL_PLACA_TERREO  = 0,
+    HAL_PLACA_ANDAR1  = 1,
+    HAL_PLACA_ANDAR2  = 2,
+    HAL_PLACA_CENTRAL = 3
+} HalPlaca;
+
+/**
+ * @brief Inicializa o GPIO
+ * @param placa Nó que está rodando (o backend real ignora)
+ * @return true se sucesso, false se erro
+ */
+bool hal_gpio_init(HalPlaca placa);
+
+/**
+ * @brief Libera o GPIO
+ */
+void hal_gpio_close();
+
+/**
+ * @brief Define a direção do pino
+ */
+void hal_gpio_fsel(uint8_t pino, HalGpioModo modo);
+
+/**
+ * @brief Configura o resistor interno do pino
+ */
+void hal_gpio_set_pud(uint8_t pino, HalGpioPud pud);
+
+/**
+ * @brief Lê o nível do pino (HIGH ou LOW)
+ */
+uint8_t hal_gpio_lev(uint8_t pino);
+
+/**
+ * @brief Escreve o nível do pino (HIGH ou LOW)
+ */
+void hal_gpio_write(uint8_t pino, uint8_t nivel);
+
+/**
+ * @brief Lê num só acesso o nível dos GPIO 0 a 31
+ * @return Bit n = nível do GPIO n (ler com HAL_GPIO_NIVEL)
+ */
+uint32_t hal_gpio_lev_todos();
+
+/**
+ * @brief Escreve num só acesso os pinos de saída da máscara (GPIO 0 a 31)
+ * @param valores Bit n = nível do GPIO n
+ * @param mascara Bit n = o GPIO n é escrito (os demais não mudam)
+ */
+void hal_gpio_write_mask(uint32_t valores, uint32_t mascara);
+
+/**
+ * @brief Passa a receber eventos de borda dos pinos (já configurados como entrada)
+ * @param num_pinos Até HAL_GPIO_MAX_PINOS_EVENTOS
+ * @return Assinatura, ou NULL se o backend não tiver eventos (a espera vira leitura periódica)
+ */
+HalGpioEventos *hal_gpio_eventos_abrir(const uint8_t *pinos, int num_pinos, HalGpioBorda borda);
+
+/**
+ * @brief Espera o próximo evento de borda
+ * @param eventos Assinatura (NULL dorme HAL_GPIO_ESPERA_SEM_EVENTOS_MS e volta 0)
+ * @param timeout_ms Tempo máximo de espera
+ * @return 1 se recebeu um evento, 0 se o tempo acabou ou foi acordada, -1 em erro
+ */
+int hal_gpio_eventos_esperar(HalGpioEventos *eventos, HalGpioEvento *evento, int timeout_ms);
+
+/**
+ * @brief Acorda a thread que espera na assinatura (ex: comando manual do Central)
+ */
+void hal_gpio_eventos_acordar(HalGpioEventos *eventos);
+
+/**
+ * @brief Cancela a assinatura
+ */
+void hal_gpio_eventos_fechar(HalGpioEventos *eventos);
+
+/**
+ * @brief Aguarda o tempo dado em milissegundos
+ */
+void hal_delay(unsigned int ms);
+
+/**
+ * @brief Aguarda o tempo dado em microssegundos (acomodação de multiplexadores)
+ */
+void hal_delay_us(unsigned int us);
+
+#endif // HAL_GPIO_H
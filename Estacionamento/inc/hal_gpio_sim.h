@@ -0,0 +1,141 @@
+#ifndef HAL_GPIO_SIM_H
+#define HAL_GPIO_SIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Placa simulada (backend do hal_gpio.h quando compilado com make SIMULADO=1).
+// Modela a fiação de cada nó:
+//   - multiplexadores de endereço das vagas (o sensor de vaga devolve o estado
+//     da vaga selecionada pelos pinos de endereço). Depois de uma troca de
+//     endereço, a saída oscila por HAL_SIM_ACOMODACAO_US antes de estabilizar
+//     (a variável de ambiente HAL_SIM_ACOMODACAO_US simula uma placa mais lenta).
+//     Além do multiplexador da fiação, hal_sim_adicionar_mux monta outros
+//     grupos (andares de até 64 vagas) sem hardware
+//   - cancelas do térreo: um carro simulado aciona o sensor de abertura, espera
+//     o motor abrir, atravessa e aciona o sensor de fechamento. A fiação tem uma
+//     faixa de entrada e uma de saída; hal_sim_adicionar_cancela monta as
+//     faixas extras de sites maiores
+//   - sensores de passagem entre andares
+//   - eventos de borda dos pinos de entrada (hal_gpio_eventos_*), com o
+//     carimbo de tempo do relógio da simulação
+//
+// Pode ser comandada pelas funções abaixo (testes e benchmarks no mesmo
+// processo) ou por um roteiro em arquivo, carregado em hal_gpio_init quando
+// a variável de ambiente HAL_SIM_ROTEIRO aponta para ele. Formato do roteiro,
+// um comando por linha (instante em ms desde o carregamento, '#' comenta):
+//
+//   0     vaga 0 2 1          # andar (0=térreo) vaga ocupada(1)/livre(0)
+//   500   entrada             # carro chega na cancela de entrada
+//   800   entrada 2           # ... na 3ª faixa de entrada (0 = a da fiação)
+//   4000  saida               # carro chega na cancela de saída (faixa opcional)
+//   6000  passagem 1 sobe     # sensores de passagem do 1º andar (sobe|desce)
+//   7000  nivel 7 1           # força o nível de um pino de entrada
+
+#define HAL_SIM_NUM_PINOS           54
+#define HAL_SIM_NUM_ANDARES         3
+#define HAL_SIM_MAX_VAGAS           64
+#define HAL_SIM_MAX_MUX             8       // Multiplexadores de vagas por placa
+#define HAL_SIM_MAX_ENDERECOS       6       // Bits de endereço por multiplexador
+#define HAL_SIM_MAX_EVENTOS         256
+#define HAL_SIM_MAX_ASSINATURAS     8       // Assinaturas de eventos de borda
+#define HAL_SIM_MAX_CANCELAS        8       // Faixas (cancelas) por placa
+#define HAL_SIM_FILA_BORDAS         64      // Bordas pendentes por assinatura
+#define HAL_SIM_TICK_MAX_MS         50      // Maior intervalo entre passos da simulação
+
+// Multiplexador simulado
+#define HAL_SIM_ACOMODACAO_US       40      // Tempo até a saída estabilizar após trocar o endereço
+#define HAL_SIM_OSCILACAO_US        3       // Meio período da oscilação durante a acomodação
+
+// Comportamento do carro simulado
+#define HAL_SIM_TRAVESSIA_MS        1500    // Cancela aberta → carro aciona o sensor de fechamento
+#define HAL_SIM_PULSO_SENSOR_MS     300     // Tempo que o carro fica sobre um sensor
+#define HAL_SIM_INTERVALO_PASSAGEM_MS 200   // Defasagem entre os dois sensores de passagem
+
+// Contadores de acesso ao GPIO (base para benchmarks das varreduras)
+typedef struct {
+    unsigned long leituras;             // Acessos de leitura (hal_gpio_lev e hal_gpio_lev_todos)
+    unsigned long escritas;             // Acessos de escrita (hal_gpio_write e hal_gpio_write_mask)
+    unsigned long trocas_endereco;      // Pinos de endereço que mudaram de nível
+    unsigned long eventos_borda;        // Bordas entregues às assinaturas de eventos
+    unsigned long carros_entrada;       // Carros que passaram pelas cancelas de entrada
+    unsigned long carros_saida;         // Carros que passaram pelas cancelas de saída
+} HalSimEstatisticas;
+
+/**
+ * @brief Ocupa ou libera uma vaga
+ * @param andar 0 = térreo, 1 = 1º andar, 2 = 2º andar
+ * @param vaga Índice da vaga (0 a HAL_SIM_MAX_VAGAS-1)
+ */
+void hal_sim_vaga(int andar, int vaga, bool ocupada);
+
+/**
+ * @brief Monta mais um multiplexador de vagas na placa do nó (depois de hal_gpio_init)
+ * @param enderecos Pinos de endereço, bit 0 primeiro (podem ser os de outro multiplexador)
+ * @param sensor Pino da saída do multiplexador
+ * @param primeira_vaga Vaga do andar selecionada pelo endereço 0
+ * @return false se os parâmetros forem inválidos ou não couber mais um multiplexador
+ */
+bool hal_sim_adicionar_mux(const uint8_t *enderecos, int num_enderecos, uint8_t sensor, int primeira_vaga);
+
+/**
+ * @brief Estado simulado de uma vaga
+ */
+bool hal_sim_vaga_ocupada(int andar, int vaga);
+
+/**
+ * @brief Monta mais uma cancela (faixa) na placa do nó (depois de hal_gpio_init)
+ * @param entrada true = faixa de entrada; a primeira montada é a faixa 1 da direção
+ * @return false se os pinos forem inválidos ou não couber mais uma cancela
+ */
+bool hal_sim_adicionar_cancela(uint8_t abertura, uint8_t fechamento, uint8_t motor, bool entrada);
+
+/**
+ * @brief Coloca um carro na fila de uma faixa
+ * @param faixa Ordem da faixa na direção (0 = a da fiação)
+ */
+void hal_sim_carro_faixa(bool entrada, int faixa);
+
+/**
+ * @brief Coloca um carro na fila da cancela de entrada
+ */
+void hal_sim_carro_entrada();
+
+/**
+ * @brief Coloca um carro na fila da cancela de saída
+ */
+void hal_sim_carro_saida();
+
+/**
+ * @brief Gera a sequência dos sensores de passagem de um andar
+ * @param sobe true = sensor 1 → sensor 2 (subindo), false = descendo
+ */
+void hal_sim_passagem(int andar, bool sobe);
+
+/**
+ * @brief Nível atual de um pino (inclui as saídas escritas pelo nó)
+ */
+uint8_t hal_sim_nivel(uint8_t pino);
+
+/**
+ * @brief Força o nível de um pino de entrada
+ */
+void hal_sim_definir_nivel(uint8_t pino, uint8_t nivel);
+
+/**
+ * @brief Carrega um roteiro de eventos (formato no topo deste arquivo)
+ * @return true se o arquivo foi lido sem erros
+ */
+bool hal_sim_carregar_roteiro(const char *arquivo);
+
+/**
+ * @brief Indica se todos os eventos agendados e carros simulados terminaram
+ */
+bool hal_sim_ocioso();
+
+/**
+ * @brief Copia os contadores de acesso ao GPIO
+ */
+void hal_sim_obter_estatisticas(HalSimEstatisticas *out);
+
+#endif // HAL_GPIO_SIM_H
@@ -0,0 +1,61 @@
+#ifndef HISTOGRAMA_H
+#define HISTOGRAMA_H
+
+#include <stdint.h>
+
+// Histograma de latências com faixas em progressão geométrica:
+// faixa i conta valores < base_us * 2^i; a última faixa é aberta.
+#define HISTOGRAMA_FAIXAS 16
+
+typedef struct {
+    double base_us;                         // Limite superior da primeira faixa
+    unsigned long contagem[HISTOGRAMA_FAIXAS];
+    unsigned long total;
+    double soma_us;
+    double max_us;
+} Histograma;
+
+/**
+ * @brief Zera o histograma
+ * @param base_us Limite superior da primeira faixa (ex: 250 para latências MODBUS)
+ */
+void histograma_init(Histograma *h, double base_us);
+
+/**
+ * @brief Registra uma amostra
+ * @param valor_us Valor em microssegundos
+ */
+void histograma_registrar(Histograma *h, double valor_us);
+
+/**
+ * @brief Limite superior (us) da faixa i
+ */
+double histograma_limite_us(const Histograma *h, int faixa);
+
+/**
+ * @brief Estima um percentil pelo limite superior da faixa que o contém
+ * @param p Percentil entre 0 e 100
+ * @return valor em microssegundos (0 se vazio)
+ */
+double histograma_percentil(const Histograma *h, double p);
+
+/**
+ * @brief Estima um percentil interpolando linearmente dentro da faixa
+ * @param p Percentil entre 0 e 100
+ * @return valor em microssegundos (0 se vazio), nunca acima do máximo observado
+ */
+double histograma_quantil(const Histograma *h, double p);
+
+/**
+ * @brief Média das amostras em microssegundos (0 se vazio)
+ */
+double histograma_media(const Histograma *h);
+
+/**
+ * @brief Imprime resumo (n, média, p50, p95, máx) e as faixas não vazias
+ * @param prefixo Prefixo de log (ex: "[MODBUS]")
+ * @param nome Nome da métrica
+ */
+void histograma_imprimir(const char *prefixo, const char *nome, const Histograma *h);
+
+#endif // HISTOGRAMA_H
@@ -7,14 +7,45 @@
 // Limiar de confiança para aceitar placa (conforme especificação)
 #define LPR_CONFIANCA_LIMIAR  70
 
+// Capturas assíncronas aguardando cada câmera
+#define LPR_FILA_CAPTURAS     4
+#define LPR_FILA_ESPERA_MS    1000  // Espera da thread da câmera por captura, no relógio do nó
+
+// Resultado de uma captura assíncrona
+typedef struct {
+    int numeroCarro;            // Ticket ao qual o resultado pertence
+    uint8_t camera;             // Endereço MODBUS da câmera (faixa)
+    bool entrada;               // true = câmera de entrada, false = saída
+    bool sucesso;               // Placa lida (confiança pode estar abaixo do limiar)
+    char placa[9];
+    int confianca;
+    double latencia_ms;         // Disparo no sensor → resultado disponível
+} LPRResultado;
+
+/**
+ * @brief Callback chamado pela thread da câmera quando a captura termina
+ */
+typedef void (*LPRCallback)(const LPRResultado *resultado);
+
 // File descriptors globais para as câmeras LPR
 extern int lpr_entrada_fd;
 extern int lpr_saida_fd;
 
 /**
- * @brief Inicializa câmeras LPR
+ * @brief Registra a câmera de uma faixa do térreo
+ * @param endereco Endereço MODBUS da câmera
+ * @param entrada true = faixa de entrada, false = saída
+ * @return false se a tabela está cheia, o endereço já é de outra direção
+ *         ou as câmeras já foram inicializadas
+ * @note Chamar antes de lpr_init
+ */
+bool lpr_adicionar_camera(uint8_t endereco, bool entrada);
+
+/**
+ * @brief Inicializa câmeras LPR (uma thread de trabalho por câmera registrada)
  * @param porta_serial Porta serial MODBUS (ex: "/dev/serial0")
  * @return true se sucesso, false se erro
+ * @note Sem câmeras registradas, usa as padrão (0x11 entrada, 0x12 saída)
  */
 bool lpr_init(const char *porta_serial);
 
@@ -24,34 +55,38 @@ bool lpr_init(const char *porta_serial);
 void lpr_cleanup();
 
 /**
- * @brief Processa entrada de um carro com LPR
- * @param numeroCarro ID do carro que está entrando
- * @param placa_out Buffer para armazenar a placa lida (saída)
- * @param confianca_out Ponteiro para armazenar a confiança (saída)
- * @return true se placa foi lida, false se não foi possível ler
+ * @brief Agenda a captura de placa numa câmera registrada sem bloquear
+ * @param endereco Câmera da faixa
+ * @param numeroCarro Ticket (entrada) ou evento de saída ao qual o resultado pertence
+ * @param callback Chamado pela thread da câmera com o resultado
+ * @return true se a captura foi agendada; false se a câmera não está registrada,
+ *         está fora do ar ou com a fila cheia (o chamador segue com ticket temporário)
  * 
- * Fluxo (conforme especificação):
- * 1. Sensor detecta carro → dispara Trigger na câmera 0x11
- * 2. Faz polling no Status até 2=OK ou 3=Erro (timeout 2s)
- * 3. Se OK, lê Placa e Confiança
- * 4. Zera Trigger
- * 5. Retorna placa e confiança
+ * Fluxo na thread da câmera (conforme especificação):
+ * 1. Dispara Trigger (com 0x17, a mesma transação já lê o status)
+ * 2. Faz polling no Status até 2=OK ou 3=Erro (timeout 2s); cada consulta
+ *    lê também Placa e Confiança
+ * 3. Zera Trigger
+ * 4. Entrega placa e confiança ao callback
  */
-bool lpr_processar_entrada(int numeroCarro, char *placa_out, int *confianca_out);
+bool lpr_capturar_async(uint8_t endereco, int numeroCarro, LPRCallback callback);
 
 /**
- * @brief Processa saída de um carro com LPR
- * @param placa_out Buffer para armazenar a placa lida (saída)
- * @param confianca_out Ponteiro para armazenar a confiança (saída)
- * @return true se placa foi lida, false se não foi possível ler
- * 
- * Fluxo (conforme especificação):
- * 1. Sensor detecta carro → dispara Trigger na câmera 0x12
- * 2. Obtém Placa e confiança
- * 3. Zera Trigger
- * 4. Retorna placa e confiança
+ * @brief Agenda a captura de placa na câmera de entrada sem bloquear
+ * @param numeroCarro Ticket ao qual o resultado será anexado
+ * @param callback Chamado pela thread da câmera com o resultado
+ * @return true se a captura foi agendada; false se a câmera está fora do ar
+ *         ou com a fila cheia (o chamador segue com ticket temporário)
+ */
+bool lpr_capturar_entrada_async(int numeroCarro, LPRCallback callback);
+
+/**
+ * @brief Agenda a captura de placa na câmera de saída sem bloquear
+ * @param numeroCarro Identificador do evento de saída (só para log)
+ * @param callback Chamado pela thread da câmera com o resultado
+ * @return true se a captura foi agendada
  */
-bool lpr_processar_saida(char *placa_out, int *confianca_out);
+bool lpr_capturar_saida_async(int numeroCarro, LPRCallback callback);
 
 #endif // LPR_TERREO_H
 
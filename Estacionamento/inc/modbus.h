@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "histograma.h"
 
 // Endereços dos dispositivos MODBUS
 #define MODBUS_ADDR_LPR_ENTRADA  0x11
@@ -12,15 +13,29 @@
 // Funções MODBUS
 #define MODBUS_FUNC_READ_HOLDING   0x03
 #define MODBUS_FUNC_WRITE_MULTIPLE 0x10
+#define MODBUS_FUNC_READ_WRITE_MULTIPLE 0x17
 
 // Configurações de comunicação serial
 #define MODBUS_SERIAL_BAUD      115200
 #define MODBUS_SERIAL_PORT      "/dev/serial0"  // Ajustar: ttyUSB0, ttyAMA0, serial0
-#define MODBUS_TIMEOUT_MS       500
+#define MODBUS_TIMEOUT_MS       500     // Espera máxima pelo primeiro byte da resposta
 #define MODBUS_RETRIES          3
 #define MODBUS_MIN_DELAY_MS     100
 #define MODBUS_MEDIUM_DELAY_MS  250
 #define MODBUS_MAX_DELAY_MS     500
+#define MODBUS_ORCAMENTO_MIN_MS 50      // Menor espera pelo primeiro byte que ainda vale uma tentativa
+
+// Fim de quadro RTU: 3,5 caracteres de silêncio na linha.
+// Acima de 19200 bps a especificação MODBUS fixa esse intervalo em 1750 us.
+#define MODBUS_SILENCIO_T35_US  1750
+
+// Limites de registros por transação (cabem nos buffers de 256 bytes)
+#define MODBUS_MAX_REGS_LEITURA  125
+#define MODBUS_MAX_REGS_ESCRITA  123
+#define MODBUS_MAX_REGS_ESCRITA_RW  121     // Escrita dentro da função 0x17
+
+// Bloco de registros da câmera LPR: status, trigger, placa[4], confiança, erro
+#define LPR_NUM_REGS  8
 
 // ⚠️ IMPORTANTE: Matrícula inserida em todas as mensagens MODBUS
 // Conforme especificação: "É necessário enviar os 4 últimos dígitos da matrícula
@@ -74,8 +89,71 @@ typedef struct {
     uint16_t flags;                        // Offset 12: bit0=lotado geral, bit1=lotado 1º andar, bit2=lotado 2º andar
 } PlacarData;
 
+// Número de registros do placar (offsets 0 a 12)
+#define PLACAR_NUM_REGS             13
+
+// Atualização do placar por diferença
+#define PLACAR_JANELA_COALESCENCIA_MS  200  // Junta mudanças em rajada numa só escrita
+#define PLACAR_REFRESH_COMPLETO_S      60   // Reescrita completa periódica (ressincronização)
+#define PLACAR_GAP_MAXIMO              8    // Registros iguais que ainda compensa reescrever entre dois trechos
+#define PLACAR_VERIFICACAO_MS          100  // Período de comparação com o espelho
+
+// Espelho do conteúdo atual do placar (o que já foi confirmado pelo escravo)
+typedef struct {
+    uint16_t regs[PLACAR_NUM_REGS];
+    bool valido;                        // false até a primeira escrita completa ou após erro
+    unsigned long escritas_completas;
+    unsigned long escritas_parciais;
+} PlacarEspelho;
+
+// Primeira faixa dos histogramas de latência MODBUS (us)
+#define MODBUS_HIST_BASE_US  250
+
+// Saúde do barramento por escravo (ver modbus_estatisticas_obter)
+typedef struct {
+    unsigned long transacoes;           // Chamadas completas (com todas as tentativas)
+    unsigned long sucessos;
+    unsigned long falhas;
+    unsigned long retries;              // Tentativas além da primeira
+    unsigned long timeouts;             // Tentativas sem nenhum byte de resposta
+    unsigned long erros_crc;
+    unsigned long endereco_errado;      // Resposta de outro endereço/função
+    unsigned long quadros_invalidos;    // Truncados ou com tamanho inesperado
+    unsigned long excecoes;             // Respostas de exceção MODBUS
+    unsigned long interrompidas;        // Encerradas antes do fim por falta de orçamento
+    Histograma primeiro_byte;           // Requisição enviada → primeiro byte da resposta
+    Histograma transacao;               // Transação completa, incluindo retries
+} ModbusEstatisticas;
+
+// Disjuntor por escravo: após MODBUS_DISJUNTOR_FALHAS transações seguidas sem
+// resposta o dispositivo é dado como fora do ar e as chamadas falham na hora.
+// A thread do barramento sonda o dispositivo a cada MODBUS_DISJUNTOR_SONDAGEM_MS.
+// As variáveis de mesmo nome no ambiente (config.env) substituem os valores
+// abaixo na abertura da porta (modbus_init).
+#define MODBUS_DISJUNTOR_FALHAS        2
+#define MODBUS_DISJUNTOR_SONDAGEM_MS   5000
+
+// Orçamento de tempo de uma transação da thread do barramento: retorna quantos
+// milissegundos a transação ainda pode ocupar o fio (0 = parar agora). É
+// consultado antes de cada tentativa, de modo que pedidos que chegam durante
+// os retries também contam.
+typedef int (*ModbusOrcamento)(void);
+
+typedef enum {
+    MODBUS_SAUDE_FECHADO     = 0,   // Tráfego normal
+    MODBUS_SAUDE_ABERTO      = 1,   // Fora do ar: chamadas falham sem ir ao fio
+    MODBUS_SAUDE_MEIO_ABERTO = 2    // Sondagem em andamento
+} ModbusSaude;
+
 // Funções da biblioteca MODBUS
 
+/**
+ * @brief Porta serial a usar
+ * @return valor da variável de ambiente MODBUS_SERIAL_PORT, se definida
+ *         (ex: pty do emulador_modbus), senão MODBUS_SERIAL_PORT
+ */
+const char *modbus_porta_serial();
+
 /**
  * @brief Inicializa a comunicação MODBUS serial
  * @param porta Caminho da porta serial (ex: "/dev/serial0")
@@ -121,8 +199,108 @@ bool modbus_read_holding_registers(int fd, uint8_t slave_addr, uint16_t start_ad
 bool modbus_write_multiple_registers(int fd, uint8_t slave_addr, uint16_t start_addr,
                                      uint16_t num_regs, uint16_t *data);
 
+/**
+ * @brief Escreve e lê holding registers numa única transação (função 0x17)
+ * 
+ * A escrita é aplicada antes da leitura. Se o escravo responder com exceção
+ * de função ilegal, ele é marcado como sem suporte a 0x17
+ * (ver modbus_suporta_leitura_escrita).
+ * 
+ * @param read_start Endereço inicial da leitura
+ * @param read_regs Número de registros a ler
+ * @param output Buffer para armazenar os registros lidos
+ * @param write_start Endereço inicial da escrita
+ * @param write_regs Número de registros a escrever
+ * @param data Buffer com os dados a escrever
+ * @return true se sucesso, false se erro ou exceção
+ */
+bool modbus_read_write_multiple_registers(int fd, uint8_t slave_addr,
+                                          uint16_t read_start, uint16_t read_regs, uint16_t *output,
+                                          uint16_t write_start, uint16_t write_regs, uint16_t *data);
+
+/**
+ * @brief Indica se vale tentar a função 0x17 com o escravo
+ * @return false se o escravo já recusou a função com exceção
+ */
+bool modbus_suporta_leitura_escrita(uint8_t slave_addr);
+
+/**
+ * @brief Executa uma transação (requisição + resposta) diretamente na porta
+ * 
+ * Usada pela thread dona do barramento (barramento.c). As demais threads
+ * devem usar as funções de leitura/escrita acima, que encaminham o pedido
+ * ao árbitro quando ele está ativo.
+ * 
+ * @param fd File descriptor da porta serial
+ * @param request Quadro completo a enviar (já com matrícula e CRC)
+ * @param req_len Tamanho do quadro de requisição
+ * @param response Buffer da resposta
+ * @param resp_len Tamanho esperado da resposta de sucesso
+ * @param rotulo Prefixo usado nas mensagens de debug
+ * @param orcamento Limite de tempo consultado antes de cada tentativa (NULL = sem limite)
+ * @return true se recebeu resposta válida, false se erro
+ */
+bool modbus_transacao_direta(int fd, uint8_t *request, int req_len,
+                             uint8_t *response, int resp_len, const char *rotulo,
+                             ModbusOrcamento orcamento);
+
+/**
+ * @brief Copia as estatísticas de um escravo MODBUS
+ * @param slave_addr Endereço do escravo
+ * @param out Estrutura de saída
+ * @return true se houve tráfego para esse escravo, false caso contrário
+ */
+bool modbus_estatisticas_obter(uint8_t slave_addr, ModbusEstatisticas *out);
+
+/**
+ * @brief Zera as estatísticas de todos os escravos
+ */
+void modbus_estatisticas_zerar();
+
+/**
+ * @brief Imprime contadores e histogramas de latência de cada escravo
+ */
+void modbus_estatisticas_imprimir();
+
+/**
+ * @brief Indica se o escravo pode receber tráfego (disjuntor fechado)
+ */
+bool modbus_escravo_disponivel(uint8_t slave_addr);
+
+/**
+ * @brief Estado atual do disjuntor do escravo
+ */
+ModbusSaude modbus_saude_escravo(uint8_t slave_addr);
+
+/**
+ * @brief Sonda, com uma única tentativa, os escravos fora do ar cujo
+ *        intervalo de sondagem venceu
+ * @param orcamento Limite de tempo; as sondagens param quando ele se esgota
+ * @note Chamada pela thread dona do barramento
+ */
+void modbus_sondar_escravos(int fd, ModbusOrcamento orcamento);
+
 // ========== Funções específicas para LPR ==========
 
+// Polling adaptativo do status: cada câmera aprende seu tempo de processamento.
+// A primeira consulta sai perto da mediana e as seguintes seguem os percentis
+// 75/90/95/99; depois disso o intervalo dobra até LPR_POLL_MAX_MS.
+#define LPR_POLL_PADRAO_MS      100     // Intervalo fixo usado enquanto não há histórico
+#define LPR_POLL_MIN_MS         10      // Menor intervalo entre duas consultas
+#define LPR_POLL_MAX_MS         200     // Maior intervalo entre duas consultas
+#define LPR_POLL_AMOSTRAS_MIN   5       // Capturas observadas antes de adaptar
+#define LPR_HIST_BASE_US        2000    // Primeira faixa do histograma de processamento
+
+// Câmeras no barramento do térreo (uma por faixa; 4 entradas + 4 saídas)
+#define LPR_MAX_CAMERAS         8
+
+// Tempo de processamento observado numa câmera
+typedef struct {
+    Histograma processamento;           // Trigger → status OK/ERRO (us)
+    unsigned long capturas;
+    unsigned long consultas;            // Leituras de status feitas
+} LPRTempos;
+
 /**
  * @brief Dispara captura de placa na câmera LPR
  * @param fd File descriptor da porta serial
@@ -131,6 +309,18 @@ bool modbus_write_multiple_registers(int fd, uint8_t slave_addr, uint16_t start_
  */
 bool lpr_trigger_capture(int fd, uint8_t camera_addr);
 
+/**
+ * @brief Dispara a captura e lê o bloco de status/placa na mesma transação
+ * 
+ * Usa a função 0x17 (escreve trigger=1 e lê os 8 registros). Se a câmera
+ * não implementa 0x17, recai em lpr_trigger_capture e devolve status
+ * PROCESSANDO.
+ * 
+ * @param data Estado da câmera logo após o trigger
+ * @return true se o trigger foi aceito
+ */
+bool lpr_trigger_and_read(int fd, uint8_t camera_addr, LPRData *data);
+
 /**
  * @brief Lê dados da câmera LPR (status, placa, confiança)
  * @param fd File descriptor da porta serial
@@ -145,9 +335,26 @@ bool lpr_read_data(int fd, uint8_t camera_addr, LPRData *data);
  * @param fd File descriptor da porta serial
  * @param camera_addr Endereço da câmera
  * @param timeout_ms Timeout em milissegundos
+ * @param data Se não for NULL, cada consulta lê o bloco inteiro
+ *             (status + placa + confiança) e a última leitura fica aqui;
+ *             assim a consulta que vê OK já traz a placa
  * @return Status final (OK, ERRO ou TIMEOUT)
+ * 
+ * O instante das consultas segue o histórico de processamento da câmera
+ * (ver LPR_POLL_*); o tempo observado é registrado no histograma.
+ */
+LPRStatus lpr_wait_processing(int fd, uint8_t camera_addr, int timeout_ms, LPRData *data);
+
+/**
+ * @brief Copia o histograma de tempo de processamento de uma câmera
+ * @return true se a câmera já teve alguma captura observada
+ */
+bool lpr_obter_tempos(uint8_t camera_addr, LPRTempos *out);
+
+/**
+ * @brief Imprime o tempo de processamento e consultas por captura de cada câmera
  */
-LPRStatus lpr_wait_processing(int fd, uint8_t camera_addr, int timeout_ms);
+void lpr_imprimir_tempos();
 
 /**
  * @brief Zera o trigger da câmera (escreve 0 no offset 1)
@@ -167,6 +374,23 @@ bool lpr_reset_trigger(int fd, uint8_t camera_addr);
  */
 bool placar_update(int fd, PlacarData *data);
 
+/**
+ * @brief Converte a estrutura do placar na imagem dos registros (offsets 0-12)
+ * @param data Estrutura com os dados do placar
+ * @param registers Vetor de PLACAR_NUM_REGS registros (saída)
+ */
+void placar_para_registros(const PlacarData *data, uint16_t *registers);
+
+/**
+ * @brief Atualiza o placar escrevendo apenas os trechos alterados
+ * @param fd File descriptor da porta serial
+ * @param espelho Espelho do conteúdo atual do placar (atualizado em caso de sucesso)
+ * @param data Estrutura com os dados a escrever
+ * @param completo true para reescrever os 13 registros (ressincronização)
+ * @return true se sucesso (inclusive quando nada mudou), false se erro
+ */
+bool placar_update_delta(int fd, PlacarEspelho *espelho, PlacarData *data, bool completo);
+
 /**
  * @brief Lê os dados do placar MODBUS
  * @param fd File descriptor da porta serial
@@ -0,0 +1,142 @@
+#ifndef PASSAGEM_H
+#define PASSAGEM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "hal_gpio.h"
+
+// Detector de passagem numa rampa com dois sensores (sensor 1 do lado de baixo,
+// sensor 2 do lado de cima). Não bloqueia e não lê o GPIO: é alimentado com as
+// bordas carimbadas (hal_gpio_eventos_*), então a ordem e os intervalos vêm do
+// instante da interrupção e não de quando a thread acordou.
+//
+// Cada carro na rampa é uma travessia em curso, numa fila por ordem de chegada:
+//
+//   chegando      só o sensor de origem foi acionado
+//   atravessando  a frente do carro chegou ao sensor de destino
+//
+// A subida de um sensor primeiro completa a travessia mais antiga que vem do
+// outro lado; sem nenhuma, abre uma travessia nova (um segundo carro pode entrar
+// na rampa antes do primeiro sair). A descida do sensor de destino conclui a
+// travessia quando a traseira do carro já deixou a origem; se a origem ainda
+// está acionada, o carro recuou do destino e volta a "chegando". Uma travessia
+// que não conclui em PASSAGEM_TIMEOUT_S é abortada (carro desistiu e deu ré);
+// se já tinha chegado ao destino, conta assim mesmo (sensor preso).
+//
+// Cada passagem concluída traz a direção, o tempo de travessia (primeira borda
+// até o carro deixar o destino) e a velocidade estimada pelo tempo entre as
+// frentes nos dois sensores, separados por PASSAGEM_DISTANCIA_M.
+//
+// Um nó pode vigiar várias rampas (rampas separadas de subida e descida, rampas
+// expressas que pulam andares): cada uma é uma linha de RampaConfig com o seu
+// par de sensores e os andares que liga, e passagem_monitorar vigia todas numa
+// só thread, com uma assinatura de eventos para todos os sensores.
+
+#define PASSAGEM_MAX_EM_CURSO   8       // Carros na rampa ao mesmo tempo
+#define PASSAGEM_TIMEOUT_S      30      // Tempo máximo de uma travessia (PASSAGEM_TIMEOUT no ambiente)
+#define PASSAGEM_DISTANCIA_M    1.0     // Distância entre os dois sensores
+#define PASSAGEM_ESPERA_MS      1000    // Espera máxima por uma borda antes de checar as travessias
+#define PASSAGEM_MAX_RAMPAS     (HAL_GPIO_MAX_PINOS_EVENTOS / 2)
+#define PASSAGEM_NUM_ANDARES    3       // Térreo, 1º e 2º andar
+
+// Contadores de passagens publicados ao Central: índice de origem → destino
+#define PASSAGEM_INDICE(origem, destino)    ((origem) * PASSAGEM_NUM_ANDARES + (destino))
+#define PASSAGEM_NUM_CONTADORES             (PASSAGEM_NUM_ANDARES * PASSAGEM_NUM_ANDARES)
+
+// Direção (mesmos códigos publicados ao Central)
+typedef enum {
+    PASSAGEM_SOBE   = 1,                // Sensor 1 → sensor 2
+    PASSAGEM_DESCE  = 2                 // Sensor 2 → sensor 1
+} DirecaoPassagem;
+
+// Resultado de uma borda
+typedef enum {
+    PASSAGEM_NADA,
+    PASSAGEM_INICIO,                    // Carro novo entrou na rampa
+    PASSAGEM_CONCLUIDA                  // Passagem pronta em *out
+} ResultadoPassagem;
+
+// Rampa vigiada por um nó
+typedef struct {
+    const char *nome;
+    uint8_t sensor1;                    // Lado do andar de baixo
+    uint8_t sensor2;                    // Lado do andar de cima
+    int andar_baixo, andar_cima;        // 0 = térreo
+} RampaConfig;
+
+// Passagem concluída
+typedef struct {
+    DirecaoPassagem direcao;
+    int andar_origem, andar_destino;
+    double travessia_ms;                // Primeira borda até deixar o destino (0 = sensor preso)
+    double entre_sensores_ms;           // Frente do carro da origem ao destino
+    double velocidade_kmh;
+} Passagem;
+
+// Carro na rampa
+typedef struct {
+    int origem;                         // 0 = sensor 1, 1 = sensor 2
+    bool chegou;                        // Frente no sensor de destino
+    bool saiu_origem;                   // Traseira já deixou a origem
+    uint64_t inicio_ns;                 // Borda de subida na origem
+    uint64_t chegada_ns;                // Borda de subida no destino
+    double aberta_ms;                   // relogio_agora_ms ao abrir (timeout)
+} TravessiaEmCurso;
+
+// Detector de uma rampa
+typedef struct {
+    const RampaConfig *rampa;
+    uint8_t pinos[2];                   // Sensor 1, sensor 2
+    uint8_t niveis[2];                  // Último nível conhecido
+    double distancia_m;
+    unsigned int timeout_ms;
+    TravessiaEmCurso em_curso[PASSAGEM_MAX_EM_CURSO];
+    int num_em_curso;
+    unsigned long subidas, descidas;
+    unsigned long abortadas;            // Desistências (timeout antes do destino)
+    unsigned long descartadas;          // Fila cheia
+} DetectorPassagem;
+
+// Aviso de uma rampa: PASSAGEM_INICIO (p = NULL) ou PASSAGEM_CONCLUIDA
+typedef void (*PassagemCallback)(const RampaConfig *rampa, ResultadoPassagem resultado, const Passagem *p);
+
+/**
+ * @brief Prepara o detector de uma rampa com os níveis atuais dos sensores
+ */
+void passagem_init(DetectorPassagem *d, const RampaConfig *rampa, double distancia_m, unsigned int timeout_ms);
+
+/**
+ * @brief Processa uma borda de um dos sensores
+ * @param out Preenchida quando o retorno é PASSAGEM_CONCLUIDA
+ */
+ResultadoPassagem passagem_borda(DetectorPassagem *d, const HalGpioEvento *e, Passagem *out);
+
+/**
+ * @brief Encerra a travessia mais antiga vencida
+ * @param agora_ms relogio_agora_ms
+ * @return true se uma passagem (sensor preso no destino) foi concluída em *out;
+ *         chamar até voltar false
+ */
+bool passagem_expirar(DetectorPassagem *d, double agora_ms, Passagem *out);
+
+/**
+ * @brief Bordas a partir de uma leitura (backend sem eventos)
+ * @param niveis Retrato do GPIO (hal_gpio_lev_todos)
+ * @param bordas Até duas bordas, carimbadas com o relógio atual
+ * @return Número de bordas
+ */
+int passagem_bordas_da_leitura(const DetectorPassagem *d, uint32_t niveis, HalGpioEvento bordas[2]);
+
+/**
+ * @brief Vigia as rampas do nó numa só thread (não retorna)
+ * @param num_rampas Até PASSAGEM_MAX_RAMPAS
+ * @param callback Chamado a cada carro entrando numa rampa e a cada passagem concluída
+ */
+void passagem_monitorar(const RampaConfig *rampas, int num_rampas, PassagemCallback callback);
+
+/**
+ * @brief Nome de um andar para o log ("Térreo", "1º Andar", ...)
+ */
+const char *passagem_nome_andar(int andar);
+
+#endif // PASSAGEM_H
@@ -0,0 +1,114 @@
+#ifndef RELOGIO_H
+#define RELOGIO_H
+
+#include <stdbool.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/time.h>
+
+// Relógio dos nós: toda leitura de hora e toda espera dos nós (térreo, andares,
+// central e placa simulada) passam por aqui, para que o sistema inteiro possa
+// rodar em tempo acelerado. Três modos, escolhidos pela variável de ambiente
+// RELOGIO (ou por relogio_configurar antes de criar as threads):
+//
+//   real       hora do sistema e esperas reais (padrão)
+//   acelerado  o tempo corre RELOGIO_FATOR vezes mais rápido; processos com o
+//              mesmo RELOGIO_INICIO e RELOGIO_ANCORA enxergam a mesma hora
+//   virtual    tempo discreto: o relógio só anda quando todas as threads que
+//              esperam por ele estão dormindo, e salta direto para o prazo mais
+//              próximo (ou por relogio_avancar_ms). Determinístico dentro de um
+//              processo e tão rápido quanto a CPU permitir
+//
+// RELOGIO_INICIO ("AAAA-MM-DD HH:MM:SS", hora local) fixa a hora de parede em que
+// a simulação começa, para que os horários e as cobranças sejam reproduzíveis.
+// No MODBUS só o quadro fica no relógio real (espera do primeiro byte, silêncio
+// T3.5, backoff dos retries e prazos da fila, medidos pela thread do barramento):
+// são tempos físicos da linha. O polling de status e o timeout das câmeras LPR
+// seguem o relógio.
+
+#define RELOGIO_FATOR_PADRAO        1000.0
+
+// Modo virtual: o relógio espera todas as participantes dormirem, sem prazo no
+// relógio real. Uma thread que bloqueia fora dele (socket, teclado, pthread_join)
+// chama relogio_liberar_thread antes; se o relógio ficar parado por isto em tempo
+// real com uma participante acordada, o processo é abortado em vez de avançar
+#define RELOGIO_VIRTUAL_TRAVADO_S   30
+#define RELOGIO_VIRTUAL_MAX_THREADS 64
+
+typedef enum {
+    RELOGIO_REAL      = 0,
+    RELOGIO_ACELERADO = 1,
+    RELOGIO_VIRTUAL   = 2
+} RelogioModo;
+
+/**
+ * @brief Escolhe o modo do relógio (sem chamar, vale a variável RELOGIO)
+ * @param fator Aceleração do modo acelerado (<= 0 usa RELOGIO_FATOR_PADRAO)
+ * @param inicio Hora de parede no início da simulação (0 = hora atual)
+ * @note Deve ser chamada antes de qualquer outra função do relógio
+ */
+void relogio_configurar(RelogioModo modo, double fator, time_t inicio);
+
+/**
+ * @brief Modo em uso
+ */
+RelogioModo relogio_modo();
+
+/**
+ * @brief Milissegundos desde o início do relógio (monotônico)
+ */
+double relogio_agora_ms();
+
+/**
+ * @brief Hora de parede, como gettimeofday
+ */
+void relogio_gettimeofday(struct timeval *tv);
+
+/**
+ * @brief Hora de parede em segundos, como time(NULL)
+ */
+time_t relogio_time();
+
+/**
+ * @brief Dorme o tempo dado em milissegundos do relógio
+ */
+void relogio_dormir_ms(unsigned int ms);
+
+/**
+ * @brief Dorme o tempo dado em microssegundos do relógio (esperas curtas do hardware)
+ */
+void relogio_dormir_us(unsigned int us);
+
+/**
+ * @brief Espera um sinal na condição por até ms do relógio (mutex travado na entrada e na volta)
+ * @note Pode voltar antes do sinal: quem chama confere o predicado e o prazo.
+ *       O sinal deve ser dado com relogio_sinalizar, que também acorda o modo virtual
+ */
+void relogio_esperar_cond(pthread_cond_t *cond, pthread_mutex_t *mutex, unsigned int ms);
+
+/**
+ * @brief Acorda as threads em relogio_esperar_cond nesta condição
+ */
+void relogio_sinalizar(pthread_cond_t *cond);
+
+/**
+ * @brief A thread passa a segurar o avanço do relógio virtual já, sem esperar a
+ *        primeira espera nele (ex: trabalho acordado por fila antes de dormir)
+ * @note Sem efeito fora do modo virtual
+ */
+void relogio_participar_thread();
+
+/**
+ * @brief A thread vai ficar bloqueada fora do relógio (ex: pthread_join, socket):
+ *        no modo virtual, deixa de segurar o avanço do tempo
+ * @note A thread volta a ser participante na próxima espera no relógio
+ */
+void relogio_liberar_thread();
+
+/**
+ * @brief Avança o relógio virtual e acorda as threads cujo prazo venceu
+ * @note Só tem efeito no modo virtual (testes e benchmarks no mesmo processo)
+ */
+void relogio_avancar_ms(double ms);
+
+#endif // RELOGIO_H
@@ -0,0 +1,255 @@
+#ifndef VARREDURA_H
+#define VARREDURA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "histograma.h"
+
+// Varredura das vagas pelo multiplexador de endereços de um andar.
+// Cada andar é descrito por uma tabela (grupos de multiplexação, número de
+// vagas, tempo de acomodação e tipo de cada vaga); o mesmo motor serve o
+// térreo (4 vagas), os andares (8 vagas) e andares maiores (16, 32 ou 64 vagas).
+//
+// Um andar grande pode ter vários grupos: cada grupo é um multiplexador com as
+// suas linhas de endereço (próprias ou compartilhadas) e a sua linha de sensor.
+// Todos os grupos são varridos no mesmo passo (uma escrita mascarada seleciona a
+// posição em todos, um retrato do GPLEV lê todas as linhas de sensor), então um
+// andar de 64 vagas em 8 grupos leva o mesmo tempo que um de 8 vagas. A vaga
+// i do grupo g é a vaga g * 2^num_enderecos + i do andar.
+//
+// As posições do multiplexador são percorridas em código Gray: de uma vaga para
+// a seguinte só uma linha de endereço muda, então cada passo custa uma escrita
+// no GPIO e uma acomodação curta, em vez de reescrever todas as linhas. Todas as
+// linhas de endereço são escritas num só acesso mascarado (hal_gpio_write_mask).
+// O ciclo passa pelas 2^num_enderecos posições mesmo quando o andar tem menos
+// vagas; as posições sem vaga são lidas e descartadas.
+//
+// O tempo de acomodação do descritor é só o ponto de partida: a primeira
+// varredura calibra o andar (troca o endereço e relê o sensor até a saída
+// ficar estável), usa o tempo medido com margem e repete a medição
+// periodicamente (CalibracaoVarredura).
+//
+// Ritmo e calibração partem dos valores abaixo; as variáveis VARREDURA_* do
+// config.env definidas no ambiente os substituem na partida do nó
+// (varredura_parametros_do_ambiente).
+//
+// Ritmo: sem movimento, o andar é varrido devagar (intervalo lento); qualquer
+// atividade ligada ao andar (cancela abrindo, sensor de passagem, vaga mudando,
+// carro entrando no estacionamento) passa o andar para o intervalo rápido até
+// ficar `rapida_por_ms` sem nova atividade. A atividade vem de outras threads e
+// encurta a espera lenta em andamento.
+//
+// Estatísticas: cada varredura acumula os tempos dos passos sem trava e os
+// publica de uma vez nos histogramas do andar (período, duração, passo e
+// detecção → publicação), lidos por varredura_estatisticas_obter.
+//
+// A ocupação de um andar é um mapa de bits (bit i = vaga i). As mudanças entre
+// duas varreduras saem de um XOR e são percorridas bit a bit (count trailing
+// zeros), então qualquer número de carros entrando e saindo na mesma varredura
+// é tratado; as vagas livres de cada tipo saem de um popcount com a máscara do tipo.
+
+#define VARREDURA_MAX_ENDERECOS     6                           // 64 posições por grupo
+#define VARREDURA_MAX_GRUPOS        8
+#define VARREDURA_MAX_VAGAS         64                          // Bits de MapaVagas
+#define VARREDURA_ACOMODACAO_US     200     // Espera após trocar o endereço, antes de ler o sensor
+
+// Calibração da acomodação
+#define VARREDURA_CALIBRACAO_PASSO_US       5       // Intervalo entre releituras do sensor
+#define VARREDURA_CALIBRACAO_LEITURAS       4       // Leituras iguais seguidas para considerar estável
+#define VARREDURA_CALIBRACAO_JANELA_US      50      // Duração mínima da sequência estável
+#define VARREDURA_CALIBRACAO_MAX_US         2000    // Acima disto a medição falha (fica o valor anterior)
+#define VARREDURA_CALIBRACAO_REPETICOES     4       // Passadas por todas as trocas da varredura
+#define VARREDURA_CALIBRACAO_MARGEM         2       // Acomodação usada = medida * margem + folga
+#define VARREDURA_CALIBRACAO_FOLGA_US       20
+#define VARREDURA_ACOMODACAO_MIN_US         10
+#define VARREDURA_RECALIBRACAO_MS           (10 * 60 * 1000)
+
+// Ritmo da varredura
+#define VARREDURA_INTERVALO_RAPIDO_MS       50      // Com atividade no andar
+#define VARREDURA_INTERVALO_LENTO_MS        1000    // Andar parado
+#define VARREDURA_RAPIDA_POR_MS             30000   // Ritmo rápido após a última atividade
+
+// Estatísticas do laço de varredura
+#define VARREDURA_HIST_PERIODO_BASE_US      1000    // Primeira faixa do período e da duração
+#define VARREDURA_HIST_PASSO_BASE_US        10      // Primeira faixa do passo
+#define VARREDURA_HIST_PUBLICACAO_BASE_US   10000   // Primeira faixa da detecção → publicação
+#define VARREDURA_RELATORIO_S               60      // Intervalo do relatório dos nós
+
+// Tipo de vaga (define as contagens de vagas livres enviadas ao Central)
+typedef enum {
+    VAGA_PCD    = 0,
+    VAGA_IDOSO  = 1,
+    VAGA_COMUM  = 2,
+    VAGA_NUM_TIPOS
+} TipoVaga;
+
+// Mapa de ocupação de um andar: bit i = vaga i (vaga i + 1 para o Central)
+typedef uint64_t MapaVagas;
+
+#define MAPA_VAGA(i)                ((MapaVagas)1 << (i))
+
+// Grupo de multiplexação: um multiplexador e a sua linha de sensor
+typedef struct {
+    uint8_t pinos_endereco[VARREDURA_MAX_ENDERECOS];   // Bit 0 do endereço primeiro (GPIO 0 a 31)
+    uint8_t pino_sensor;                                // GPIO 0 a 31
+} GrupoMux;
+
+// Descrição de um andar
+typedef struct {
+    const char *nome;
+    int num_grupos;
+    GrupoMux grupos[VARREDURA_MAX_GRUPOS];
+    int num_enderecos;                                  // Bits de endereço de cada grupo
+    int num_vagas;                                      // Até num_grupos * 2^num_enderecos
+    unsigned int acomodacao_us;
+    TipoVaga tipos[VARREDURA_MAX_VAGAS];
+} DescritorAndar;
+
+// Política de ritmo de um andar
+typedef struct {
+    unsigned int intervalo_rapido_ms;
+    unsigned int intervalo_lento_ms;
+    unsigned int rapida_por_ms;
+    unsigned int relatorio_s;                           // Relatório dos tempos (laço do nó)
+} RitmoVarredura;
+
+#define RITMO_VARREDURA_PADRAO { VARREDURA_INTERVALO_RAPIDO_MS, VARREDURA_INTERVALO_LENTO_MS, \
+                                 VARREDURA_RAPIDA_POR_MS, VARREDURA_RELATORIO_S }
+
+// Calibração da acomodação de um andar
+typedef struct {
+    unsigned int acomodacao_us;                         // Ponto de partida (0 = a do descritor)
+    unsigned int margem;                                // Acomodação usada = medida * margem + folga
+    unsigned int folga_us;
+    unsigned int recalibracao_ms;
+} CalibracaoVarredura;
+
+#define CALIBRACAO_VARREDURA_PADRAO { 0, VARREDURA_CALIBRACAO_MARGEM, VARREDURA_CALIBRACAO_FOLGA_US, \
+                                      VARREDURA_RECALIBRACAO_MS }
+
+// Tempos do laço de varredura de um andar
+typedef struct {
+    unsigned long varreduras;
+    unsigned long publicacoes;                          // Entradas e cobranças publicadas
+    unsigned int intervalo_ms;                          // Ritmo atual
+    unsigned int acomodacao_us;                         // Acomodação em uso
+    Histograma periodo;                                 // Início de uma varredura ao início da seguinte
+    Histograma duracao;                                 // Passos de uma varredura (sem a calibração)
+    Histograma passo;                                   // Seleção do endereço até a leitura dos sensores
+    Histograma publicacao;                              // 1ª leitura divergente → parametros[11]/[14]
+} VarreduraEstatisticas;
+
+// Estado da varredura de um andar
+typedef struct {
+    const DescritorAndar *andar;
+    uint8_t ordem[VARREDURA_MAX_VAGAS];                 // Posições na ordem de Gray (ciclo completo)
+    int passos;
+    int endereco;                                       // Endereço nas linhas (-1 = desconhecido)
+    uint32_t mascara_endereco;                          // Pinos de endereço (hal_gpio_write_mask)
+    uint32_t mascara_sensores;                          // Linhas de sensor dos grupos
+    uint32_t palavras[VARREDURA_MAX_VAGAS];             // Níveis dos pinos para cada endereço
+    unsigned int acomodacao_us;                         // Em uso (calibrada)
+    unsigned int acomodacao_medida_us;                  // Última medição (0 = nunca mediu)
+    CalibracaoVarredura calibracao;
+    double calibrada_ms;                                // Instante da última calibração (< 0 = nunca)
+    MapaVagas todas;                                    // Vagas que existem no andar
+    MapaVagas mascaras[VAGA_NUM_TIPOS];                 // Vagas de cada tipo
+
+    RitmoVarredura ritmo;
+    pthread_mutex_t mutex_ritmo;
+    pthread_cond_t cond_ritmo;                          // Atividade durante a espera
+    double rapida_ate_ms;                               // Ritmo rápido até este instante
+    bool rapida;                                        // Ritmo em uso
+    const char *motivo;                                 // Última atividade
+
+    pthread_mutex_t mutex_estatisticas;
+    VarreduraEstatisticas estatisticas;
+    double inicio_anterior_ms;                          // Início da varredura anterior (< 0 = nenhuma)
+} Varredura;
+
+/**
+ * @brief Substitui ritmo e calibração pelos definidos no ambiente (config.env)
+ * @note Variáveis ausentes ou fora da faixa mantêm o valor recebido
+ */
+void varredura_parametros_do_ambiente(RitmoVarredura *ritmo, CalibracaoVarredura *calibracao);
+
+/**
+ * @brief Prepara a varredura de um andar
+ * @note Deve ser chamada antes de criar as threads que avisam atividade
+ * @return false se o descritor for inválido
+ */
+bool varredura_init(Varredura *v, const DescritorAndar *andar, const RitmoVarredura *ritmo,
+                    const CalibracaoVarredura *calibracao);
+
+/**
+ * @brief Avisa atividade ligada ao andar: passa para o ritmo rápido (qualquer thread)
+ * @param motivo Texto curto para o log (ex: "cancela", "passagem", "vaga")
+ */
+void varredura_atividade(Varredura *v, const char *motivo);
+
+/**
+ * @brief Espera até a próxima varredura, no ritmo atual
+ */
+void varredura_aguardar(Varredura *v);
+
+/**
+ * @brief Intervalo atual entre varreduras do andar (ms)
+ */
+unsigned int varredura_intervalo_ms(Varredura *v);
+
+/**
+ * @brief Mede a acomodação do multiplexador e ajusta a espera da varredura
+ * @return false se alguma troca não estabilizou (a espera não muda)
+ * @note Chamada pela varredura na primeira vez e a cada calibracao.recalibracao_ms
+ */
+bool varredura_calibrar(Varredura *v);
+
+/**
+ * @brief Lê todas as vagas do andar
+ * @return Mapa das vagas ocupadas
+ */
+MapaVagas varredura_executar(Varredura *v);
+
+/**
+ * @brief Registra a publicação de uma entrada ou cobrança do andar
+ * @param atraso_ms Tempo desde a primeira leitura divergente da vaga
+ */
+void varredura_registrar_publicacao(Varredura *v, double atraso_ms);
+
+/**
+ * @brief Copia as estatísticas do laço de varredura (qualquer thread)
+ */
+void varredura_estatisticas_obter(Varredura *v, VarreduraEstatisticas *out);
+
+/**
+ * @brief Imprime contadores e histogramas do laço de varredura do andar
+ */
+void varredura_imprimir_estatisticas(Varredura *v);
+
+/**
+ * @brief Vagas livres de um tipo
+ */
+int varredura_livres(const Varredura *v, MapaVagas ocupadas, TipoVaga tipo);
+
+/**
+ * @brief Número de vagas no mapa
+ */
+static inline int mapa_contar(MapaVagas mapa) {
+    return __builtin_popcountll(mapa);
+}
+
+/**
+ * @brief Retira do mapa a vaga de menor índice
+ * @return Índice da vaga, ou -1 se o mapa estiver vazio
+ */
+static inline int mapa_retirar(MapaVagas *mapa) {
+    if (*mapa == 0) {
+        return -1;
+    }
+    int i = __builtin_ctzll(*mapa);
+    *mapa &= *mapa - 1;
+    return i;
+}
+
+#endif // VARREDURA_H
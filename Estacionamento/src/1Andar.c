@@ -1,4 +1,8 @@
-#include <bcm2835.h>
+#include "../inc/hal_gpio.h"
+#include "../inc/relogio.h"
+#include "../inc/varredura.h"
+#include "../inc/filtro_vagas.h"
+#include "../inc/passagem.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <pthread.h>
@@ -18,24 +22,45 @@
 #define SENSOR_DE_VAGA 27                    // GPIO 27 - ENTRADA
 #define SENSOR_DE_PASSAGEM_1 22              // GPIO 22 - ENTRADA
 #define SENSOR_DE_PASSAGEM_2 11              // GPIO 11 - ENTRADA
-#define SINAL_DE_LOTADO_FECHADO1 RPI_GPIO_P1_24             // PINO 08 - SAÍDA
+#define SINAL_DE_LOTADO_FECHADO1 8                          // GPIO 08 - Pino físico 24 - SAÍDA
+
+// Multiplexador das vagas do 1º Andar: vaga 1 PcD, vagas 2 e 3 idoso, vagas 4 a 8 comuns
+static const DescritorAndar andar1Vagas = {
+    "1º Andar", 1, { { { ENDERECO_01, ENDERECO_02, ENDERECO_03 }, SENSOR_DE_VAGA } }, 3, 8, VARREDURA_ACOMODACAO_US,
+    { VAGA_PCD, VAGA_IDOSO, VAGA_IDOSO, VAGA_COMUM, VAGA_COMUM, VAGA_COMUM, VAGA_COMUM, VAGA_COMUM }
+};
+
+// Filtro das leituras das vagas (N de M com permanência mínima); as variáveis
+// FILTRO_VAGAS_* do config.env definidas no ambiente substituem o padrão
+static FiltroVagasConfig filtroAndar1Config = FILTRO_VAGAS_PADRAO;
+
+// Rampas vigiadas pelo nó: sensor 1 do lado do andar de baixo
+static const RampaConfig rampasA[] = {
+    { "Rampa Térreo ↔ 1º Andar", SENSOR_DE_PASSAGEM_1, SENSOR_DE_PASSAGEM_2, 0, 1 },
+};
+
+// Ritmo da varredura (lento com o andar parado, rápido com atividade) e
+// calibração do multiplexador; as variáveis VARREDURA_* do config.env definidas
+// no ambiente substituem o padrão
+static RitmoVarredura ritmoAndar1 = RITMO_VARREDURA_PADRAO;
+static CalibracaoVarredura calibracaoAndar1 = CALIBRACAO_VARREDURA_PADRAO;
 
 void configuraPinos1(){
-    bcm2835_gpio_fsel(ENDERECO_01, BCM2835_GPIO_FSEL_OUTP);
-    bcm2835_gpio_fsel(ENDERECO_02, BCM2835_GPIO_FSEL_OUTP);
-    bcm2835_gpio_fsel(ENDERECO_03, BCM2835_GPIO_FSEL_OUTP);
-    bcm2835_gpio_fsel(SENSOR_DE_VAGA, BCM2835_GPIO_FSEL_INPT);
-    bcm2835_gpio_fsel(SINAL_DE_LOTADO_FECHADO1, BCM2835_GPIO_FSEL_OUTP);
-    bcm2835_gpio_fsel(SENSOR_DE_PASSAGEM_1, BCM2835_GPIO_FSEL_INPT);
-    bcm2835_gpio_fsel(SENSOR_DE_PASSAGEM_2, BCM2835_GPIO_FSEL_INPT);
+    hal_gpio_fsel(ENDERECO_01, HAL_GPIO_SAIDA);
+    hal_gpio_fsel(ENDERECO_02, HAL_GPIO_SAIDA);
+    hal_gpio_fsel(ENDERECO_03, HAL_GPIO_SAIDA);
+    hal_gpio_fsel(SENSOR_DE_VAGA, HAL_GPIO_ENTRADA);
+    hal_gpio_fsel(SINAL_DE_LOTADO_FECHADO1, HAL_GPIO_SAIDA);
+    hal_gpio_fsel(SENSOR_DE_PASSAGEM_1, HAL_GPIO_ENTRADA);
+    hal_gpio_fsel(SENSOR_DE_PASSAGEM_2, HAL_GPIO_ENTRADA);
     
     // Configura pull-down nos sensores de vaga para evitar leituras falsas
-    bcm2835_gpio_set_pud(SENSOR_DE_VAGA, BCM2835_GPIO_PUD_DOWN);
-    bcm2835_gpio_set_pud(SENSOR_DE_PASSAGEM_1, BCM2835_GPIO_PUD_DOWN);
-    bcm2835_gpio_set_pud(SENSOR_DE_PASSAGEM_2, BCM2835_GPIO_PUD_DOWN);
+    hal_gpio_set_pud(SENSOR_DE_VAGA, HAL_PUD_DOWN);
+    hal_gpio_set_pud(SENSOR_DE_PASSAGEM_1, HAL_PUD_DOWN);
+    hal_gpio_set_pud(SENSOR_DE_PASSAGEM_2, HAL_PUD_DOWN);
     
     // Inicializa sinal de lotado como LOW (não lotado)
-    bcm2835_gpio_write(SINAL_DE_LOTADO_FECHADO1, LOW);
+    hal_gpio_write(SINAL_DE_LOTADO_FECHADO1, LOW);
 }
 
 typedef struct vaga
@@ -44,40 +69,36 @@ typedef struct vaga
     struct timeval hsaida;  // Horário de saída do carro da vaga
     int tempo;              // Tempo de permanência do carro na vaga
     int ncarro;             // Número do carro estacionado
-    int ocupado;            // ex: Vaga 1 = 1, Vaga 2 = 2, Vaga 3 = 3, Vaga 4 = 4, Vaga 5 = 5, Vaga 6 = 6, Vaga 7 = 7, Vaga 8 = 8, Vaga livre = 0
-    bool boolocupado;       // 0 = vaga livre, 1 = vaga ocupada
 }vaga;
-typedef struct vsoma{
-    int somaValores;    // Soma dos valores das vagas ocupadas (ex: 1+2+3+4+5+6+7+8 = 36)
-    int somaVagas;      // Soma das vagas ocupadas (ex: 1+1+1+1+1+1+1+1 = 8)
-}vsoma;
 
 vaga *a;
-vsoma s;
-int valor1;                          // Valor lido pelo sensor de vaga
+Varredura varredura1;
+FiltroVagas filtro1;
+MapaVagas ocupadas1 = 0;             // Bit i = vaga i com carro registrado
+MapaVagas ignoradas1 = 0;            // Bit i = vaga i ocupada com o andar bloqueado (sem registro)
 bool carroAndar1 = false;            // 0 = carro não está andando, 1 = carro está andando  
-int k1=0, carroTotal1=0;
+int carroTotal1=0;
 int idoso1 = 2, pcd1 = 1, normal1 = 5, fechado1 = 0;
-int anteriorSomaValores1 = 0;
 
 #define tamVetorEnviar 23
 #define tamVetorReceber 5
 
-int parametros1[tamVetorEnviar];
+int parametros1[tamVetorEnviar + PASSAGEM_NUM_CONTADORES];   // Estado + passagens por par de andares
 int recebe1[tamVetorReceber];
 
 // Função para inicializar todas as vagas como vazias
 void inicializarVagas1(vaga *v){
     printf("Inicializando 1º andar - Todas as vagas vazias\n");
     for(int i = 0; i < 8; i++){
-        v[i].ocupado = 0;
-        v[i].boolocupado = 0;
         v[i].ncarro = 0;
         v[i].tempo = 0;
     }
-    s.somaValores = 0;
-    s.somaVagas = 0;
-    anteriorSomaValores1 = 0;
+    ocupadas1 = 0;
+    ignoradas1 = 0;
+    varredura_parametros_do_ambiente(&ritmoAndar1, &calibracaoAndar1);
+    varredura_init(&varredura1, &andar1Vagas, &ritmoAndar1, &calibracaoAndar1);
+    filtro_vagas_config_do_ambiente(&filtroAndar1Config);
+    filtro_vagas_init(&filtro1, &filtroAndar1Config, andar1Vagas.num_vagas);
     printf("1º andar inicializado com sucesso - 8 vagas disponíveis\n");
 }
 
@@ -86,33 +107,15 @@ int separaIguala1(){
     parametros1[0]  = pcd1;
     parametros1[1]  = idoso1;
     parametros1[2]  = normal1;
-    parametros1[3]  = a[0].boolocupado;
-    parametros1[4]  = a[1].boolocupado;
-    parametros1[5]  = a[2].boolocupado;
-    parametros1[6]  = a[3].boolocupado;
-    parametros1[7]  = a[4].boolocupado;
-    parametros1[8]  = a[5].boolocupado;
-    parametros1[9]  = a[6].boolocupado;
-    parametros1[10] = a[7].boolocupado;
+    for(int i = 0; i < andar1Vagas.num_vagas; i++){
+        parametros1[3 + i] = (ocupadas1 & MAPA_VAGA(i)) != 0;
+    }
     parametros1[12]= recebe1[0];
-    parametros1[18]= s.somaVagas;
+    parametros1[18]= mapa_contar(ocupadas1);
     fechado1 = recebe1[2];
 }
 
-void vagasOcupadas1(vaga *v){
-    
-    s.somaValores = 0;
-    s.somaVagas = 0;
-    for(int i = 0; i<8; i++){
-        if(v[i].ocupado != 0){
-            s.somaVagas++;
-        }
-        s.somaValores += v[i].ocupado;
-    }
-    
-}
-
-void * vagasDisponiveis1(vaga *p){
+void * vagasDisponiveis1(){
     // Se o 1º andar está fechado, todas as vagas são consideradas indisponíveis
     if(fechado1 == 1){
         idoso1 = 0;
@@ -121,40 +124,10 @@ void * vagasDisponiveis1(vaga *p){
         return NULL;
     }
     
-    idoso1 = 2;
-    pcd1 = 1;
-    normal1 = 5;
-    
-        for(int i=3; i<8; i++){
-            if(p[i].ocupado > 0)
-                p[i].boolocupado = 1;
-            
-            else if(p[i].ocupado == 0)
-                p[i].boolocupado=0;
-            normal1 -= p[i].boolocupado;
-        }
-        for(int i=1; i<3; i++){
-            if(p[i].ocupado > 0)
-                p[i].boolocupado = 1;
-            
-            else if(p[i].ocupado == 0)
-                p[i].boolocupado=0;
-
-            idoso1 -= p[i].boolocupado;
-        }
-        
-        if(p[0].ocupado > 0){
-            pcd1=0;
-            p[0].boolocupado = 1;
-        }
-        else if(p[0].ocupado == 0) {
-            pcd1=1;
-            p[0].boolocupado = 0;
-        }
-}
-
-int mudancaEstadoVaga1( int anteriorSomaValores1){
-    return anteriorSomaValores1-s.somaValores; 
+    pcd1 = varredura_livres(&varredura1, ocupadas1, VAGA_PCD);
+    idoso1 = varredura_livres(&varredura1, ocupadas1, VAGA_IDOSO);
+    normal1 = varredura_livres(&varredura1, ocupadas1, VAGA_COMUM);
+    return NULL;
 }
 
 int timediff1(struct timeval entrada, struct timeval saida){ 
@@ -163,7 +136,7 @@ int timediff1(struct timeval entrada, struct timeval saida){
 
 void pagamento1(int g, vaga *a){
     
-    gettimeofday(&a[g-1].hsaida,0);
+    relogio_gettimeofday(&a[g-1].hsaida);
     // Calcula tempo em segundos e arredonda para cima em minutos
     int segundos = timediff1(a[g-1].hent,a[g-1].hsaida);
     int minutos = (segundos + 59) / 60; // Arredonda para cima: qualquer fração = 1 minuto
@@ -175,153 +148,74 @@ void pagamento1(int g, vaga *a){
     parametros1[15]=a[g-1].ncarro;
     parametros1[16]=minutos;
     parametros1[17]=g;
-    delay(100);  // ✅ REDUZIDO: 100ms para atualização mais rápida
+    hal_delay(100);  // ✅ REDUZIDO: 100ms para atualização mais rápida
     parametros1[14]=0;
 }
 
 void buscaCarro1(int f , vaga *a){
-    f *= -1;
     a[f-1].ncarro = parametros1[12];
-    gettimeofday(&a[f-1].hent,0);
+    relogio_gettimeofday(&a[f-1].hent);
     parametros1[11] = 1;
     parametros1[13] = f;
-    delay(1000);
+    hal_delay(1000);
     parametros1[11] = 0;
 }
 
 void leituraVagasAndar1(vaga *b){
-    k1=0;       
-    s.somaVagas = 0;
-    s.somaValores = 0;
+    ocupadas1 = 0;
+    ignoradas1 = 0;
 
     while(1){
         
-        delay(50);
-        vagasOcupadas1(a);
-        vagasDisponiveis1(a);
+        varredura_aguardar(&varredura1);
+        vagasDisponiveis1();
         separaIguala1();
 
-        //Primeira vaga
-        bcm2835_gpio_write(ENDERECO_01, LOW);
-        bcm2835_gpio_write(ENDERECO_02, LOW);
-        bcm2835_gpio_write(ENDERECO_03, LOW);
-        delay(50);
-        valor1 = bcm2835_gpio_lev(SENSOR_DE_VAGA);
-        if(valor1 == 1)
-            b[0].ocupado = 1;
-            
-        else if(valor1 == 0) 
-            b[0].ocupado = 0;
-        
-        //Segunda vaga
-        bcm2835_gpio_write(ENDERECO_01, HIGH);
-        bcm2835_gpio_write(ENDERECO_02, LOW);
-        bcm2835_gpio_write(ENDERECO_03, LOW);
-        delay(50);
-        valor1 = bcm2835_gpio_lev(SENSOR_DE_VAGA);
-        if(valor1 == 1)
-            b[1].ocupado = 2;
-        else if(valor1 == 0) 
-            b[1].ocupado = 0;
-
-        //Terceira vaga
-        bcm2835_gpio_write(ENDERECO_01, LOW);
-        bcm2835_gpio_write(ENDERECO_02, HIGH);
-        bcm2835_gpio_write(ENDERECO_03, LOW);
-        delay(50);
-        valor1 = bcm2835_gpio_lev(SENSOR_DE_VAGA);
-        if(valor1 == 1)
-            b[2].ocupado = 3;
-        else if(valor1 == 0) 
-            b[2].ocupado = 0;        
-
-        //Quarta vaga
-        bcm2835_gpio_write(ENDERECO_01, HIGH);
-        bcm2835_gpio_write(ENDERECO_02, HIGH);
-        bcm2835_gpio_write(ENDERECO_03, LOW);
-        delay(50);
-        valor1 = bcm2835_gpio_lev(SENSOR_DE_VAGA);
-        if(valor1 == 1)
-            b[3].ocupado = 4;
-        else if(valor1 == 0) 
-            b[3].ocupado = 0;        
-
-        //Quinta vaga
-        bcm2835_gpio_write(ENDERECO_01, LOW);
-        bcm2835_gpio_write(ENDERECO_02, LOW);
-        bcm2835_gpio_write(ENDERECO_03, HIGH);
-        delay(50);
-        valor1 = bcm2835_gpio_lev(SENSOR_DE_VAGA);
-        if(valor1 == 1)
-            b[4].ocupado = 5;
-        else if(valor1 == 0) 
-            b[4].ocupado = 0;        
-
-        //Sexta vaga
-        bcm2835_gpio_write(ENDERECO_01, HIGH);
-        bcm2835_gpio_write(ENDERECO_02, LOW);
-        bcm2835_gpio_write(ENDERECO_03, HIGH);
-        delay(50);
-        valor1 = bcm2835_gpio_lev(SENSOR_DE_VAGA);
-        if(valor1 == 1)
-            b[5].ocupado = 6;
-        else if(valor1 == 0) 
-            b[5].ocupado = 0;        
-
-        //Sétima vaga
-        bcm2835_gpio_write(ENDERECO_01, LOW);
-        bcm2835_gpio_write(ENDERECO_02, HIGH);
-        bcm2835_gpio_write(ENDERECO_03, HIGH);
-        delay(50);
-        valor1 = bcm2835_gpio_lev(SENSOR_DE_VAGA);
-        if(valor1 == 1)
-            b[6].ocupado = 7;
-        else if(valor1 == 0) 
-            b[6].ocupado = 0;
-
-        //Oitava vaga
-        bcm2835_gpio_write(ENDERECO_01, HIGH);
-        bcm2835_gpio_write(ENDERECO_02, HIGH);
-        bcm2835_gpio_write(ENDERECO_03, HIGH);
-        delay(50);
-        valor1 = bcm2835_gpio_lev(SENSOR_DE_VAGA);
-        if(valor1 == 1)
-            b[7].ocupado = 8;
-        else if(valor1 == 0) 
-            b[7].ocupado = 0;
-
-//-------------------------------------------------------------//
-        k1 = mudancaEstadoVaga1(anteriorSomaValores1);
-        if(k1>0 && k1<9){
-            pagamento1(k1, b);
-            
-        }else if(k1<0 && k1>-9){
+        // Lê as 8 vagas pelo multiplexador, filtra o ruído e trata cada vaga que mudou
+        MapaVagas lidas = filtro_vagas_aplicar(&filtro1, varredura_executar(&varredura1), relogio_agora_ms());
+        MapaVagas mudancas = lidas ^ (ocupadas1 | ignoradas1);
+        // Vaga mudando (ou ainda em confirmação no filtro): mantém o ritmo rápido
+        if(mudancas || filtro1.pendentes){
+            varredura_atividade(&varredura1, "vaga");
+        }
+        int i;
+        while((i = mapa_retirar(&mudancas)) >= 0){
+            if(!(lidas & MAPA_VAGA(i))){
+                if(ignoradas1 & MAPA_VAGA(i)){
+                    ignoradas1 &= ~MAPA_VAGA(i);     // Nunca foi registrada: nada a cobrar
+                } else {
+                    ocupadas1 &= ~MAPA_VAGA(i);
+                    varredura_registrar_publicacao(&varredura1, filtro_vagas_atraso_ms(&filtro1, i, relogio_agora_ms()));
+                    pagamento1(i + 1, b);
+                }
             // ✅ BLOQUEIO: Só permite estacionar se o andar NÃO está fechado
-            if(fechado1 == 0){
-                buscaCarro1(k1, b);
+            } else if(fechado1 == 0){
+                ocupadas1 |= MAPA_VAGA(i);
+                varredura_registrar_publicacao(&varredura1, filtro_vagas_atraso_ms(&filtro1, i, relogio_agora_ms()));
+                buscaCarro1(i + 1, b);
             } else {
-                printf("[1º Andar] 🚫 Vaga %d IGNORADA - Andar está bloqueado\n", k1 * -1);
-                // Reseta a vaga para evitar registro fantasma
-                b[(k1 * -1) - 1].ocupado = 0;
+                printf("[1º Andar] 🚫 Vaga %d IGNORADA - Andar está bloqueado\n", i + 1);
+                // Marca a vaga para evitar registro fantasma
+                ignoradas1 |= MAPA_VAGA(i);
             }
-        } 
-        anteriorSomaValores1 = s.somaValores;
+        }
         
-        if((s.somaVagas < 8 && fechado1==0)){
-            bcm2835_gpio_write(SINAL_DE_LOTADO_FECHADO1, LOW);
+        int somaVagas1 = mapa_contar(ocupadas1);
+        if((somaVagas1 < 8 && fechado1==0)){
+            hal_gpio_write(SINAL_DE_LOTADO_FECHADO1, LOW);
             parametros1[20] = 0;
         }
-        else if(s.somaVagas==8){
-            bcm2835_gpio_write(SINAL_DE_LOTADO_FECHADO1, HIGH);
+        else if(somaVagas1==8){
+            hal_gpio_write(SINAL_DE_LOTADO_FECHADO1, HIGH);
             parametros1[20] = 1;
         } 
         
         else if(fechado1==1){
-            bcm2835_gpio_write(SINAL_DE_LOTADO_FECHADO1, HIGH);
+            hal_gpio_write(SINAL_DE_LOTADO_FECHADO1, HIGH);
             parametros1[20] = 1;
         } 
         else if(fechado1 == 0){
-            bcm2835_gpio_write(SINAL_DE_LOTADO_FECHADO1, LOW);
+            hal_gpio_write(SINAL_DE_LOTADO_FECHADO1, LOW);
             parametros1[20] = 0;
         } 
     }
@@ -331,84 +225,46 @@ void *chamaLeitura1(){
     leituraVagasAndar1(a);
 }
 
+/**
+ * @brief Aviso das rampas do 1º Andar: carro entrando numa rampa ou passagem concluída
+ */
+void publicarPassagemA(const RampaConfig *rampa, ResultadoPassagem resultado, const Passagem *p){
+    if(resultado == PASSAGEM_INICIO){
+        varredura_atividade(&varredura1, "passagem");
+        return;
+    }
+    
+    const char *origem = passagem_nome_andar(p->andar_origem);
+    const char *destino = passagem_nome_andar(p->andar_destino);
+    // ✅ BLOQUEIO: com o 1º Andar fechado, a chegada ao andar não é registrada
+    if(p->andar_destino == 1 && fechado1 == 1){
+        printf("[1º Andar] 🚫 BLOQUEADO - Passagem %s → %s ignorada (andar fechado)\n", origem, destino);
+        return;
+    }
+    bool sobe = p->direcao == PASSAGEM_SOBE;
+    printf("[1º Andar] %s %s: %s → %s (%s, travessia %.0f ms, %.1f km/h)\n",
+           sobe ? "↑" : "↓", sobe ? "SUBINDO" : "DESCENDO",
+           origem, destino, rampa->nome, p->travessia_ms, p->velocidade_kmh);
+    if(sobe){
+        parametros1[21]++;
+    } else {
+        parametros1[22]++;
+    }
+    parametros1[tamVetorEnviar + PASSAGEM_INDICE(p->andar_origem, p->andar_destino)]++;
+}
+
 /**
  * @brief Thread que detecta passagem de carros entre andares no 1º Andar
  * 
- * Lógica de detecção:
- * - SENSOR_1 ativado primeiro, depois SENSOR_2: Carro SUBINDO (Térreo → 1º Andar)
- * - SENSOR_2 ativado primeiro, depois SENSOR_1: Carro DESCENDO (1º Andar → Térreo)
- * 
- * Registra no array parametros1[21] e parametros1[22]:
- * - parametros1[21] = direção (1 = subindo, 2 = descendo)
- * - parametros1[22] = flag de evento (1 = passagem detectada, 0 = sem evento)
+ * Vigia todas as rampas de rampasA numa só thread (passagem_monitorar), sem
+ * bloquear entre um carro e outro. Publica contadores acumulados para o Central
+ * não perder passagens seguidas:
+ * - parametros1[21] = subidas, parametros1[22] = descidas (todas as rampas)
+ * - parametros1[tamVetorEnviar + PASSAGEM_INDICE(origem, destino)] = passagens por par de andares
  */
 void *sensorPassagemA(){
     printf("[1º Andar] Thread de detecção de passagem iniciada\n");
-    
-    int sensor1_anterior = 0;
-    int sensor2_anterior = 0;
-    int sensor1_ativo = 0;
-    int sensor2_ativo = 0;
-    int primeiro_sensor = 0;  // 1 = sensor1 ativou primeiro, 2 = sensor2 ativou primeiro
-    
-    while(1){
-        // Lê os sensores
-        sensor1_ativo = bcm2835_gpio_lev(SENSOR_DE_PASSAGEM_1);
-        sensor2_ativo = bcm2835_gpio_lev(SENSOR_DE_PASSAGEM_2);
-        
-        // Detecta qual sensor ativou primeiro (borda de subida)
-        if(sensor1_ativo == 1 && sensor1_anterior == 0 && primeiro_sensor == 0){
-            // Sensor 1 ativou primeiro
-            primeiro_sensor = 1;
-            printf("[1º Andar] Sensor 1 detectou presença\n");
-        }
-        else if(sensor2_ativo == 1 && sensor2_anterior == 0 && primeiro_sensor == 0){
-            // Sensor 2 ativou primeiro
-            primeiro_sensor = 2;
-            printf("[1º Andar] Sensor 2 detectou presença\n");
-        }
-        
-        // Detecta a direção completa
-        if(primeiro_sensor == 1 && sensor2_ativo == 1){
-            // ✅ BLOQUEIO: Verifica se o 1º andar está fechado ANTES de permitir subida
-            if(fechado1 == 1){
-                printf("[1º Andar] 🚫 BLOQUEADO - Impedindo subida (andar fechado)\n");
-                primeiro_sensor = 0;  // Reseta para evitar loop
-                delay(1000);  // Aguarda carro retornar
-            } else {
-                // Sensor 1 → Sensor 2: Carro SUBINDO (Térreo → 1º Andar)
-                printf("[1º Andar] ↑ SUBINDO: Térreo → 1º Andar\n");
-                parametros1[21] = 1;  // 1 = subindo
-                parametros1[22] = 1;  // Flag de evento
-                
-                delay(1000);  // Aguarda passagem completa
-                parametros1[22] = 0;  // Reseta flag
-                primeiro_sensor = 0;
-            }
-        }
-        else if(primeiro_sensor == 2 && sensor1_ativo == 1){
-            // Sensor 2 → Sensor 1: Carro DESCENDO (1º Andar → Térreo)
-            printf("[1º Andar] ↓ DESCENDO: 1º Andar → Térreo\n");
-            parametros1[21] = 2;  // 2 = descendo
-            parametros1[22] = 1;  // Flag de evento
-            
-            delay(1000);  // Aguarda passagem completa
-            parametros1[22] = 0;  // Reseta flag
-            primeiro_sensor = 0;
-        }
-        
-        // Reseta se ambos os sensores desativarem
-        if(sensor1_ativo == 0 && sensor2_ativo == 0){
-            primeiro_sensor = 0;
-        }
-        
-        // Atualiza estados anteriores
-        sensor1_anterior = sensor1_ativo;
-        sensor2_anterior = sensor2_ativo;
-        
-        delay(50);  // Polling rápido para não perder eventos
-    }
-    
+    passagem_monitorar(rampasA, sizeof(rampasA) / sizeof(rampasA[0]), publicarPassagemA);
     return NULL;
 }
 
@@ -433,10 +289,23 @@ void *enviaParametros1(){
     addr.sin_addr.s_addr = inet_addr(ip);
     connect(sock, (struct sockaddr*)&addr, sizeof(addr));
     printf("Connected to Server\n");
+    int carrosAnterior = 0;
+    double ultimoRelatorio = relogio_agora_ms();
     while(1){
-        send (sock, parametros1, tamVetorEnviar *sizeof(int) , 0);
+        relogio_liberar_thread();   // Espera o Central no socket: não segura o relógio virtual
+        send (sock, parametros1, (tamVetorEnviar + PASSAGEM_NUM_CONTADORES) * sizeof(int), 0);
         recv(sock, recebe1, tamVetorReceber * sizeof(int), 0);
-        delay(1000);
+        // recebe[0] = carros que já entraram: um carro novo pode estar subindo
+        if(recebe1[0] != carrosAnterior){
+            carrosAnterior = recebe1[0];
+            varredura_atividade(&varredura1, "entrada no estacionamento");
+        }
+        // Relatório periódico dos tempos do laço de varredura
+        if(relogio_agora_ms() - ultimoRelatorio >= ritmoAndar1.relatorio_s * 1000.0){
+            ultimoRelatorio = relogio_agora_ms();
+            varredura_imprimir_estatisticas(&varredura1);
+        }
+        hal_delay(1000);
     }
     close(sock);
     printf("Disconnected from server\n");
@@ -445,7 +314,7 @@ void *enviaParametros1(){
 int mainU(){
     //mainU
     
-    if (!bcm2835_init())
+    if (!hal_gpio_init(HAL_PLACA_ANDAR1))
         return 1;
     
     configuraPinos1();
@@ -457,16 +326,17 @@ int mainU(){
     
     // Aguarda 2 segundos para estabilizar os sensores
     printf("Aguardando estabilização dos sensores...\n");
-    delay(2000);
+    hal_delay(2000);
     
     pthread_t fLeituraVagas1, fEnviaParametros1, fSensorPassagemA;
     
     pthread_create(&fLeituraVagas1, NULL, chamaLeitura1, NULL);
     pthread_create(&fEnviaParametros1, NULL, enviaParametros1, NULL);
     pthread_create(&fSensorPassagemA, NULL, sensorPassagemA, NULL);  // ✅ Ativado
+    relogio_liberar_thread();    // A thread principal só espera as outras
     pthread_join(fLeituraVagas1, NULL);
     pthread_join(fEnviaParametros1, NULL);
     pthread_join(fSensorPassagemA, NULL);  // ✅ Ativado
-    bcm2835_close();
+    hal_gpio_close();
     return 0;
 }
\ No newline at end of file
@@ -1,4 +1,8 @@
-#include <bcm2835.h>
+#include "../inc/hal_gpio.h"
+#include "../inc/relogio.h"
+#include "../inc/varredura.h"
+#include "../inc/filtro_vagas.h"
+#include "../inc/passagem.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <pthread.h>
@@ -20,24 +24,45 @@
 #define SENSOR_DE_VAGA 13                                   // GPIO 13 - Pino físico 33 - ENTRADA
 #define SENSOR_DE_PASSAGEM_1 19                             // GPIO 19 - Pino físico 35 - ENTRADA
 #define SENSOR_DE_PASSAGEM_2 26                             // GPIO 26 - Pino físico 37 - ENTRADA
-#define SINAL_DE_LOTADO_FECHADO2 RPI_V2_GPIO_P1_08          // GPIO 14 - Pino físico 8 - SAÍDA
+#define SINAL_DE_LOTADO_FECHADO2 14                         // GPIO 14 - Pino físico 8 - SAÍDA
+
+// Multiplexador das vagas do 2º Andar: vaga 1 PcD, vagas 2 e 3 idoso, vagas 4 a 8 comuns
+static const DescritorAndar andar2Vagas = {
+    "2º Andar", 1, { { { ENDERECO_01, ENDERECO_02, ENDERECO_03 }, SENSOR_DE_VAGA } }, 3, 8, VARREDURA_ACOMODACAO_US,
+    { VAGA_PCD, VAGA_IDOSO, VAGA_IDOSO, VAGA_COMUM, VAGA_COMUM, VAGA_COMUM, VAGA_COMUM, VAGA_COMUM }
+};
+
+// Filtro das leituras das vagas (N de M com permanência mínima); as variáveis
+// FILTRO_VAGAS_* do config.env definidas no ambiente substituem o padrão
+static FiltroVagasConfig filtroAndar2Config = FILTRO_VAGAS_PADRAO;
+
+// Rampas vigiadas pelo nó: sensor 1 do lado do andar de baixo
+static const RampaConfig rampasB[] = {
+    { "Rampa 1º Andar ↔ 2º Andar", SENSOR_DE_PASSAGEM_1, SENSOR_DE_PASSAGEM_2, 1, 2 },
+};
+
+// Ritmo da varredura (lento com o andar parado, rápido com atividade) e
+// calibração do multiplexador; as variáveis VARREDURA_* do config.env definidas
+// no ambiente substituem o padrão
+static RitmoVarredura ritmoAndar2 = RITMO_VARREDURA_PADRAO;
+static CalibracaoVarredura calibracaoAndar2 = CALIBRACAO_VARREDURA_PADRAO;
 
 void configuraPinos2(){
-    bcm2835_gpio_fsel(ENDERECO_01, BCM2835_GPIO_FSEL_OUTP);
-    bcm2835_gpio_fsel(ENDERECO_02, BCM2835_GPIO_FSEL_OUTP);
-    bcm2835_gpio_fsel(ENDERECO_03, BCM2835_GPIO_FSEL_OUTP);
-    bcm2835_gpio_fsel(SENSOR_DE_VAGA, BCM2835_GPIO_FSEL_INPT);
-    bcm2835_gpio_fsel(SINAL_DE_LOTADO_FECHADO2, BCM2835_GPIO_FSEL_OUTP);
-    bcm2835_gpio_fsel(SENSOR_DE_PASSAGEM_1, BCM2835_GPIO_FSEL_INPT);
-    bcm2835_gpio_fsel(SENSOR_DE_PASSAGEM_2, BCM2835_GPIO_FSEL_INPT);
+    hal_gpio_fsel(ENDERECO_01, HAL_GPIO_SAIDA);
+    hal_gpio_fsel(ENDERECO_02, HAL_GPIO_SAIDA);
+    hal_gpio_fsel(ENDERECO_03, HAL_GPIO_SAIDA);
+    hal_gpio_fsel(SENSOR_DE_VAGA, HAL_GPIO_ENTRADA);
+    hal_gpio_fsel(SINAL_DE_LOTADO_FECHADO2, HAL_GPIO_SAIDA);
+    hal_gpio_fsel(SENSOR_DE_PASSAGEM_1, HAL_GPIO_ENTRADA);
+    hal_gpio_fsel(SENSOR_DE_PASSAGEM_2, HAL_GPIO_ENTRADA);
     
     // Configura pull-down nos sensores de vaga para evitar leituras falsas
-    bcm2835_gpio_set_pud(SENSOR_DE_VAGA, BCM2835_GPIO_PUD_DOWN);
-    bcm2835_gpio_set_pud(SENSOR_DE_PASSAGEM_1, BCM2835_GPIO_PUD_DOWN);
-    bcm2835_gpio_set_pud(SENSOR_DE_PASSAGEM_2, BCM2835_GPIO_PUD_DOWN);
+    hal_gpio_set_pud(SENSOR_DE_VAGA, HAL_PUD_DOWN);
+    hal_gpio_set_pud(SENSOR_DE_PASSAGEM_1, HAL_PUD_DOWN);
+    hal_gpio_set_pud(SENSOR_DE_PASSAGEM_2, HAL_PUD_DOWN);
     
     // Inicializa sinal de lotado como LOW (não lotado)
-    bcm2835_gpio_write(SINAL_DE_LOTADO_FECHADO2, LOW);
+    hal_gpio_write(SINAL_DE_LOTADO_FECHADO2, LOW);
 }
 /*
 parametros[0] = vagas disponiveis pcd;       parametros[10] = v[7].ocupado;
@@ -57,40 +82,36 @@ typedef struct vaga{
     struct timeval hsaida;  // Horário de saída do carro da vaga
     int tempo;              // Tempo de permanência do carro na vaga
     int ncarro;             // Número do carro estacionado
-    int ocupado;            // ex: Vaga 1 = 1, Vaga 2 = 2, Vaga 3 = 3, Vaga 4 = 4, Vaga 5 = 5, Vaga 6 = 6, Vaga 7 = 7, Vaga 8 = 8, Vaga livre = 0
-    bool boolocupado;       // 0 = vaga livre, 1 = vaga ocupada
 }vaga;
-typedef struct vsoma{
-    int somaValores;    // Soma dos valores das vagas ocupadas (ex: 1+2+3+4+5+6+7+8 = 36)
-    int somaVagas;      // Soma das vagas ocupadas (ex: 1+1+1+1+1+1+1+1 = 8)
-}vsoma;
 
 vaga *b;
-vsoma t;
-int valor2;                          // Valor lido pelo sensor de vaga
+Varredura varredura2;
+FiltroVagas filtro2;
+MapaVagas ocupadas2 = 0;             // Bit i = vaga i com carro registrado
+MapaVagas ignoradas2 = 0;            // Bit i = vaga i ocupada com o andar bloqueado (sem registro)
 bool carroAndar2 = false;            // 0 = carro não está andando, 1 = carro está andando  
-int k2=0, j2=0, carroTotal2=0;
+int j2=0, carroTotal2=0;
 int idoso2 = 2, pcd2 = 2, normal2 = 5, fechado2=0;
-int anteriorSomaValores2 = 0;
 
 #define tamVetorEnviar 23
 #define tamVetorReceber 5
 
-int parametros2[tamVetorEnviar];
+int parametros2[tamVetorEnviar + PASSAGEM_NUM_CONTADORES];   // Estado + passagens por par de andares
 int recebe2[tamVetorReceber];
 
 // Função para inicializar todas as vagas como vazias
 void inicializarVagas2(vaga *v){
     printf("Inicializando 2º andar - Todas as vagas vazias\n");
     for(int i = 0; i < 8; i++){
-        v[i].ocupado = 0;
-        v[i].boolocupado = 0;
         v[i].ncarro = 0;
         v[i].tempo = 0;
     }
-    t.somaValores = 0;
-    t.somaVagas = 0;
-    anteriorSomaValores2 = 0;
+    ocupadas2 = 0;
+    ignoradas2 = 0;
+    varredura_parametros_do_ambiente(&ritmoAndar2, &calibracaoAndar2);
+    varredura_init(&varredura2, &andar2Vagas, &ritmoAndar2, &calibracaoAndar2);
+    filtro_vagas_config_do_ambiente(&filtroAndar2Config);
+    filtro_vagas_init(&filtro2, &filtroAndar2Config, andar2Vagas.num_vagas);
     printf("2º andar inicializado com sucesso - 8 vagas disponíveis\n");
 }
 
@@ -99,32 +120,15 @@ int separaIguala2(){
     parametros2[0]  = pcd2;
     parametros2[1]  = idoso2;
     parametros2[2]  = normal2;
-    parametros2[3]  = b[0].boolocupado;
-    parametros2[4]  = b[1].boolocupado;
-    parametros2[5]  = b[2].boolocupado;
-    parametros2[6]  = b[3].boolocupado;
-    parametros2[7]  = b[4].boolocupado;
-    parametros2[8]  = b[5].boolocupado;
-    parametros2[9]  = b[6].boolocupado;
-    parametros2[10] = b[7].boolocupado;
+    for(int i = 0; i < andar2Vagas.num_vagas; i++){
+        parametros2[3 + i] = (ocupadas2 & MAPA_VAGA(i)) != 0;
+    }
     parametros2[12] = recebe2[0];
-    parametros2[18] = t.somaVagas;
+    parametros2[18] = mapa_contar(ocupadas2);
     fechado2 = recebe2[3];
 }
 
-void vagasOcupadas2(vaga *v){
-    
-    t.somaValores = 0;
-    t.somaVagas = 0;
-    for(int i = 0; i<8; i++){
-        if(v[i].ocupado != 0){
-            t.somaVagas++;
-        }
-        t.somaValores += v[i].ocupado;
-    }
-}
-
-void * vagasDisponiveis2(vaga *p){
+void * vagasDisponiveis2(){
     // Se o 2º andar está fechado, todas as vagas são consideradas indisponíveis
     if(fechado2 == 1){
         idoso2 = 0;
@@ -133,40 +137,10 @@ void * vagasDisponiveis2(vaga *p){
         return NULL;
     }
     
-    idoso2 = 2;
-    pcd2 = 1;
-    normal2 = 5;
-    
-        for(int i=3; i<8; i++){
-            if(p[i].ocupado > 0)
-                p[i].boolocupado = 1;
-            
-            else if(p[i].ocupado == 0)
-                p[i].boolocupado=0;
-            normal2 -= p[i].boolocupado;
-        }
-        for(int i=1; i<3; i++){
-            if(p[i].ocupado > 0)
-                p[i].boolocupado = 1;
-            
-            else if(p[i].ocupado == 0)
-                p[i].boolocupado=0;
-            
-            idoso2 -= p[i].boolocupado;
-        }
-        
-        if(p[0].ocupado > 0){
-            pcd2=0;
-            p[0].boolocupado = 1;
-        }
-        else if(p[0].ocupado == 0) {
-            pcd2=1;
-            p[0].boolocupado = 0;
-        }
-}
-
-int mudancaEstadoVaga2( int anteriorSomaValores1){
-    return anteriorSomaValores2-t.somaValores; 
+    pcd2 = varredura_livres(&varredura2, ocupadas2, VAGA_PCD);
+    idoso2 = varredura_livres(&varredura2, ocupadas2, VAGA_IDOSO);
+    normal2 = varredura_livres(&varredura2, ocupadas2, VAGA_COMUM);
+    return NULL;
 }
 
 int timediff2(struct timeval entrada, struct timeval saida){ 
@@ -175,7 +149,7 @@ int timediff2(struct timeval entrada, struct timeval saida){
 
 void pagamento2(int g, vaga *a){
     
-    gettimeofday(&a[g-1].hsaida,0);
+    relogio_gettimeofday(&a[g-1].hsaida);
     // Calcula tempo em segundos e arredonda para cima em minutos
     int segundos = timediff2(a[g-1].hent,a[g-1].hsaida);
     int minutos = (segundos + 59) / 60; // Arredonda para cima: qualquer fração = 1 minuto
@@ -187,151 +161,72 @@ void pagamento2(int g, vaga *a){
     parametros2[15]=a[g-1].ncarro;
     parametros2[16]=minutos;
     parametros2[17]=g;
-    delay(100);  // ✅ REDUZIDO: 100ms para atualização mais rápida
+    hal_delay(100);  // ✅ REDUZIDO: 100ms para atualização mais rápida
     parametros2[14]=0;
 }
 
 void buscaCarro2(int f , vaga *a){
-    f *= -1;
     a[f-1].ncarro = parametros2[12];
-    gettimeofday(&a[f-1].hent,0);
+    relogio_gettimeofday(&a[f-1].hent);
     parametros2[11] = 1;
     parametros2[13] = f;
-    delay(1000);
+    hal_delay(1000);
     parametros2[11] = 0;
 }
 
 void leituraVagasAndar2(vaga *b){
-    k2=0;       
-    t.somaVagas = 0;
-    t.somaValores = 0;
+    ocupadas2 = 0;
+    ignoradas2 = 0;
 
     while(1){
     
-        delay(50);
-        vagasOcupadas2(b);
-        vagasDisponiveis2(b);
+        varredura_aguardar(&varredura2);
+        vagasDisponiveis2();
         separaIguala2();
-        //Primeira vaga
-        bcm2835_gpio_write(ENDERECO_01, LOW);
-        bcm2835_gpio_write(ENDERECO_02, LOW);
-        bcm2835_gpio_write(ENDERECO_03, LOW);
-        delay(50);
-        valor2 = bcm2835_gpio_lev(SENSOR_DE_VAGA);
-        if(valor2 == 1)
-            b[0].ocupado = 1;
-            
-        else if(valor2 == 0) 
-            b[0].ocupado = 0;
-        
-        //Segunda vaga
-        bcm2835_gpio_write(ENDERECO_01, HIGH);
-        bcm2835_gpio_write(ENDERECO_02, LOW);
-        bcm2835_gpio_write(ENDERECO_03, LOW);
-        delay(50);
-        valor2 = bcm2835_gpio_lev(SENSOR_DE_VAGA);
-        if(valor2 == 1)
-            b[1].ocupado = 2;
-        else if(valor2 == 0) 
-            b[1].ocupado = 0;
-
-        //Terceira vaga
-        bcm2835_gpio_write(ENDERECO_01, LOW);
-        bcm2835_gpio_write(ENDERECO_02, HIGH);
-        bcm2835_gpio_write(ENDERECO_03, LOW);
-        delay(50);
-        valor2 = bcm2835_gpio_lev(SENSOR_DE_VAGA);
-        if(valor2 == 1)
-            b[2].ocupado = 3;
-        else if(valor2 == 0) 
-            b[2].ocupado = 0;        
-
-        //Quarta vaga
-        bcm2835_gpio_write(ENDERECO_01, HIGH);
-        bcm2835_gpio_write(ENDERECO_02, HIGH);
-        bcm2835_gpio_write(ENDERECO_03, LOW);
-        delay(50);
-        valor2 = bcm2835_gpio_lev(SENSOR_DE_VAGA);
-        if(valor2 == 1)
-            b[3].ocupado = 4;
-        else if(valor2 == 0) 
-            b[3].ocupado = 0;        
-
-        //Quinta vaga
-        bcm2835_gpio_write(ENDERECO_01, LOW);
-        bcm2835_gpio_write(ENDERECO_02, LOW);
-        bcm2835_gpio_write(ENDERECO_03, HIGH);
-        delay(50);
-        valor2 = bcm2835_gpio_lev(SENSOR_DE_VAGA);
-        if(valor2 == 1)
-            b[4].ocupado = 5;
-        else if(valor2 == 0) 
-            b[4].ocupado = 0;        
-
-        //Sexta vaga
-        bcm2835_gpio_write(ENDERECO_01, HIGH);
-        bcm2835_gpio_write(ENDERECO_02, LOW);
-        bcm2835_gpio_write(ENDERECO_03, HIGH);
-        delay(50);
-        valor2 = bcm2835_gpio_lev(SENSOR_DE_VAGA);
-        if(valor2 == 1)
-            b[5].ocupado = 6;
-        else if(valor2 == 0) 
-            b[5].ocupado = 0;        
-
-        //Sétima vaga
-        bcm2835_gpio_write(ENDERECO_01, LOW);
-        bcm2835_gpio_write(ENDERECO_02, HIGH);
-        bcm2835_gpio_write(ENDERECO_03, HIGH);
-        delay(50);
-        valor2 = bcm2835_gpio_lev(SENSOR_DE_VAGA);
-        if(valor2 == 1)
-            b[6].ocupado = 7;
-        else if(valor2 == 0) 
-            b[6].ocupado = 0;
-
-        //Oitava vaga
-        bcm2835_gpio_write(ENDERECO_01, HIGH);
-        bcm2835_gpio_write(ENDERECO_02, HIGH);
-        bcm2835_gpio_write(ENDERECO_03, HIGH);
-        delay(50);
-        valor2 = bcm2835_gpio_lev(SENSOR_DE_VAGA);
-        if(valor2 == 1)
-            b[7].ocupado = 8;
-        else if(valor2 == 0) 
-            b[7].ocupado = 0;
-
-//-------------------------------------------------------------//
-        k2 = mudancaEstadoVaga2(anteriorSomaValores2);
-        if(k2>0 && k2<9){
-            pagamento2(k2, b);
-            
-        }else if(k2<0 && k2>-9){
+        // Lê as 8 vagas pelo multiplexador, filtra o ruído e trata cada vaga que mudou
+        MapaVagas lidas = filtro_vagas_aplicar(&filtro2, varredura_executar(&varredura2), relogio_agora_ms());
+        MapaVagas mudancas = lidas ^ (ocupadas2 | ignoradas2);
+        // Vaga mudando (ou ainda em confirmação no filtro): mantém o ritmo rápido
+        if(mudancas || filtro2.pendentes){
+            varredura_atividade(&varredura2, "vaga");
+        }
+        int i;
+        while((i = mapa_retirar(&mudancas)) >= 0){
+            if(!(lidas & MAPA_VAGA(i))){
+                if(ignoradas2 & MAPA_VAGA(i)){
+                    ignoradas2 &= ~MAPA_VAGA(i);     // Nunca foi registrada: nada a cobrar
+                } else {
+                    ocupadas2 &= ~MAPA_VAGA(i);
+                    varredura_registrar_publicacao(&varredura2, filtro_vagas_atraso_ms(&filtro2, i, relogio_agora_ms()));
+                    pagamento2(i + 1, b);
+                }
             // ✅ BLOQUEIO: Só permite estacionar se o andar NÃO está fechado
-            if(fechado2 == 0){
-                buscaCarro2(k2, b);
+            } else if(fechado2 == 0){
+                ocupadas2 |= MAPA_VAGA(i);
+                varredura_registrar_publicacao(&varredura2, filtro_vagas_atraso_ms(&filtro2, i, relogio_agora_ms()));
+                buscaCarro2(i + 1, b);
             } else {
-                printf("[2º Andar] 🚫 Vaga %d IGNORADA - Andar está bloqueado\n", k2 * -1);
-                // Reseta a vaga para evitar registro fantasma
-                b[(k2 * -1) - 1].ocupado = 0;
+                printf("[2º Andar] 🚫 Vaga %d IGNORADA - Andar está bloqueado\n", i + 1);
+                // Marca a vaga para evitar registro fantasma
+                ignoradas2 |= MAPA_VAGA(i);
             }
-        } 
-        anteriorSomaValores2 = t.somaValores;
+        }
         
-        if(t.somaVagas < 8 && fechado2 == 0){
-            bcm2835_gpio_write(SINAL_DE_LOTADO_FECHADO2, LOW);
+        int somaVagas2 = mapa_contar(ocupadas2);
+        if(somaVagas2 < 8 && fechado2 == 0){
+            hal_gpio_write(SINAL_DE_LOTADO_FECHADO2, LOW);
             parametros2[20] = 0;
         }
-        else if(t.somaVagas==8){
-            bcm2835_gpio_write(SINAL_DE_LOTADO_FECHADO2, HIGH);
+        else if(somaVagas2==8){
+            hal_gpio_write(SINAL_DE_LOTADO_FECHADO2, HIGH);
             parametros2[20] = 1;
         } 
         else if(fechado2 == 1){
-            bcm2835_gpio_write(SINAL_DE_LOTADO_FECHADO2, HIGH);
+            hal_gpio_write(SINAL_DE_LOTADO_FECHADO2, HIGH);
             parametros2[20] = 1;
         } 
         else if(fechado2 == 0 ) {
-            bcm2835_gpio_write(SINAL_DE_LOTADO_FECHADO2, LOW);
+            hal_gpio_write(SINAL_DE_LOTADO_FECHADO2, LOW);
             parametros2[20] = 0;
         }
     }
@@ -341,84 +236,46 @@ void *chamaLeitura2(){
     leituraVagasAndar2(b);
 }
 
+/**
+ * @brief Aviso das rampas do 2º Andar: carro entrando numa rampa ou passagem concluída
+ */
+void publicarPassagemB(const RampaConfig *rampa, ResultadoPassagem resultado, const Passagem *p){
+    if(resultado == PASSAGEM_INICIO){
+        varredura_atividade(&varredura2, "passagem");
+        return;
+    }
+    
+    const char *origem = passagem_nome_andar(p->andar_origem);
+    const char *destino = passagem_nome_andar(p->andar_destino);
+    // ✅ BLOQUEIO: com o 2º Andar fechado, a chegada ao andar não é registrada
+    if(p->andar_destino == 2 && fechado2 == 1){
+        printf("[2º Andar] 🚫 BLOQUEADO - Passagem %s → %s ignorada (andar fechado)\n", origem, destino);
+        return;
+    }
+    bool sobe = p->direcao == PASSAGEM_SOBE;
+    printf("[2º Andar] %s %s: %s → %s (%s, travessia %.0f ms, %.1f km/h)\n",
+           sobe ? "↑" : "↓", sobe ? "SUBINDO" : "DESCENDO",
+           origem, destino, rampa->nome, p->travessia_ms, p->velocidade_kmh);
+    if(sobe){
+        parametros2[21]++;
+    } else {
+        parametros2[22]++;
+    }
+    parametros2[tamVetorEnviar + PASSAGEM_INDICE(p->andar_origem, p->andar_destino)]++;
+}
+
 /**
  * @brief Thread que detecta passagem de carros entre andares no 2º Andar
  * 
- * Lógica de detecção:
- * - SENSOR_1 ativado primeiro, depois SENSOR_2: Carro SUBINDO (1º Andar → 2º Andar)
- * - SENSOR_2 ativado primeiro, depois SENSOR_1: Carro DESCENDO (2º Andar → 1º Andar)
- * 
- * Registra no array parametros2[21] e parametros2[22]:
- * - parametros2[21] = direção (1 = subindo, 2 = descendo)
- * - parametros2[22] = flag de evento (1 = passagem detectada, 0 = sem evento)
+ * Vigia todas as rampas de rampasB numa só thread (passagem_monitorar), sem
+ * bloquear entre um carro e outro. Publica contadores acumulados para o Central
+ * não perder passagens seguidas:
+ * - parametros2[21] = subidas, parametros2[22] = descidas (todas as rampas)
+ * - parametros2[tamVetorEnviar + PASSAGEM_INDICE(origem, destino)] = passagens por par de andares
  */
 void *sensorPassagemB(){
     printf("[2º Andar] Thread de detecção de passagem iniciada\n");
-    
-    int sensor1_anterior = 0;
-    int sensor2_anterior = 0;
-    int sensor1_ativo = 0;
-    int sensor2_ativo = 0;
-    int primeiro_sensor = 0;  // 1 = sensor1 ativou primeiro, 2 = sensor2 ativou primeiro
-    
-    while(1){
-        // Lê os sensores
-        sensor1_ativo = bcm2835_gpio_lev(SENSOR_DE_PASSAGEM_1);
-        sensor2_ativo = bcm2835_gpio_lev(SENSOR_DE_PASSAGEM_2);
-        
-        // Detecta qual sensor ativou primeiro (borda de subida)
-        if(sensor1_ativo == 1 && sensor1_anterior == 0 && primeiro_sensor == 0){
-            // Sensor 1 ativou primeiro
-            primeiro_sensor = 1;
-            printf("[2º Andar] Sensor 1 detectou presença\n");
-        }
-        else if(sensor2_ativo == 1 && sensor2_anterior == 0 && primeiro_sensor == 0){
-            // Sensor 2 ativou primeiro
-            primeiro_sensor = 2;
-            printf("[2º Andar] Sensor 2 detectou presença\n");
-        }
-        
-        // Detecta a direção completa
-        if(primeiro_sensor == 1 && sensor2_ativo == 1){
-            // ✅ BLOQUEIO: Verifica se o 2º andar está fechado ANTES de permitir subida
-            if(fechado2 == 1){
-                printf("[2º Andar] 🚫 BLOQUEADO - Impedindo subida (andar fechado)\n");
-                primeiro_sensor = 0;  // Reseta para evitar loop
-                delay(1000);  // Aguarda carro retornar
-            } else {
-                // Sensor 1 → Sensor 2: Carro SUBINDO (1º Andar → 2º Andar)
-                printf("[2º Andar] ↑ SUBINDO: 1º Andar → 2º Andar\n");
-                parametros2[21] = 1;  // 1 = subindo
-                parametros2[22] = 1;  // Flag de evento
-                
-                delay(1000);  // Aguarda passagem completa
-                parametros2[22] = 0;  // Reseta flag
-                primeiro_sensor = 0;
-            }
-        }
-        else if(primeiro_sensor == 2 && sensor1_ativo == 1){
-            // Sensor 2 → Sensor 1: Carro DESCENDO (2º Andar → 1º Andar)
-            printf("[2º Andar] ↓ DESCENDO: 2º Andar → 1º Andar\n");
-            parametros2[21] = 2;  // 2 = descendo
-            parametros2[22] = 1;  // Flag de evento
-            
-            delay(1000);  // Aguarda passagem completa
-            parametros2[22] = 0;  // Reseta flag
-            primeiro_sensor = 0;
-        }
-        
-        // Reseta se ambos os sensores desativarem
-        if(sensor1_ativo == 0 && sensor2_ativo == 0){
-            primeiro_sensor = 0;
-        }
-        
-        // Atualiza estados anteriores
-        sensor1_anterior = sensor1_ativo;
-        sensor2_anterior = sensor2_ativo;
-        
-        delay(50);  // Polling rápido para não perder eventos
-    }
-    
+    passagem_monitorar(rampasB, sizeof(rampasB) / sizeof(rampasB[0]), publicarPassagemB);
     return NULL;
 }
 
@@ -443,17 +300,30 @@ void *enviaParametros2(){
     addr.sin_addr.s_addr = inet_addr(ip);
     connect(sock, (struct sockaddr*)&addr, sizeof(addr));
     printf("Connected to Server\n");
+    int carrosAnterior = 0;
+    double ultimoRelatorio = relogio_agora_ms();
     while(1){
-        send (sock, parametros2, tamVetorEnviar *sizeof(int) , 0);
+        relogio_liberar_thread();   // Espera o Central no socket: não segura o relógio virtual
+        send (sock, parametros2, (tamVetorEnviar + PASSAGEM_NUM_CONTADORES) * sizeof(int), 0);
         recv(sock, recebe2, tamVetorReceber * sizeof(int), 0);
-        delay(1000);
+        // recebe[0] = carros que já entraram: um carro novo pode estar subindo
+        if(recebe2[0] != carrosAnterior){
+            carrosAnterior = recebe2[0];
+            varredura_atividade(&varredura2, "entrada no estacionamento");
+        }
+        // Relatório periódico dos tempos do laço de varredura
+        if(relogio_agora_ms() - ultimoRelatorio >= ritmoAndar2.relatorio_s * 1000.0){
+            ultimoRelatorio = relogio_agora_ms();
+            varredura_imprimir_estatisticas(&varredura2);
+        }
+        hal_delay(1000);
     }
     close(sock);
     printf("Disconnected from server\n");
 }
 
 int mainD(){
-   if (!bcm2835_init())
+   if (!hal_gpio_init(HAL_PLACA_ANDAR2))
         return 1;
     configuraPinos2();
     
@@ -464,7 +334,7 @@ int mainD(){
     
     // Aguarda 2 segundos para estabilizar os sensores
     printf("Aguardando estabilização dos sensores...\n");
-    delay(2000);
+    hal_delay(2000);
     
     pthread_t fLeituraVagas2, fEnviaParametros2, fPassagemAndar2;
     
@@ -472,10 +342,11 @@ int mainD(){
     pthread_create(&fEnviaParametros2, NULL, enviaParametros2, NULL);
     pthread_create(&fPassagemAndar2, NULL, sensorPassagemB, NULL);  // ✅ Ativado
     
+    relogio_liberar_thread();    // A thread principal só espera as outras
     pthread_join(fLeituraVagas2, NULL);
     pthread_join(fEnviaParametros2, NULL);
     pthread_join(fPassagemAndar2, NULL);  // ✅ Ativado
 
-    bcm2835_close();
+    hal_gpio_close();
     return 0;
 }
@@ -0,0 +1,421 @@
+#include "../inc/barramento.h"
+#include "../inc/modbus.h"
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <errno.h>
+#include <limits.h>
+
+// Porta serial e thread dona do barramento
+static int fd_barramento = -1;
+static pthread_t thread_barramento;
+static volatile bool barramento_rodando = false;
+
+// Filas circulares, uma por prioridade
+static BarramentoPedido *filas[BARRAMENTO_NUM_PRIORIDADES][BARRAMENTO_TAM_FILA];
+static int fila_inicio[BARRAMENTO_NUM_PRIORIDADES];
+static int fila_tamanho[BARRAMENTO_NUM_PRIORIDADES];
+
+static pthread_mutex_t mutex_barramento = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cond_fila = PTHREAD_COND_INITIALIZER;        // Novo pedido na fila
+static pthread_cond_t cond_concluido = PTHREAD_COND_INITIALIZER;   // Algum pedido terminou
+
+// Pedido no fio (NULL durante as sondagens), lido pelo orçamento da transação
+static BarramentoPedido *pedido_atual = NULL;
+
+static BarramentoEstatisticas estatisticas;
+static struct timespec inicio_barramento;
+
+// Prioridades definidas por barramento_definir_prioridade (0 = padrão, senão prioridade + 1)
+static uint8_t prioridade_escravo[256];
+
+static const char *nomes_prioridade[BARRAMENTO_NUM_PRIORIDADES] = {
+    "LPR Entrada", "LPR Saída", "Placar"
+};
+
+/**
+ * @brief Diferença entre dois instantes em milissegundos
+ */
+static double diff_ms(struct timespec a, struct timespec b) {
+    return (b.tv_sec - a.tv_sec) * 1000.0 + (b.tv_nsec - a.tv_nsec) / 1000000.0;
+}
+
+/**
+ * @brief Soma milissegundos a um instante
+ */
+static struct timespec soma_ms(struct timespec t, int ms) {
+    t.tv_sec += ms / 1000;
+    t.tv_nsec += (long)(ms % 1000) * 1000000L;
+    if (t.tv_nsec >= 1000000000L) {
+        t.tv_sec++;
+        t.tv_nsec -= 1000000000L;
+    }
+    return t;
+}
+
+/**
+ * @brief Retira o próximo pedido (maior prioridade, FIFO dentro da prioridade)
+ * @note Deve ser chamada com mutex_barramento travado
+ */
+static BarramentoPedido *retirar_proximo() {
+    for (int p = 0; p < BARRAMENTO_NUM_PRIORIDADES; p++) {
+        if (fila_tamanho[p] > 0) {
+            BarramentoPedido *pedido = filas[p][fila_inicio[p]];
+            fila_inicio[p] = (fila_inicio[p] + 1) % BARRAMENTO_TAM_FILA;
+            fila_tamanho[p]--;
+            return pedido;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Orçamento da transação em andamento (ver ModbusOrcamento)
+ * 
+ * O limite é o deadline mais próximo entre o pedido atual e os pedidos ainda
+ * válidos na fila de mesma prioridade ou mais urgentes; pedidos menos urgentes
+ * não encurtam a transação. Um pedido de prioridade maior esperando zera o
+ * orçamento, de modo que os retries do placar (e as sondagens, que não têm
+ * prioridade) cedem o fio às câmeras.
+ */
+static int orcamento_transacao(void) {
+    struct timespec agora;
+    clock_gettime(CLOCK_MONOTONIC, &agora);
+
+    pthread_mutex_lock(&mutex_barramento);
+    int prioridade = pedido_atual ? pedido_atual->prioridade : BARRAMENTO_NUM_PRIORIDADES;
+    double restante_ms = pedido_atual ? diff_ms(agora, pedido_atual->deadline) : INT_MAX;
+
+    for (int p = 0; p < BARRAMENTO_NUM_PRIORIDADES && p <= prioridade; p++) {
+        if (p < prioridade && fila_tamanho[p] > 0) {
+            restante_ms = 0;
+            break;
+        }
+        for (int i = 0; i < fila_tamanho[p]; i++) {
+            BarramentoPedido *na_fila = filas[p][(fila_inicio[p] + i) % BARRAMENTO_TAM_FILA];
+            double folga_ms = diff_ms(agora, na_fila->deadline);
+            // Pedidos já vencidos serão descartados na retirada: não limitam ninguém
+            if (folga_ms > 0 && folga_ms < restante_ms) {
+                restante_ms = folga_ms;
+            }
+        }
+    }
+    pthread_mutex_unlock(&mutex_barramento);
+
+    return (restante_ms > 0) ? (int)restante_ms : 0;
+}
+
+/**
+ * @brief Marca o pedido como concluído, acorda quem espera e chama o callback
+ */
+static void concluir_pedido(BarramentoPedido *pedido, bool sucesso, bool expirado) {
+    BarramentoCallback callback = pedido->callback;
+
+    pthread_mutex_lock(&mutex_barramento);
+    pedido->sucesso = sucesso;
+    pedido->expirado = expirado;
+    pedido->concluido = true;
+    pthread_cond_broadcast(&cond_concluido);
+    pthread_mutex_unlock(&mutex_barramento);
+
+    if (callback) {
+        callback(pedido);
+    }
+}
+
+/**
+ * @brief Thread dona da porta serial: executa os pedidos em ordem de prioridade
+ */
+static void *thread_dona_barramento(void *arg) {
+    (void)arg;
+    struct timespec ultimo_relatorio;
+    clock_gettime(CLOCK_MONOTONIC, &ultimo_relatorio);
+
+    printf("[BARRAMENTO] Thread dona do barramento iniciada\n");
+
+    while (1) {
+        pthread_mutex_lock(&mutex_barramento);
+
+        BarramentoPedido *pedido = NULL;
+        while (barramento_rodando && (pedido = retirar_proximo()) == NULL) {
+            // Acorda periodicamente para o relatório de ocupação
+            struct timespec limite;
+            clock_gettime(CLOCK_REALTIME, &limite);
+            limite.tv_sec += 1;
+            pthread_cond_timedwait(&cond_fila, &mutex_barramento, &limite);
+
+            // Barramento ocioso: sonda dispositivos fora do ar
+            if (barramento_rodando && fila_tamanho[BARRAMENTO_PRIO_LPR_ENTRADA] == 0 &&
+                fila_tamanho[BARRAMENTO_PRIO_LPR_SAIDA] == 0) {
+                pthread_mutex_unlock(&mutex_barramento);
+                modbus_sondar_escravos(fd_barramento, orcamento_transacao);
+                pthread_mutex_lock(&mutex_barramento);
+            }
+
+            struct timespec agora;
+            clock_gettime(CLOCK_MONOTONIC, &agora);
+            if (diff_ms(ultimo_relatorio, agora) >= BARRAMENTO_RELATORIO_S * 1000.0) {
+                pthread_mutex_unlock(&mutex_barramento);
+                barramento_imprimir_estatisticas();
+                modbus_estatisticas_imprimir();
+                lpr_imprimir_tempos();
+                pthread_mutex_lock(&mutex_barramento);
+                ultimo_relatorio = agora;
+            }
+        }
+
+        if (!barramento_rodando) {
+            // Encerrando: falha os pedidos que ainda estão na fila
+            while ((pedido = retirar_proximo()) != NULL) {
+                pthread_mutex_unlock(&mutex_barramento);
+                concluir_pedido(pedido, false, true);
+                pthread_mutex_lock(&mutex_barramento);
+            }
+            pthread_mutex_unlock(&mutex_barramento);
+            break;
+        }
+        pedido_atual = pedido;
+        pthread_mutex_unlock(&mutex_barramento);
+
+        int p = pedido->prioridade;
+        struct timespec inicio, fim;
+        clock_gettime(CLOCK_MONOTONIC, &inicio);
+        double espera_ms = diff_ms(pedido->submetido, inicio);
+
+        // Pedido velho demais: descarta sem ocupar o fio
+        if (diff_ms(pedido->deadline, inicio) > 0) {
+            fprintf(stderr, "[BARRAMENTO] Pedido %s expirou na fila (%.0f ms)\n",
+                    nomes_prioridade[p], espera_ms);
+            pthread_mutex_lock(&mutex_barramento);
+            estatisticas.expirados[p]++;
+            pedido_atual = NULL;
+            pthread_mutex_unlock(&mutex_barramento);
+            concluir_pedido(pedido, false, true);
+            continue;
+        }
+
+        bool sucesso = modbus_transacao_direta(fd_barramento, pedido->request, pedido->req_len,
+                                               pedido->response, pedido->resp_len, pedido->rotulo,
+                                               orcamento_transacao);
+        clock_gettime(CLOCK_MONOTONIC, &fim);
+
+        pthread_mutex_lock(&mutex_barramento);
+        pedido_atual = NULL;
+        estatisticas.executados[p]++;
+        if (!sucesso) {
+            estatisticas.falhas[p]++;
+        }
+        if (espera_ms > estatisticas.espera_max_ms[p]) {
+            estatisticas.espera_max_ms[p] = espera_ms;
+        }
+        estatisticas.ocupado_ms += diff_ms(inicio, fim);
+        pthread_mutex_unlock(&mutex_barramento);
+
+        concluir_pedido(pedido, sucesso, false);
+    }
+
+    printf("[BARRAMENTO] Thread dona do barramento finalizada\n");
+    return NULL;
+}
+
+/**
+ * @brief Abre a porta serial e inicia a thread dona do barramento
+ */
+bool barramento_init(const char *porta) {
+    pthread_mutex_lock(&mutex_barramento);
+
+    if (barramento_rodando) {
+        pthread_mutex_unlock(&mutex_barramento);
+        return true;
+    }
+
+    fd_barramento = modbus_init(porta);
+    if (fd_barramento < 0) {
+        pthread_mutex_unlock(&mutex_barramento);
+        fprintf(stderr, "[BARRAMENTO] Não foi possível abrir %s\n", porta);
+        return false;
+    }
+
+    memset(&estatisticas, 0, sizeof(estatisticas));
+    memset(fila_inicio, 0, sizeof(fila_inicio));
+    memset(fila_tamanho, 0, sizeof(fila_tamanho));
+    clock_gettime(CLOCK_MONOTONIC, &inicio_barramento);
+    barramento_rodando = true;
+
+    if (pthread_create(&thread_barramento, NULL, thread_dona_barramento, NULL) != 0) {
+        fprintf(stderr, "[BARRAMENTO] Erro ao criar thread: %s\n", strerror(errno));
+        barramento_rodando = false;
+        modbus_close(fd_barramento);
+        fd_barramento = -1;
+        pthread_mutex_unlock(&mutex_barramento);
+        return false;
+    }
+
+    pthread_mutex_unlock(&mutex_barramento);
+    printf("[BARRAMENTO] ✅ Barramento RS485 ativo em %s (LPR Entrada > LPR Saída > Placar)\n", porta);
+    return true;
+}
+
+/**
+ * @brief Para a thread do barramento e fecha a porta serial
+ */
+void barramento_finalizar() {
+    pthread_mutex_lock(&mutex_barramento);
+    if (!barramento_rodando) {
+        pthread_mutex_unlock(&mutex_barramento);
+        return;
+    }
+    barramento_rodando = false;
+    pthread_cond_broadcast(&cond_fila);
+    pthread_mutex_unlock(&mutex_barramento);
+
+    pthread_join(thread_barramento, NULL);
+    barramento_imprimir_estatisticas();
+    modbus_estatisticas_imprimir();
+    lpr_imprimir_tempos();
+
+    modbus_close(fd_barramento);
+    fd_barramento = -1;
+}
+
+/**
+ * @brief Retorna o file descriptor da porta do barramento
+ */
+int barramento_fd() {
+    return barramento_rodando ? fd_barramento : -1;
+}
+
+/**
+ * @brief Indica se uma transação em fd deve ser encaminhada ao árbitro
+ */
+bool barramento_deve_encaminhar(int fd) {
+    return barramento_rodando && fd == fd_barramento &&
+           !pthread_equal(pthread_self(), thread_barramento);
+}
+
+/**
+ * @brief Prioridade padrão de um escravo MODBUS
+ */
+BarramentoPrioridade barramento_prioridade_endereco(uint8_t slave_addr) {
+    if (prioridade_escravo[slave_addr]) {
+        return (BarramentoPrioridade)(prioridade_escravo[slave_addr] - 1);
+    }
+    switch (slave_addr) {
+        case MODBUS_ADDR_LPR_ENTRADA: return BARRAMENTO_PRIO_LPR_ENTRADA;
+        case MODBUS_ADDR_LPR_SAIDA:   return BARRAMENTO_PRIO_LPR_SAIDA;
+        default:                      return BARRAMENTO_PRIO_PLACAR;
+    }
+}
+
+/**
+ * @brief Define a prioridade de um escravo
+ */
+void barramento_definir_prioridade(uint8_t slave_addr, BarramentoPrioridade prioridade) {
+    prioridade_escravo[slave_addr] = (uint8_t)prioridade + 1;
+}
+
+/**
+ * @brief Preenche um pedido com prioridade e deadline padrão do escravo
+ */
+void barramento_preparar_pedido(BarramentoPedido *pedido, uint8_t *request, int req_len,
+                                uint8_t *response, int resp_len, const char *rotulo) {
+    memset(pedido, 0, sizeof(*pedido));
+    pedido->request = request;
+    pedido->req_len = req_len;
+    pedido->response = response;
+    pedido->resp_len = resp_len;
+    pedido->rotulo = rotulo;
+    pedido->prioridade = barramento_prioridade_endereco(request[0]);
+
+    int deadline_ms = (pedido->prioridade == BARRAMENTO_PRIO_PLACAR)
+                      ? BARRAMENTO_DEADLINE_PLACAR_MS : BARRAMENTO_DEADLINE_LPR_MS;
+    clock_gettime(CLOCK_MONOTONIC, &pedido->submetido);
+    pedido->deadline = soma_ms(pedido->submetido, deadline_ms);
+}
+
+/**
+ * @brief Coloca o pedido na fila sem bloquear
+ */
+bool barramento_submeter(BarramentoPedido *pedido) {
+    int p = pedido->prioridade;
+
+    pthread_mutex_lock(&mutex_barramento);
+
+    if (!barramento_rodando || fila_tamanho[p] >= BARRAMENTO_TAM_FILA) {
+        if (barramento_rodando) {
+            estatisticas.rejeitados[p]++;
+        }
+        pthread_mutex_unlock(&mutex_barramento);
+        fprintf(stderr, "[BARRAMENTO] Pedido %s rejeitado (fila cheia ou barramento inativo)\n",
+                nomes_prioridade[p]);
+        return false;
+    }
+
+    pedido->concluido = false;
+    int pos = (fila_inicio[p] + fila_tamanho[p]) % BARRAMENTO_TAM_FILA;
+    filas[p][pos] = pedido;
+    fila_tamanho[p]++;
+
+    pthread_cond_signal(&cond_fila);
+    pthread_mutex_unlock(&mutex_barramento);
+    return true;
+}
+
+/**
+ * @brief Bloqueia até o pedido ser concluído
+ */
+bool barramento_aguardar(BarramentoPedido *pedido) {
+    pthread_mutex_lock(&mutex_barramento);
+    while (!pedido->concluido) {
+        pthread_cond_wait(&cond_concluido, &mutex_barramento);
+    }
+    bool sucesso = pedido->sucesso;
+    pthread_mutex_unlock(&mutex_barramento);
+    return sucesso;
+}
+
+/**
+ * @brief Submete e aguarda o pedido
+ */
+bool barramento_executar(BarramentoPedido *pedido) {
+    if (!barramento_submeter(pedido)) {
+        return false;
+    }
+    return barramento_aguardar(pedido);
+}
+
+/**
+ * @brief Copia as estatísticas acumuladas do barramento
+ */
+void barramento_obter_estatisticas(BarramentoEstatisticas *out) {
+    struct timespec agora;
+    clock_gettime(CLOCK_MONOTONIC, &agora);
+
+    pthread_mutex_lock(&mutex_barramento);
+    estatisticas.janela_ms = diff_ms(inicio_barramento, agora);
+    *out = estatisticas;
+    pthread_mutex_unlock(&mutex_barramento);
+}
+
+/**
+ * @brief Imprime ocupação do barramento e folga disponível
+ */
+void barramento_imprimir_estatisticas() {
+    static double ocupado_anterior = 0, janela_anterior = 0;
+    BarramentoEstatisticas e;
+    barramento_obter_estatisticas(&e);
+
+    double janela = e.janela_ms - janela_anterior;
+    double ocupado = e.ocupado_ms - ocupado_anterior;
+    double ocupacao = (janela > 0) ? 100.0 * ocupado / janela : 0;
+    ocupado_anterior = e.ocupado_ms;
+    janela_anterior = e.janela_ms;
+
+    printf("[BARRAMENTO] Ocupação: %.1f%% (folga %.1f%%) nos últimos %.0f s\n",
+           ocupacao, 100.0 - ocupacao, janela / 1000.0);
+    for (int p = 0; p < BARRAMENTO_NUM_PRIORIDADES; p++) {
+        printf("[BARRAMENTO]   %-11s executados=%lu falhas=%lu expirados=%lu rejeitados=%lu espera_max=%.1f ms\n",
+               nomes_prioridade[p], e.executados[p], e.falhas[p], e.expirados[p],
+               e.rejeitados[p], e.espera_max_ms[p]);
+    }
+}
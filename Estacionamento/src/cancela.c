@@ -0,0 +1,644 @@
+#include "../inc/cancela.h"
+#include "../inc/relogio.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Nome de um estado para o log
+ */
+const char *cancela_nome_estado(EstadoCancela estado) {
+    static const char *nomes[CANCELA_NUM_ESTADOS] = {
+        "ociosa", "lendo", "abrindo", "aberta", "passando", "fechando", "falha"
+    };
+    return (estado >= 0 && estado < CANCELA_NUM_ESTADOS) ? nomes[estado] : "?";
+}
+
+/**
+ * @brief Lê um tempo do ambiente; ausente ou inválido mantém o valor
+ * @param fator_ms Milissegundos por unidade da variável (1000 para segundos)
+ */
+static void ler_tempo(const char *nome, unsigned int fator_ms, unsigned int *valor) {
+    const char *texto = getenv(nome);
+    if (!texto || !texto[0]) {
+        return;
+    }
+    int n = atoi(texto);
+    if (n > 0) {
+        *valor = (unsigned int)n * fator_ms;
+    } else {
+        printf("[CANCELA] %s inválido '%s', usando %u ms\n", nome, texto, *valor);
+    }
+}
+
+/**
+ * @brief Aplica os tempos do config.env definidos no ambiente
+ */
+void cancela_tempos_do_ambiente(TemposCancela *t) {
+    ler_tempo("CANCELA_ABERTURA_MS", 1, &t->abertura_ms);
+    ler_tempo("CANCELA_FECHAMENTO_MS", 1, &t->fechamento_ms);
+    ler_tempo("CANCELA_TIMEOUT_ABERTURA", 1000, &t->timeout_aberta_ms);
+    ler_tempo("CANCELA_TIMEOUT_PASSAGEM", 1000, &t->timeout_passagem_ms);
+}
+
+/**
+ * @brief Prepara a cancela (motor desligado); as bordas são assinadas pelo trabalhador
+ */
+void cancela_init(Cancela *c, const CancelaConfig *cfg, CancelaCallback callback) {
+    memset(c, 0, sizeof(*c));
+    c->cfg = cfg;
+    c->callback = callback;
+    c->estado = CANCELA_OCIOSA;
+    c->desde_ms = relogio_agora_ms();
+    c->relatorio_ms = c->desde_ms;
+    c->abertura = hal_gpio_lev(cfg->sensor_abertura);
+    c->fechamento = hal_gpio_lev(cfg->sensor_fechamento);
+    pthread_mutex_init(&c->mutex, NULL);
+
+    for (int i = 0; i < CANCELA_NUM_ESTADOS; i++) {
+        histograma_init(&c->estatisticas.fases[i], CANCELA_HIST_BASE_US);
+    }
+    histograma_init(&c->estatisticas.atendimento, CANCELA_HIST_BASE_US);
+    histograma_init(&c->estatisticas.intervalo, CANCELA_HIST_BASE_US);
+
+    hal_gpio_write(cfg->motor, LOW);
+
+    printf("[CANCELA %s] Sensores %d/%d, motor %d, abertura %u ms, fechamento %u ms, "
+           "timeouts %u s aberta / %u s passando\n",
+           cfg->nome, cfg->sensor_abertura, cfg->sensor_fechamento, cfg->motor,
+           cfg->tempos.abertura_ms, cfg->tempos.fechamento_ms,
+           cfg->tempos.timeout_aberta_ms / 1000, cfg->tempos.timeout_passagem_ms / 1000);
+}
+
+/**
+ * @brief Troca de estado, registrando o tempo da fase que termina
+ */
+static void mudar(Cancela *c, EstadoCancela novo, double agora) {
+    double fase_ms = agora - c->desde_ms;
+
+    pthread_mutex_lock(&c->mutex);
+    histograma_registrar(&c->estatisticas.fases[c->estado], fase_ms * 1000.0);
+    c->estatisticas.estado = novo;
+    pthread_mutex_unlock(&c->mutex);
+
+    printf("[CANCELA %s] %s → %s (%.0f ms)\n", c->cfg->nome,
+           cancela_nome_estado(c->estado), cancela_nome_estado(novo), fase_ms);
+    c->estado = novo;
+    c->desde_ms = agora;
+}
+
+// ========== Fila de veículos da faixa ==========
+
+/**
+ * @brief Põe um veículo no fim da fila
+ * @return Veículo, ou NULL com a fila cheia
+ */
+static VeiculoCancela *enfileirar(Cancela *c, bool manual, double agora) {
+    if (c->num_fila == CANCELA_MAX_FILA) {
+        printf("[CANCELA %s] Fila cheia (%d carros) - chegada ignorada\n", c->cfg->nome, CANCELA_MAX_FILA);
+        pthread_mutex_lock(&c->mutex);
+        c->estatisticas.descartados++;
+        pthread_mutex_unlock(&c->mutex);
+        return NULL;
+    }
+
+    VeiculoCancela *v = &c->fila[c->num_fila++];
+    *v = (VeiculoCancela){ 0, manual, !manual, false, false, agora, 0 };
+    pthread_mutex_lock(&c->mutex);
+    c->estatisticas.chegadas++;
+    c->estatisticas.fila = c->num_fila;
+    if (c->num_fila > c->estatisticas.fila_max) {
+        c->estatisticas.fila_max = c->num_fila;
+    }
+    pthread_mutex_unlock(&c->mutex);
+    return v;
+}
+
+/**
+ * @brief Retira o veículo i da fila, mantendo a ordem
+ */
+static void retirar(Cancela *c, int i) {
+    memmove(&c->fila[i], &c->fila[i + 1], (c->num_fila - i - 1) * sizeof(c->fila[0]));
+    c->num_fila--;
+    pthread_mutex_lock(&c->mutex);
+    c->estatisticas.fila = c->num_fila;
+    pthread_mutex_unlock(&c->mutex);
+}
+
+/**
+ * @brief Pergunta ao nó se a cancela abre para o veículo (ticket, placa, lotação)
+ */
+static bool consultar(Cancela *c, VeiculoCancela *v, double agora) {
+    v->consulta_ms = agora;
+    v->autorizado = c->callback(c, CANCELA_AVISO_CHEGADA, v);
+    if (!v->autorizado && !v->recusado) {
+        v->recusado = true;
+        pthread_mutex_lock(&c->mutex);
+        c->estatisticas.recusas++;
+        pthread_mutex_unlock(&c->mutex);
+    }
+    return v->autorizado;
+}
+
+// ========== Ações ==========
+
+/**
+ * @brief Liga o motor para o primeiro da fila
+ */
+static void abrir(Cancela *c, double agora) {
+    hal_gpio_write(c->cfg->motor, HIGH);
+    mudar(c, CANCELA_ABRINDO, agora);
+    c->callback(c, CANCELA_AVISO_LIBERADA, &c->fila[0]);
+}
+
+/**
+ * @brief Desliga o motor e começa a descer
+ */
+static void fechar(Cancela *c, double agora) {
+    hal_gpio_write(c->cfg->motor, LOW);
+    mudar(c, CANCELA_FECHANDO, agora);
+    c->callback(c, CANCELA_AVISO_FECHANDO, NULL);
+}
+
+/**
+ * @brief Estados com a cancela em cima (ou subindo)
+ */
+static bool em_cima(EstadoCancela estado) {
+    return estado == CANCELA_ABRINDO || estado == CANCELA_ABERTA ||
+           estado == CANCELA_PASSANDO || estado == CANCELA_FALHA;
+}
+
+/**
+ * @brief Atende o primeiro da fila depois de uma passagem, desistência ou fechamento
+ */
+static void seguir(Cancela *c, double agora) {
+    VeiculoCancela *v = (c->num_fila > 0) ? &c->fila[0] : NULL;
+
+    if (em_cima(c->estado)) {
+        if (v && v->autorizado) {
+            // O próximo já foi lido e autorizado: a cancela fica em cima
+            hal_gpio_write(c->cfg->motor, HIGH);
+            if (c->estado == CANCELA_ABERTA) {
+                c->desde_ms = agora;
+            } else {
+                mudar(c, CANCELA_ABERTA, agora);
+            }
+            c->callback(c, CANCELA_AVISO_LIBERADA, v);
+        } else {
+            fechar(c, agora);
+        }
+        return;
+    }
+
+    if (!v) {
+        if (c->estado != CANCELA_OCIOSA) {
+            mudar(c, CANCELA_OCIOSA, agora);
+        }
+    } else if (v->autorizado) {
+        abrir(c, agora);
+    } else if (c->estado != CANCELA_LENDO) {
+        mudar(c, CANCELA_LENDO, agora);
+    }
+}
+
+/**
+ * @brief Primeiro da fila passou: avisa o nó e atende o próximo
+ */
+static void passou(Cancela *c, double agora) {
+    if (c->num_fila == 0) {
+        printf("[CANCELA %s] Passagem sem carro na fila - ignorada\n", c->cfg->nome);
+        seguir(c, agora);
+        return;
+    }
+
+    VeiculoCancela *v = &c->fila[0];
+    bool seguido = (c->num_fila > 1 && c->fila[1].autorizado);
+    pthread_mutex_lock(&c->mutex);
+    c->estatisticas.carros++;
+    if (seguido) {
+        c->estatisticas.seguidos++;
+    }
+    histograma_registrar(&c->estatisticas.atendimento, (agora - v->chegada_ms) * 1000.0);
+    if (c->ultima_passagem_ms > 0) {
+        histograma_registrar(&c->estatisticas.intervalo, (agora - c->ultima_passagem_ms) * 1000.0);
+    }
+    pthread_mutex_unlock(&c->mutex);
+    c->ultima_passagem_ms = agora;
+
+    c->callback(c, CANCELA_AVISO_PASSOU, v);
+    retirar(c, 0);
+    seguir(c, agora);
+}
+
+/**
+ * @brief Cancela parada em cima com o motor ligado até os sensores liberarem
+ */
+static void falhar(Cancela *c, const char *motivo, double agora) {
+    hal_gpio_write(c->cfg->motor, HIGH);
+    pthread_mutex_lock(&c->mutex);
+    c->estatisticas.falhas++;
+    pthread_mutex_unlock(&c->mutex);
+    printf("[CANCELA %s] Falha: %s - cancela mantida aberta\n", c->cfg->nome, motivo);
+    c->falha_origem = c->estado;
+    mudar(c, CANCELA_FALHA, agora);
+}
+
+// ========== Bordas ==========
+
+/**
+ * @brief Carro chegou ao sensor de abertura: entra na fila e é consultado na hora
+ */
+static void chegou(Cancela *c, double agora) {
+    // Carro do comando manual chegando ao sensor: não é um veículo novo
+    if (c->num_fila == 1 && c->fila[0].manual && !c->fila[0].visto && em_cima(c->estado)) {
+        c->fila[0].visto = true;
+        return;
+    }
+
+    bool ociosa = (c->estado == CANCELA_OCIOSA);
+    VeiculoCancela *v = enfileirar(c, false, agora);
+    if (!v) {
+        return;
+    }
+    if (ociosa) {
+        mudar(c, CANCELA_LENDO, agora);
+    }
+
+    // Com a cancela ocupada, a leitura deste carro corre durante a passagem do anterior
+    if (consultar(c, v, agora) && c->num_fila == 1 &&
+        (c->estado == CANCELA_LENDO || c->estado == CANCELA_FECHANDO)) {
+        abrir(c, agora);
+    }
+}
+
+/**
+ * @brief Sensor de abertura liberado: um carro recusado que dá ré sai da fila
+ */
+static void saiu_abertura(Cancela *c, double agora) {
+    if (c->num_fila == 0) {
+        return;
+    }
+    VeiculoCancela *v = &c->fila[c->num_fila - 1];
+    if (v->autorizado || v->manual) {
+        return;                             // Seguindo para a cancela
+    }
+
+    printf("[CANCELA %s] Carro foi embora sem passar\n", c->cfg->nome);
+    pthread_mutex_lock(&c->mutex);
+    c->estatisticas.desistencias++;
+    pthread_mutex_unlock(&c->mutex);
+    retirar(c, c->num_fila - 1);
+    if (c->estado == CANCELA_LENDO) {
+        seguir(c, agora);
+    }
+}
+
+/**
+ * @brief Processa uma borda de um dos sensores da cancela
+ */
+bool cancela_borda(Cancela *c, const HalGpioEvento *e) {
+    bool abertura = (e->pino == c->cfg->sensor_abertura);
+    if (!abertura && e->pino != c->cfg->sensor_fechamento) {
+        return false;
+    }
+    uint8_t *nivel = abertura ? &c->abertura : &c->fechamento;
+    if (e->nivel == *nivel) {
+        return true;                        // Borda repetida
+    }
+    *nivel = e->nivel;
+    double agora = relogio_agora_ms();      // Prazos no relógio do nó, não no do kernel
+
+    if (abertura) {
+        if (e->nivel == HIGH) {
+            chegou(c, agora);
+        } else {
+            saiu_abertura(c, agora);
+        }
+        return true;
+    }
+
+    switch (c->estado) {
+        case CANCELA_ABRINDO:
+        case CANCELA_ABERTA:
+            if (e->nivel == HIGH) {
+                mudar(c, CANCELA_PASSANDO, agora);
+            }
+            break;
+        case CANCELA_PASSANDO:
+            if (e->nivel == LOW) {
+                passou(c, agora);
+            }
+            break;
+        case CANCELA_FECHANDO:
+            // Carro entrou embaixo da cancela descendo: volta a subir
+            if (e->nivel == HIGH) {
+                printf("[CANCELA %s] Carro sob a cancela fechando - reabrindo\n", c->cfg->nome);
+                hal_gpio_write(c->cfg->motor, HIGH);
+                mudar(c, CANCELA_PASSANDO, agora);
+            }
+            break;
+        case CANCELA_FALHA:
+            // Carro avançou até o sensor de fechamento durante a falha: a saída
+            // da falha (em cancela_avancar) conta a passagem
+            if (e->nivel == HIGH) {
+                c->falha_origem = CANCELA_PASSANDO;
+            }
+            break;
+        default:
+            break;
+    }
+    return true;
+}
+
+// ========== Prazos ==========
+
+/**
+ * @brief Prazo do estado atual (relogio_agora_ms), ou 0 se não há
+ */
+static double prazo(const Cancela *c) {
+    const TemposCancela *t = &c->cfg->tempos;
+    const VeiculoCancela *v = (c->num_fila > 0) ? &c->fila[0] : NULL;
+    switch (c->estado) {
+        case CANCELA_LENDO:
+            return v ? v->consulta_ms + CANCELA_ESPERA_MS : 0;
+        case CANCELA_ABRINDO:
+            return c->desde_ms + t->abertura_ms;
+        case CANCELA_ABERTA:
+            return c->desde_ms + ((v && v->manual && !v->visto && t->passagem_manual_ms < t->timeout_aberta_ms) ?
+                                  t->passagem_manual_ms : t->timeout_aberta_ms);
+        case CANCELA_PASSANDO:
+            return c->desde_ms + t->timeout_passagem_ms;
+        case CANCELA_FECHANDO:
+            return c->desde_ms + t->fechamento_ms;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * @brief Cancela aberta além do prazo sem ninguém no sensor de fechamento
+ */
+static void vencer_aberta(Cancela *c, double agora) {
+    const TemposCancela *t = &c->cfg->tempos;
+    VeiculoCancela *v = &c->fila[0];
+
+    if (v->manual && !v->visto && agora - c->desde_ms >= t->passagem_manual_ms) {
+        printf("[CANCELA %s] Passagem manual sem os sensores\n", c->cfg->nome);
+        passou(c, agora);
+    } else if (c->abertura == HIGH && c->num_fila == 1) {
+        falhar(c, "carro parado antes da cancela aberta", agora);
+    } else {
+        printf("[CANCELA %s] Aberta há %u s sem passagem - carro descartado da fila\n",
+               c->cfg->nome, t->timeout_aberta_ms / 1000);
+        pthread_mutex_lock(&c->mutex);
+        c->estatisticas.timeouts++;
+        pthread_mutex_unlock(&c->mutex);
+        retirar(c, 0);
+        seguir(c, agora);
+    }
+}
+
+/**
+ * @brief Comando manual: libera um carro recusado parado na frente ou abre para um carro sem sensor
+ * @return false se a cancela está ocupada (o comando fica pendente)
+ */
+static bool atender_comando(Cancela *c, double agora) {
+    if (c->estado == CANCELA_LENDO && c->num_fila > 0) {
+        VeiculoCancela *v = &c->fila[0];
+        v->manual = true;
+        if (consultar(c, v, agora)) {
+            abrir(c, agora);
+        } else {
+            v->manual = false;
+        }
+        return true;
+    }
+    if (c->estado != CANCELA_OCIOSA) {
+        return false;
+    }
+
+    VeiculoCancela *v = enfileirar(c, true, agora);
+    mudar(c, CANCELA_LENDO, agora);
+    if (consultar(c, v, agora)) {
+        abrir(c, agora);
+    } else {
+        retirar(c, 0);
+        seguir(c, agora);
+    }
+    return true;
+}
+
+/**
+ * @brief Avança os prazos e atende o comando manual pendente
+ */
+unsigned int cancela_avancar(Cancela *c, double agora) {
+    double limite = prazo(c);
+
+    if (limite > 0 && agora >= limite) {
+        switch (c->estado) {
+            case CANCELA_LENDO:
+                if (consultar(c, &c->fila[0], agora)) {
+                    abrir(c, agora);
+                }
+                break;
+            case CANCELA_ABRINDO:
+                mudar(c, CANCELA_ABERTA, agora);
+                break;
+            case CANCELA_ABERTA:
+                vencer_aberta(c, agora);
+                break;
+            case CANCELA_PASSANDO:
+                falhar(c, "sensor de fechamento acionado além do timeout", agora);
+                break;
+            case CANCELA_FECHANDO:
+                seguir(c, agora);
+                break;
+            default:
+                break;
+        }
+    }
+
+    // Falha: espera o sensor de fechamento e o carro da frente liberarem
+    // (o sensor de abertura pode estar com o próximo da fila)
+    if (c->estado == CANCELA_FALHA && c->fechamento == LOW && (c->abertura == LOW || c->num_fila > 1)) {
+        printf("[CANCELA %s] Sensores livres - saindo da falha\n", c->cfg->nome);
+        if (c->falha_origem == CANCELA_PASSANDO) {
+            passou(c, agora);               // O carro esteve sob a cancela e terminou de passar
+        } else {
+            // O carro deixou o sensor de abertura sem chegar ao de fechamento: pode
+            // estar entre os dois. A cancela segue em cima esperando a passagem; se
+            // ninguém chegar ao sensor de fechamento, o timeout de "aberta" o descarta
+            mudar(c, CANCELA_ABERTA, agora);
+        }
+    }
+
+    pthread_mutex_lock(&c->mutex);
+    bool comando = c->comando;
+    pthread_mutex_unlock(&c->mutex);
+    if (comando && atender_comando(c, agora)) {
+        pthread_mutex_lock(&c->mutex);
+        c->comando = false;
+        pthread_mutex_unlock(&c->mutex);
+    }
+
+    limite = prazo(c);
+    if (limite <= 0 || limite - agora >= CANCELA_ESPERA_MS) {
+        return CANCELA_ESPERA_MS;
+    }
+    return (limite > agora) ? (unsigned int)(limite - agora) + 1 : 0;
+}
+
+/**
+ * @brief Bordas a partir de uma leitura (backend sem eventos)
+ */
+int cancela_bordas_da_leitura(const Cancela *c, uint32_t niveis, HalGpioEvento bordas[2]) {
+    uint64_t agora_ns = (uint64_t)(relogio_agora_ms() * 1000000.0);
+    int n = 0;
+    uint8_t abertura = HAL_GPIO_NIVEL(niveis, c->cfg->sensor_abertura);
+    uint8_t fechamento = HAL_GPIO_NIVEL(niveis, c->cfg->sensor_fechamento);
+    if (abertura != c->abertura) {
+        bordas[n++] = (HalGpioEvento){ c->cfg->sensor_abertura, abertura, agora_ns };
+    }
+    if (fechamento != c->fechamento) {
+        bordas[n++] = (HalGpioEvento){ c->cfg->sensor_fechamento, fechamento, agora_ns };
+    }
+    return n;
+}
+
+/**
+ * @brief Laço de um trabalhador do pool (não retorna)
+ */
+static void *executar_trabalhador(void *arg) {
+    TrabalhadorCancelas *t = (TrabalhadorCancelas *)arg;
+    HalGpioEvento bordas[2 * CANCELA_POR_TRABALHADOR];
+
+    while (1) {
+        // Dorme até a próxima borda, o prazo mais próximo ou um comando manual
+        // de qualquer das suas cancelas; sem eventos, as bordas saem da
+        // comparação de duas leituras
+        double agora = relogio_agora_ms();
+        unsigned int espera = CANCELA_ESPERA_MS;
+        for (int i = 0; i < t->num_cancelas; i++) {
+            unsigned int e = cancela_avancar(t->cancelas[i], agora);
+            if (e < espera) {
+                espera = e;
+            }
+        }
+
+        int num_bordas = hal_gpio_eventos_esperar(t->eventos, &bordas[0], espera);
+        if (num_bordas == 0 && t->eventos == NULL) {
+            uint32_t niveis = hal_gpio_lev_todos();
+            for (int i = 0; i < t->num_cancelas; i++) {
+                num_bordas += cancela_bordas_da_leitura(t->cancelas[i], niveis, &bordas[num_bordas]);
+            }
+        }
+        for (int b = 0; b < num_bordas; b++) {
+            for (int i = 0; i < t->num_cancelas; i++) {
+                if (cancela_borda(t->cancelas[i], &bordas[b])) {
+                    break;
+                }
+            }
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Distribui as cancelas entre os trabalhadores e inicia suas threads
+ */
+int cancela_iniciar_trabalhadores(Cancela *cancelas, int num_cancelas, TrabalhadorCancelas *trabalhadores) {
+    int n = CANCELA_TRABALHADORES(num_cancelas);
+    for (int w = 0; w < n; w++) {
+        memset(&trabalhadores[w], 0, sizeof(trabalhadores[w]));
+    }
+    for (int i = 0; i < num_cancelas; i++) {
+        TrabalhadorCancelas *t = &trabalhadores[i % n];
+        t->cancelas[t->num_cancelas++] = &cancelas[i];
+    }
+
+    // Assinaturas abertas antes das threads: nenhuma borda se perde entre o
+    // retrato dos níveis (cancela_init) e a primeira espera
+    for (int w = 0; w < n; w++) {
+        TrabalhadorCancelas *t = &trabalhadores[w];
+        uint8_t pinos[2 * CANCELA_POR_TRABALHADOR];
+        for (int i = 0; i < t->num_cancelas; i++) {
+            pinos[2 * i] = t->cancelas[i]->cfg->sensor_abertura;
+            pinos[2 * i + 1] = t->cancelas[i]->cfg->sensor_fechamento;
+        }
+        t->eventos = hal_gpio_eventos_abrir(pinos, 2 * t->num_cancelas, HAL_BORDA_AMBAS);
+        for (int i = 0; i < t->num_cancelas; i++) {
+            t->cancelas[i]->eventos = t->eventos;
+        }
+    }
+    for (int w = 0; w < n; w++) {
+        pthread_create(&trabalhadores[w].thread, NULL, executar_trabalhador, &trabalhadores[w]);
+    }
+
+    printf("[CANCELA] %d cancela(s) em %d trabalhador(es)\n", num_cancelas, n);
+    return n;
+}
+
+/**
+ * @brief Estado atual (qualquer thread)
+ */
+EstadoCancela cancela_estado(Cancela *c) {
+    pthread_mutex_lock(&c->mutex);
+    EstadoCancela estado = c->estatisticas.estado;
+    pthread_mutex_unlock(&c->mutex);
+    return estado;
+}
+
+/**
+ * @brief Pede a abertura manual (qualquer thread)
+ */
+void cancela_comandar(Cancela *c) {
+    pthread_mutex_lock(&c->mutex);
+    c->comando = true;
+    pthread_mutex_unlock(&c->mutex);
+    hal_gpio_eventos_acordar(c->eventos);
+}
+
+/**
+ * @brief Copia estado e estatísticas (qualquer thread)
+ */
+void cancela_estatisticas_obter(Cancela *c, CancelaEstatisticas *out) {
+    pthread_mutex_lock(&c->mutex);
+    *out = c->estatisticas;
+    pthread_mutex_unlock(&c->mutex);
+}
+
+/**
+ * @brief Imprime estado, vazão, contadores e tempos das fases
+ */
+void cancela_imprimir_estatisticas(Cancela *c) {
+    CancelaEstatisticas e;
+    double agora = relogio_agora_ms();
+    pthread_mutex_lock(&c->mutex);
+    e = c->estatisticas;
+    double periodo_ms = agora - c->relatorio_ms;
+    unsigned long carros = e.carros - c->relatorio_carros;
+    c->relatorio_ms = agora;
+    c->relatorio_carros = e.carros;
+    pthread_mutex_unlock(&c->mutex);
+
+    char prefixo[48];
+    snprintf(prefixo, sizeof(prefixo), "[CANCELA %s]", c->cfg->nome);
+    printf("%s Estado: %s | fila: %d (máx %d) | vazão: %.1f carros/min nos últimos %.0f s\n",
+           prefixo, cancela_nome_estado(e.estado), e.fila, e.fila_max,
+           (periodo_ms > 0) ? carros * 60000.0 / periodo_ms : 0, periodo_ms / 1000.0);
+    printf("%s chegadas: %lu | carros: %lu (%lu sem a cancela descer) | recusas: %lu | "
+           "desistências: %lu | timeouts: %lu | falhas: %lu | fila cheia: %lu\n",
+           prefixo, e.chegadas, e.carros, e.seguidos, e.recusas, e.desistencias,
+           e.timeouts, e.falhas, e.descartados);
+    for (int i = 0; i < CANCELA_NUM_ESTADOS; i++) {
+        if (i != CANCELA_OCIOSA && e.fases[i].total > 0) {
+            histograma_imprimir(prefixo, cancela_nome_estado(i), &e.fases[i]);
+        }
+    }
+    if (e.atendimento.total > 0) {
+        histograma_imprimir(prefixo, "chegada até a passagem", &e.atendimento);
+    }
+    if (e.intervalo.total > 0) {
+        histograma_imprimir(prefixo, "intervalo entre carros", &e.intervalo);
+    }
+}
@@ -0,0 +1,152 @@
+#include "../inc/filtro_vagas.h"
+#include "../inc/relogio.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *nomes_modo[] = {"n_de_m", "integrador"};
+
+/**
+ * @brief Indica se os parâmetros do filtro são utilizáveis
+ */
+static bool config_valida(const FiltroVagasConfig *cfg) {
+    if (cfg->modo == FILTRO_N_DE_M) {
+        // Com N > M/2, mudar e voltar exigem maiorias que não se sobrepõem
+        return cfg->janela >= 1 && cfg->janela <= 8 &&
+               cfg->confirmacoes * 2 > cfg->janela && cfg->confirmacoes <= cfg->janela;
+    }
+    return cfg->integrador_max >= 1;
+}
+
+/**
+ * @brief Lê um inteiro do ambiente; ausente, inválido ou fora de [minimo, maximo] mantém o valor
+ */
+static void ler_inteiro(const char *nome, long minimo, long maximo, unsigned int *valor) {
+    const char *texto = getenv(nome);
+    if (!texto || !texto[0]) {
+        return;
+    }
+    char *fim;
+    long n = strtol(texto, &fim, 10);
+    if (*fim == '\0' && n >= minimo && n <= maximo) {
+        *valor = (unsigned int)n;
+    } else {
+        printf("[FILTRO] %s inválido '%s', usando %u\n", nome, texto, *valor);
+    }
+}
+
+/**
+ * @brief Aplica os parâmetros do config.env definidos no ambiente
+ */
+void filtro_vagas_config_do_ambiente(FiltroVagasConfig *cfg) {
+    FiltroVagasConfig lida = *cfg;
+
+    const char *modo = getenv("FILTRO_VAGAS_MODO");
+    if (modo && modo[0]) {
+        if (strcmp(modo, nomes_modo[FILTRO_N_DE_M]) == 0) {
+            lida.modo = FILTRO_N_DE_M;
+        } else if (strcmp(modo, nomes_modo[FILTRO_INTEGRADOR]) == 0) {
+            lida.modo = FILTRO_INTEGRADOR;
+        } else {
+            printf("[FILTRO] FILTRO_VAGAS_MODO inválido '%s', usando %s\n", modo, nomes_modo[lida.modo]);
+        }
+    }
+
+    unsigned int janela = lida.janela, confirmacoes = lida.confirmacoes;
+    unsigned int integrador_max = lida.integrador_max;
+    ler_inteiro("FILTRO_VAGAS_JANELA", 1, 8, &janela);
+    ler_inteiro("FILTRO_VAGAS_CONFIRMACOES", 1, 8, &confirmacoes);
+    ler_inteiro("FILTRO_VAGAS_INTEGRADOR_MAX", 1, UINT8_MAX, &integrador_max);
+    ler_inteiro("FILTRO_VAGAS_PERMANENCIA_MS", 0, 3600000, &lida.permanencia_ms);
+    lida.janela = (uint8_t)janela;
+    lida.confirmacoes = (uint8_t)confirmacoes;
+    lida.integrador_max = (uint8_t)integrador_max;
+
+    // Cada valor pode estar na faixa e a combinação não (ex.: 2 de 4)
+    if (!config_valida(&lida)) {
+        printf("[FILTRO] %s com %u de %u leituras não é válido, usando %u de %u\n",
+               nomes_modo[lida.modo], lida.confirmacoes, lida.janela, cfg->confirmacoes, cfg->janela);
+        return;
+    }
+    *cfg = lida;
+}
+
+/**
+ * @brief Prepara o filtro com todas as vagas livres
+ */
+bool filtro_vagas_init(FiltroVagas *f, const FiltroVagasConfig *cfg, int num_vagas) {
+    bool valida = num_vagas >= 1 && num_vagas <= VARREDURA_MAX_VAGAS && config_valida(cfg);
+    if (!valida) {
+        printf("[FILTRO] Configuração inválida do filtro das vagas\n");
+        return false;
+    }
+
+    memset(f, 0, sizeof(*f));
+    f->cfg = *cfg;
+    f->todas = (num_vagas == VARREDURA_MAX_VAGAS) ? ~(MapaVagas)0 : MAPA_VAGA(num_vagas) - 1;
+
+    // Nenhuma vaga começa presa pela permanência mínima
+    uint32_t agora = filtro_vagas_instante(relogio_agora_ms());
+    for (int i = 0; i < num_vagas; i++) {
+        f->mudanca_ms[i] = agora - cfg->permanencia_ms;
+    }
+    return true;
+}
+
+/**
+ * @brief Passa uma varredura pelo filtro
+ */
+MapaVagas filtro_vagas_aplicar(FiltroVagas *f, MapaVagas lidas, double agora_ms) {
+    const FiltroVagasConfig *cfg = &f->cfg;
+    uint32_t agora = filtro_vagas_instante(agora_ms);
+    uint8_t cheio = (cfg->modo == FILTRO_N_DE_M) ? (uint8_t)((1u << cfg->janela) - 1) : cfg->integrador_max;
+
+    // Só as vagas com leitura diferente do estado ou com confirmação em andamento
+    MapaVagas visitar = ((lidas ^ f->estavel) | f->pendentes) & f->todas;
+    int i;
+    while ((i = mapa_retirar(&visitar)) >= 0) {
+        MapaVagas bit = MAPA_VAGA(i);
+        bool leitura = (lidas & bit) != 0;
+        bool ocupada = (f->estavel & bit) != 0;
+        uint8_t a = f->amostras[i];
+        bool confirmada;
+
+        if (!(f->pendentes & bit)) {
+            // Começo de uma divergência: guarda o estado para saber se era ruído
+            f->origem = (f->origem & ~bit) | (f->estavel & bit);
+            f->divergencia_ms[i] = agora;
+        }
+
+        if (cfg->modo == FILTRO_N_DE_M) {
+            a = (uint8_t)(((a << 1) | leitura) & cheio);
+            int ocupadas = __builtin_popcount(a);
+            confirmada = (ocupada ? cfg->janela - ocupadas : ocupadas) >= cfg->confirmacoes;
+        } else {
+            if (leitura) {
+                a = (a < cheio) ? a + 1 : cheio;
+            } else {
+                a = (a > 0) ? a - 1 : 0;
+            }
+            confirmada = ocupada ? (a == 0) : (a == cheio);
+        }
+        f->amostras[i] = a;
+
+        if (confirmada && agora - f->mudanca_ms[i] >= cfg->permanencia_ms) {
+            f->estavel ^= bit;
+            f->mudanca_ms[i] = agora;
+            f->mudancas++;
+            ocupada = !ocupada;
+        }
+
+        // Pendente até o histórico concordar por inteiro com o estado
+        if (a == (ocupada ? cheio : 0)) {
+            if ((f->pendentes & bit) && !((f->origem ^ f->estavel) & bit)) {
+                f->rejeitadas++;
+            }
+            f->pendentes &= ~bit;
+        } else {
+            f->pendentes |= bit;
+        }
+    }
+    return f->estavel;
+}
@@ -0,0 +1,85 @@
+#include "../inc/hal_gpio.h"
+#include "../inc/relogio.h"
+#include <bcm2835.h>
+
+// Backend do Raspberry Pi: repassa as chamadas para a biblioteca bcm2835
+
+/**
+ * @brief Inicializa a biblioteca bcm2835
+ */
+bool hal_gpio_init(HalPlaca placa) {
+    (void)placa;
+    return bcm2835_init() != 0;
+}
+
+/**
+ * @brief Libera a biblioteca bcm2835
+ */
+void hal_gpio_close() {
+    bcm2835_close();
+}
+
+/**
+ * @brief Define a direção do pino
+ */
+void hal_gpio_fsel(uint8_t pino, HalGpioModo modo) {
+    bcm2835_gpio_fsel(pino, modo == HAL_GPIO_SAIDA ? BCM2835_GPIO_FSEL_OUTP : BCM2835_GPIO_FSEL_INPT);
+}
+
+/**
+ * @brief Configura o resistor interno do pino
+ */
+void hal_gpio_set_pud(uint8_t pino, HalGpioPud pud) {
+    uint8_t valor = BCM2835_GPIO_PUD_OFF;
+    if (pud == HAL_PUD_DOWN) {
+        valor = BCM2835_GPIO_PUD_DOWN;
+    } else if (pud == HAL_PUD_UP) {
+        valor = BCM2835_GPIO_PUD_UP;
+    }
+    bcm2835_gpio_set_pud(pino, valor);
+}
+
+/**
+ * @brief Lê o nível do pino
+ */
+uint8_t hal_gpio_lev(uint8_t pino) {
+    return bcm2835_gpio_lev(pino);
+}
+
+/**
+ * @brief Escreve o nível do pino
+ */
+void hal_gpio_write(uint8_t pino, uint8_t nivel) {
+    bcm2835_gpio_write(pino, nivel);
+}
+
+/**
+ * @brief Lê o registrador GPLEV0 inteiro
+ */
+uint32_t hal_gpio_lev_todos() {
+    return bcm2835_peri_read(bcm2835_gpio + BCM2835_GPLEV0 / 4);
+}
+
+/**
+ * @brief Escreve os pinos da máscara pelos registradores GPSET0 e GPCLR0
+ * @note São dois acessos (liga, depois desliga); a varredura percorre o ciclo
+ *       Gray completo, então só uma linha muda por passo e o multiplexador não
+ *       vê endereço intermediário
+ */
+void hal_gpio_write_mask(uint32_t valores, uint32_t mascara) {
+    bcm2835_gpio_write_mask(valores, mascara);
+}
+
+/**
+ * @brief Aguarda o tempo dado em milissegundos
+ */
+void hal_delay(unsigned int ms) {
+    relogio_dormir_ms(ms);
+}
+
+/**
+ * @brief Aguarda o tempo dado em microssegundos
+ */
+void hal_delay_us(unsigned int us) {
+    relogio_dormir_us(us);
+}
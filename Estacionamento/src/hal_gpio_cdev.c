@@ -0,0 +1,151 @@
+#include "../inc/hal_gpio.h"
+#include "../inc/relogio.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/eventfd.h>
+#include <linux/gpio.h>
+
+// Eventos de borda do Raspberry Pi pelo GPIO character device (API v2 do kernel).
+// A biblioteca bcm2835 continua configurando e lendo os pinos; aqui as linhas
+// são só pedidas como entrada com detecção de borda. O kernel enfileira cada
+// borda com o carimbo de tempo da interrupção, então nenhuma se perde enquanto
+// a thread está ocupada.
+
+#define HAL_CDEV_LOTE_EVENTOS 16
+
+struct HalGpioEventos {
+    int fd_linhas;                              // Linhas pedidas ao kernel
+    int fd_acordar;                             // eventfd de hal_gpio_eventos_acordar
+    uint8_t pinos[HAL_GPIO_MAX_PINOS_EVENTOS];
+    struct gpio_v2_line_event lote[HAL_CDEV_LOTE_EVENTOS];
+    int lidos;                                  // Eventos no lote
+    int proximo;                                // Próximo evento a entregar
+};
+
+/**
+ * @brief Pede as linhas ao kernel com detecção de borda
+ */
+HalGpioEventos *hal_gpio_eventos_abrir(const uint8_t *pinos, int num_pinos, HalGpioBorda borda) {
+    if (num_pinos < 1 || num_pinos > HAL_GPIO_MAX_PINOS_EVENTOS) {
+        return NULL;
+    }
+
+    int chip = open(HAL_GPIO_CHIP, O_RDONLY | O_CLOEXEC);
+    if (chip < 0) {
+        printf("[GPIO] Sem eventos de borda (%s: %s), usando leitura periódica\n",
+               HAL_GPIO_CHIP, strerror(errno));
+        return NULL;
+    }
+
+    struct gpio_v2_line_request pedido;
+    memset(&pedido, 0, sizeof(pedido));
+    for (int i = 0; i < num_pinos; i++) {
+        pedido.offsets[i] = pinos[i];
+    }
+    pedido.num_lines = num_pinos;
+    strncpy(pedido.consumer, "estacionamento", sizeof(pedido.consumer) - 1);
+    pedido.config.flags = GPIO_V2_LINE_FLAG_INPUT;
+    if (borda & HAL_BORDA_SUBIDA) {
+        pedido.config.flags |= GPIO_V2_LINE_FLAG_EDGE_RISING;
+    }
+    if (borda & HAL_BORDA_DESCIDA) {
+        pedido.config.flags |= GPIO_V2_LINE_FLAG_EDGE_FALLING;
+    }
+
+    int rc = ioctl(chip, GPIO_V2_GET_LINE_IOCTL, &pedido);
+    close(chip);
+    if (rc < 0) {
+        printf("[GPIO] Erro ao pedir as linhas ao kernel: %s, usando leitura periódica\n", strerror(errno));
+        return NULL;
+    }
+
+    HalGpioEventos *e = calloc(1, sizeof(HalGpioEventos));
+    if (!e) {
+        close(pedido.fd);
+        return NULL;
+    }
+    e->fd_linhas = pedido.fd;
+    e->fd_acordar = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    memcpy(e->pinos, pinos, num_pinos);
+    return e;
+}
+
+/**
+ * @brief Espera o próximo evento de borda
+ */
+int hal_gpio_eventos_esperar(HalGpioEventos *e, HalGpioEvento *evento, int timeout_ms) {
+    if (!e) {
+        hal_delay(timeout_ms < HAL_GPIO_ESPERA_SEM_EVENTOS_MS ? timeout_ms : HAL_GPIO_ESPERA_SEM_EVENTOS_MS);
+        return 0;
+    }
+
+    if (e->proximo >= e->lidos) {
+        struct pollfd fds[2] = {
+            { e->fd_linhas, POLLIN, 0 },
+            { e->fd_acordar, POLLIN, 0 }
+        };
+        // O kernel não conhece o relógio simulado: o tempo de espera é convertido
+        int espera = (relogio_modo() == RELOGIO_REAL) ? timeout_ms : HAL_GPIO_ESPERA_SEM_EVENTOS_MS;
+        int rc = poll(fds, (e->fd_acordar >= 0) ? 2 : 1, espera);
+        if (rc < 0) {
+            return (errno == EINTR) ? 0 : -1;
+        }
+        if (rc == 0) {
+            return 0;
+        }
+        if (fds[1].revents & POLLIN) {
+            uint64_t contador;
+            if (read(e->fd_acordar, &contador, sizeof(contador)) < 0) {
+                // eventfd não bloqueante: nada a fazer
+            }
+            if (!(fds[0].revents & POLLIN)) {
+                return 0;
+            }
+        }
+
+        ssize_t n = read(e->fd_linhas, e->lote, sizeof(e->lote));
+        if (n < (ssize_t)sizeof(struct gpio_v2_line_event)) {
+            return (n < 0 && errno == EINTR) ? 0 : -1;
+        }
+        e->lidos = n / sizeof(struct gpio_v2_line_event);
+        e->proximo = 0;
+    }
+
+    struct gpio_v2_line_event *ev = &e->lote[e->proximo++];
+    evento->pino = (uint8_t)ev->offset;
+    evento->nivel = (ev->id == GPIO_V2_LINE_EVENT_RISING_EDGE) ? HIGH : LOW;
+    evento->instante_ns = ev->timestamp_ns;
+    return 1;
+}
+
+/**
+ * @brief Acorda a thread que espera na assinatura
+ */
+void hal_gpio_eventos_acordar(HalGpioEventos *e) {
+    if (e && e->fd_acordar >= 0) {
+        uint64_t um = 1;
+        if (write(e->fd_acordar, &um, sizeof(um)) < 0) {
+            // Contador cheio: a thread já tem um despertar pendente
+        }
+    }
+}
+
+/**
+ * @brief Devolve as linhas ao kernel
+ */
+void hal_gpio_eventos_fechar(HalGpioEventos *e) {
+    if (!e) {
+        return;
+    }
+    close(e->fd_linhas);
+    if (e->fd_acordar >= 0) {
+        close(e->fd_acordar);
+    }
+    free(e);
+}
@@ -0,0 +1,889 @@
+#include "../inc/hal_gpio.h"
+#include "../inc/hal_gpio_sim.h"
+#include "../inc/relogio.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+
+// Fiação de uma placa (mesmos pinos BCM definidos em terreo.c, 1Andar.c e 2Andar.c)
+typedef struct {
+    const char *nome;
+    int andar;                          // Índice do andar (-1 = sem vagas)
+    int num_enderecos;                  // Bits de endereço do multiplexador
+    uint8_t enderecos[3];               // Bit 0, bit 1, bit 2
+    uint8_t sensor_vaga;
+    bool tem_cancelas;
+    uint8_t entrada_abertura, entrada_fechamento, entrada_motor;
+    uint8_t saida_abertura, saida_fechamento, saida_motor;
+    bool tem_passagem;
+    uint8_t passagem_1, passagem_2;
+} HalSimFiacao;
+
+static const HalSimFiacao fiacoes[] = {
+    [HAL_PLACA_TERREO]  = { "Térreo", 0, 2, {17, 18, 0}, 8,
+                            true, 7, 1, 23, 12, 25, 24,
+                            false, 0, 0 },
+    [HAL_PLACA_ANDAR1]  = { "1º Andar", 1, 3, {16, 20, 21}, 27,
+                            false, 0, 0, 0, 0, 0, 0,
+                            true, 22, 11 },
+    [HAL_PLACA_ANDAR2]  = { "2º Andar", 2, 3, {0, 5, 6}, 13,
+                            false, 0, 0, 0, 0, 0, 0,
+                            true, 19, 26 },
+    [HAL_PLACA_CENTRAL] = { "Central", -1, 0, {0, 0, 0}, 0,
+                            false, 0, 0, 0, 0, 0, 0,
+                            false, 0, 0 },
+};
+
+// Evento agendado (roteiro ou sequência de sensores)
+typedef enum {
+    EVENTO_NIVEL,
+    EVENTO_VAGA,
+    EVENTO_ENTRADA,
+    EVENTO_SAIDA,
+    EVENTO_PASSAGEM
+} HalSimTipoEvento;
+
+typedef struct {
+    bool ativo;
+    double instante_ms;
+    HalSimTipoEvento tipo;
+    int a, b, c;
+} HalSimEvento;
+
+// Carro simulado numa cancela. O próximo da fila encosta no sensor de abertura
+// assim que o anterior o libera, enquanto o anterior ainda está no de fechamento
+typedef enum {
+    CARRO_AUSENTE,
+    CARRO_AGUARDANDO,                   // Sobre o sensor de abertura, cancela fechada
+    CARRO_ATRAVESSANDO                  // Cancela aberta
+} HalSimEstadoCarro;
+
+typedef struct {
+    int fila;                           // Carros aguardando atrás do atual
+    HalSimEstadoCarro estado;
+    double desde_ms;
+    bool saindo;                        // Carro anterior sobre o sensor de fechamento
+    double saindo_ms;
+    uint8_t abertura, fechamento, motor;
+    bool entrada;                       // Faixa de entrada ou de saída
+} HalSimCancela;
+
+// Multiplexador de vagas montado na placa (o da fiação e os de hal_sim_adicionar_mux)
+typedef struct {
+    int num_enderecos;
+    uint8_t enderecos[HAL_SIM_MAX_ENDERECOS];
+    uint8_t sensor;
+    int primeira_vaga;                  // Vaga do andar na posição 0
+} HalSimMux;
+
+static const HalSimFiacao *fiacao = NULL;
+static HalSimMux muxes[HAL_SIM_MAX_MUX];
+static int num_muxes = 0;
+static uint8_t niveis[HAL_SIM_NUM_PINOS];
+static HalGpioModo modos[HAL_SIM_NUM_PINOS];
+static bool vagas[HAL_SIM_NUM_ANDARES][HAL_SIM_MAX_VAGAS];
+static HalSimEvento eventos[HAL_SIM_MAX_EVENTOS];
+static HalSimCancela cancelas[HAL_SIM_MAX_CANCELAS];   // As da fiação e as de hal_sim_adicionar_cancela
+static int num_cancelas = 0;
+static HalSimEstatisticas estatisticas;
+static unsigned int acomodacao_us = HAL_SIM_ACOMODACAO_US;
+static double endereco_mudou_ms = -1e9;     // Última troca de endereço do multiplexador
+
+// Assinatura de eventos de borda (hal_gpio_eventos_abrir)
+struct HalGpioEventos {
+    uint8_t pinos[HAL_GPIO_MAX_PINOS_EVENTOS];
+    int num_pinos;
+    HalGpioBorda borda;
+    HalGpioEvento fila[HAL_SIM_FILA_BORDAS];
+    int inicio, quantidade;
+    bool acordar;
+    pthread_cond_t cond;
+};
+
+static HalGpioEventos *assinaturas[HAL_SIM_MAX_ASSINATURAS];
+
+static double inicio_simulacao;
+static pthread_t thread_simulacao;
+static volatile bool simulacao_rodando = false;
+static pthread_mutex_t mutex_placa = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @brief Milissegundos desde o início da simulação
+ */
+static double agora_ms() {
+    return relogio_agora_ms() - inicio_simulacao;
+}
+
+/**
+ * @brief Muda o nível de um pino de entrada e entrega a borda às assinaturas
+ * @note Deve ser chamada com mutex_placa travado
+ */
+static void mudar_nivel(uint8_t pino, uint8_t nivel) {
+    if (niveis[pino] == nivel) {
+        return;
+    }
+    niveis[pino] = nivel;
+
+    HalGpioEvento evento = { pino, nivel, (uint64_t)(agora_ms() * 1000000.0) };
+    for (int i = 0; i < HAL_SIM_MAX_ASSINATURAS; i++) {
+        HalGpioEventos *a = assinaturas[i];
+        if (a == NULL || !(a->borda & (nivel == HIGH ? HAL_BORDA_SUBIDA : HAL_BORDA_DESCIDA))) {
+            continue;
+        }
+        for (int p = 0; p < a->num_pinos; p++) {
+            if (a->pinos[p] != pino) {
+                continue;
+            }
+            if (a->quantidade == HAL_SIM_FILA_BORDAS) {
+                // Fila cheia: descarta a borda mais antiga, como o kernel
+                a->inicio = (a->inicio + 1) % HAL_SIM_FILA_BORDAS;
+                a->quantidade--;
+            }
+            a->fila[(a->inicio + a->quantidade) % HAL_SIM_FILA_BORDAS] = evento;
+            a->quantidade++;
+            estatisticas.eventos_borda++;
+            relogio_sinalizar(&a->cond);
+        }
+    }
+}
+
+/**
+ * @brief Agenda um evento
+ * @note Deve ser chamada com mutex_placa travado
+ */
+static bool agendar(double instante_ms, HalSimTipoEvento tipo, int a, int b, int c) {
+    for (int i = 0; i < HAL_SIM_MAX_EVENTOS; i++) {
+        if (!eventos[i].ativo) {
+            eventos[i] = (HalSimEvento){ true, instante_ms, tipo, a, b, c };
+            return true;
+        }
+    }
+    fprintf(stderr, "[SIM] Fila de eventos cheia (%d)\n", HAL_SIM_MAX_EVENTOS);
+    return false;
+}
+
+/**
+ * @brief Agenda a sequência dos dois sensores de passagem
+ * @note Deve ser chamada com mutex_placa travado
+ */
+static void agendar_passagem(int andar, bool sobe, double t) {
+    const HalSimFiacao *f = NULL;
+    for (int i = 0; i < (int)(sizeof(fiacoes) / sizeof(fiacoes[0])); i++) {
+        if (fiacoes[i].andar == andar && fiacoes[i].tem_passagem) {
+            f = &fiacoes[i];
+        }
+    }
+    if (f == NULL || f != fiacao) {
+        return;                         // Sensores de outra placa: nada a fazer neste processo
+    }
+
+    uint8_t primeiro = sobe ? f->passagem_1 : f->passagem_2;
+    uint8_t segundo = sobe ? f->passagem_2 : f->passagem_1;
+    agendar(t, EVENTO_NIVEL, primeiro, HIGH, 0);
+    agendar(t + HAL_SIM_INTERVALO_PASSAGEM_MS, EVENTO_NIVEL, segundo, HIGH, 0);
+    agendar(t + 2 * HAL_SIM_INTERVALO_PASSAGEM_MS, EVENTO_NIVEL, primeiro, LOW, 0);
+    agendar(t + 3 * HAL_SIM_INTERVALO_PASSAGEM_MS, EVENTO_NIVEL, segundo, LOW, 0);
+}
+
+/**
+ * @brief Cancela de uma faixa (0 = a da fiação), ou NULL se não está montada
+ * @note Deve ser chamada com mutex_placa travado
+ */
+static HalSimCancela *cancela_da_faixa(bool entrada, int faixa) {
+    for (int i = 0; i < num_cancelas; i++) {
+        if (cancelas[i].entrada == entrada && faixa-- == 0) {
+            return &cancelas[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Coloca um carro na fila de uma faixa
+ * @note Deve ser chamada com mutex_placa travado
+ */
+static void chegar_carro(bool entrada, int faixa) {
+    HalSimCancela *c = cancela_da_faixa(entrada, faixa);
+    if (c) {
+        c->fila++;
+    } else {
+        fprintf(stderr, "[SIM] Faixa de %s %d não montada - carro ignorado\n",
+                entrada ? "entrada" : "saída", faixa);
+    }
+}
+
+/**
+ * @brief Executa um evento vencido
+ * @note Deve ser chamada com mutex_placa travado
+ */
+static void executar_evento(const HalSimEvento *e, double t) {
+    switch (e->tipo) {
+        case EVENTO_NIVEL:
+            if (e->a >= 0 && e->a < HAL_SIM_NUM_PINOS) {
+                mudar_nivel(e->a, e->b ? HIGH : LOW);
+            }
+            break;
+        case EVENTO_VAGA:
+            if (e->a >= 0 && e->a < HAL_SIM_NUM_ANDARES && e->b >= 0 && e->b < HAL_SIM_MAX_VAGAS) {
+                vagas[e->a][e->b] = e->c != 0;
+            }
+            break;
+        case EVENTO_ENTRADA:
+            chegar_carro(true, e->a);
+            break;
+        case EVENTO_SAIDA:
+            chegar_carro(false, e->a);
+            break;
+        case EVENTO_PASSAGEM:
+            agendar_passagem(e->a, e->b != 0, t);
+            break;
+    }
+}
+
+/**
+ * @brief Avança o carro simulado de uma cancela
+ * @note Deve ser chamada com mutex_placa travado
+ */
+static void avancar_cancela(HalSimCancela *c, double t) {
+    if (c->saindo && t - c->saindo_ms >= HAL_SIM_PULSO_SENSOR_MS) {
+        mudar_nivel(c->fechamento, LOW);
+        c->saindo = false;
+        if (c->entrada) {
+            estatisticas.carros_entrada++;
+        } else {
+            estatisticas.carros_saida++;
+        }
+    }
+
+    switch (c->estado) {
+        case CARRO_AUSENTE:
+            if (c->fila > 0) {
+                c->fila--;
+                c->estado = CARRO_AGUARDANDO;
+                c->desde_ms = t;
+                mudar_nivel(c->abertura, HIGH);
+            }
+            break;
+        case CARRO_AGUARDANDO:
+            if (niveis[c->motor] == HIGH) {
+                c->estado = CARRO_ATRAVESSANDO;
+                c->desde_ms = t;
+            }
+            break;
+        case CARRO_ATRAVESSANDO:
+            if (t - c->desde_ms >= HAL_SIM_TRAVESSIA_MS && !c->saindo) {
+                mudar_nivel(c->abertura, LOW);
+                mudar_nivel(c->fechamento, HIGH);
+                c->estado = CARRO_AUSENTE;
+                c->saindo = true;
+                c->saindo_ms = t;
+            }
+            break;
+    }
+}
+
+/**
+ * @brief Próximo instante em que um carro simulado muda de estado sozinho
+ */
+static double prazo_cancela(const HalSimCancela *c, double t) {
+    double saida = c->saindo ? c->saindo_ms + HAL_SIM_PULSO_SENSOR_MS : -1;
+    double carro = -1;
+    switch (c->estado) {
+        case CARRO_AUSENTE:
+            carro = (c->fila > 0) ? t : -1;
+            break;
+        case CARRO_AGUARDANDO:
+            carro = t + 1;              // Reage ao motor escrito pelo nó
+            break;
+        case CARRO_ATRAVESSANDO:
+            carro = c->desde_ms + HAL_SIM_TRAVESSIA_MS;
+            break;
+    }
+    if (saida < 0 || (carro >= 0 && carro < saida)) {
+        return carro;
+    }
+    return saida;
+}
+
+/**
+ * @brief Quanto a thread da placa pode dormir até o próximo evento ou mudança de carro
+ * @note Deve ser chamada com mutex_placa travado
+ */
+static unsigned int espera_placa(double t) {
+    double proximo = t + HAL_SIM_TICK_MAX_MS;
+    for (int i = 0; i < HAL_SIM_MAX_EVENTOS; i++) {
+        if (eventos[i].ativo && eventos[i].instante_ms < proximo) {
+            proximo = eventos[i].instante_ms;
+        }
+    }
+    for (int i = 0; i < num_cancelas; i++) {
+        double p = prazo_cancela(&cancelas[i], t);
+        if (p >= 0 && p < proximo) {
+            proximo = p;
+        }
+    }
+    double espera = proximo - t;
+    return (espera < 1) ? 1 : (unsigned int)espera;
+}
+
+/**
+ * @brief Thread da placa: executa eventos vencidos e move os carros simulados
+ */
+static void *thread_placa(void *arg) {
+    (void)arg;
+    while (simulacao_rodando) {
+        pthread_mutex_lock(&mutex_placa);
+        double t = agora_ms();
+        for (int i = 0; i < HAL_SIM_MAX_EVENTOS; i++) {
+            if (eventos[i].ativo && eventos[i].instante_ms <= t) {
+                HalSimEvento e = eventos[i];
+                eventos[i].ativo = false;
+                executar_evento(&e, t);
+            }
+        }
+        for (int c = 0; c < num_cancelas; c++) {
+            avancar_cancela(&cancelas[c], t);
+        }
+        unsigned int espera = espera_placa(t);
+        pthread_mutex_unlock(&mutex_placa);
+
+        // Dorme até o próximo acontecimento: no relógio virtual, cada tick é um passo do tempo
+        relogio_dormir_ms(espera);
+    }
+    return NULL;
+}
+
+// ========== Backend do hal_gpio.h ==========
+
+/**
+ * @brief Monta a placa simulada do nó e inicia a thread da simulação
+ */
+bool hal_gpio_init(HalPlaca placa) {
+    if (placa < HAL_PLACA_TERREO || placa > HAL_PLACA_CENTRAL) {
+        return false;
+    }
+
+    pthread_mutex_lock(&mutex_placa);
+    fiacao = &fiacoes[placa];
+    memset(niveis, LOW, sizeof(niveis));
+    memset(modos, 0, sizeof(modos));
+    memset(vagas, 0, sizeof(vagas));
+    memset(eventos, 0, sizeof(eventos));
+    memset(&estatisticas, 0, sizeof(estatisticas));
+    endereco_mudou_ms = -1e9;
+    num_muxes = 0;
+    if (fiacao->andar >= 0) {
+        HalSimMux *mux = &muxes[num_muxes++];
+        *mux = (HalSimMux){ fiacao->num_enderecos, {0}, fiacao->sensor_vaga, 0 };
+        memcpy(mux->enderecos, fiacao->enderecos, sizeof(fiacao->enderecos));
+    }
+    num_cancelas = 0;
+    if (fiacao->tem_cancelas) {
+        cancelas[num_cancelas++] = (HalSimCancela){ 0, CARRO_AUSENTE, 0, false, 0, fiacao->entrada_abertura,
+                                                    fiacao->entrada_fechamento, fiacao->entrada_motor, true };
+        cancelas[num_cancelas++] = (HalSimCancela){ 0, CARRO_AUSENTE, 0, false, 0, fiacao->saida_abertura,
+                                                    fiacao->saida_fechamento, fiacao->saida_motor, false };
+    }
+    inicio_simulacao = relogio_agora_ms();
+    pthread_mutex_unlock(&mutex_placa);
+
+    printf("[SIM] Placa simulada: %s\n", fiacao->nome);
+
+    const char *acomodacao = getenv("HAL_SIM_ACOMODACAO_US");
+    if (acomodacao && *acomodacao) {
+        acomodacao_us = (unsigned int)atoi(acomodacao);
+    }
+
+    const char *roteiro = getenv("HAL_SIM_ROTEIRO");
+    if (roteiro && !hal_sim_carregar_roteiro(roteiro)) {
+        return false;
+    }
+
+    simulacao_rodando = true;
+    if (pthread_create(&thread_simulacao, NULL, thread_placa, NULL) != 0) {
+        simulacao_rodando = false;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Para a thread da simulação
+ */
+void hal_gpio_close() {
+    if (simulacao_rodando) {
+        simulacao_rodando = false;
+        pthread_join(thread_simulacao, NULL);
+    }
+}
+
+/**
+ * @brief Define a direção do pino
+ */
+void hal_gpio_fsel(uint8_t pino, HalGpioModo modo) {
+    if (pino < HAL_SIM_NUM_PINOS) {
+        modos[pino] = modo;
+    }
+}
+
+/**
+ * @brief Resistor interno: na placa simulada as entradas já começam em LOW
+ */
+void hal_gpio_set_pud(uint8_t pino, HalGpioPud pud) {
+    (void)pino;
+    (void)pud;
+}
+
+/**
+ * @brief Nível de um pino; o sensor de cada multiplexador devolve a vaga selecionada nele
+ * @note Deve ser chamada com mutex_placa travado
+ */
+static uint8_t nivel_pino(uint8_t pino) {
+    for (int m = 0; m < num_muxes; m++) {
+        const HalSimMux *mux = &muxes[m];
+        if (pino != mux->sensor) {
+            continue;
+        }
+
+        // Ainda acomodando: a saída oscila entre os níveis
+        double decorrido_us = (agora_ms() - endereco_mudou_ms) * 1000.0;
+        if (decorrido_us < acomodacao_us) {
+            return ((int)(decorrido_us / HAL_SIM_OSCILACAO_US) & 1) ? HIGH : LOW;
+        }
+
+        int vaga = mux->primeira_vaga;
+        for (int b = 0; b < mux->num_enderecos; b++) {
+            if (niveis[mux->enderecos[b]] == HIGH) {
+                vaga += 1 << b;
+            }
+        }
+        return (vaga < HAL_SIM_MAX_VAGAS && vagas[fiacao->andar][vaga]) ? HIGH : LOW;
+    }
+    return niveis[pino];
+}
+
+/**
+ * @brief Indica se o pino é linha de endereço de algum multiplexador
+ * @note Deve ser chamada com mutex_placa travado
+ */
+static bool pino_de_endereco(uint8_t pino) {
+    for (int m = 0; m < num_muxes; m++) {
+        for (int b = 0; b < muxes[m].num_enderecos; b++) {
+            if (muxes[m].enderecos[b] == pino) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Escreve um pino de saída, contando as trocas das linhas de endereço
+ * @note Deve ser chamada com mutex_placa travado
+ */
+static void escrever_pino(uint8_t pino, uint8_t nivel) {
+    uint8_t novo = nivel ? HIGH : LOW;
+    if (niveis[pino] != novo && pino_de_endereco(pino)) {
+        estatisticas.trocas_endereco++;
+        endereco_mudou_ms = agora_ms();
+    }
+    niveis[pino] = novo;
+}
+
+/**
+ * @brief Lê o nível do pino
+ */
+uint8_t hal_gpio_lev(uint8_t pino) {
+    if (pino >= HAL_SIM_NUM_PINOS) {
+        return LOW;
+    }
+
+    pthread_mutex_lock(&mutex_placa);
+    estatisticas.leituras++;
+    uint8_t nivel = nivel_pino(pino);
+    pthread_mutex_unlock(&mutex_placa);
+
+    return nivel;
+}
+
+/**
+ * @brief Lê os GPIO 0 a 31 de uma vez (um só retrato da placa)
+ */
+uint32_t hal_gpio_lev_todos() {
+    uint32_t palavra = 0;
+
+    pthread_mutex_lock(&mutex_placa);
+    estatisticas.leituras++;
+    for (int pino = 0; pino < 32; pino++) {
+        if (nivel_pino(pino) == HIGH) {
+            palavra |= HAL_GPIO_BIT(pino);
+        }
+    }
+    pthread_mutex_unlock(&mutex_placa);
+
+    return palavra;
+}
+
+/**
+ * @brief Escreve o nível de um pino de saída
+ */
+void hal_gpio_write(uint8_t pino, uint8_t nivel) {
+    if (pino >= HAL_SIM_NUM_PINOS) {
+        return;
+    }
+
+    pthread_mutex_lock(&mutex_placa);
+    estatisticas.escritas++;
+    escrever_pino(pino, nivel);
+    pthread_mutex_unlock(&mutex_placa);
+}
+
+/**
+ * @brief Escreve os pinos da máscara de uma vez (a placa nunca vê um estado intermediário)
+ */
+void hal_gpio_write_mask(uint32_t valores, uint32_t mascara) {
+    pthread_mutex_lock(&mutex_placa);
+    estatisticas.escritas++;
+    for (int pino = 0; pino < 32; pino++) {
+        if (mascara & HAL_GPIO_BIT(pino)) {
+            escrever_pino(pino, (valores & HAL_GPIO_BIT(pino)) ? HIGH : LOW);
+        }
+    }
+    pthread_mutex_unlock(&mutex_placa);
+}
+
+/**
+ * @brief Assina as bordas dos pinos na placa simulada
+ */
+HalGpioEventos *hal_gpio_eventos_abrir(const uint8_t *pinos, int num_pinos, HalGpioBorda borda) {
+    if (num_pinos < 1 || num_pinos > HAL_GPIO_MAX_PINOS_EVENTOS) {
+        return NULL;
+    }
+
+    HalGpioEventos *e = calloc(1, sizeof(HalGpioEventos));
+    if (!e) {
+        return NULL;
+    }
+    memcpy(e->pinos, pinos, num_pinos);
+    e->num_pinos = num_pinos;
+    e->borda = borda;
+    pthread_cond_init(&e->cond, NULL);
+
+    pthread_mutex_lock(&mutex_placa);
+    for (int i = 0; i < HAL_SIM_MAX_ASSINATURAS; i++) {
+        if (assinaturas[i] == NULL) {
+            assinaturas[i] = e;
+            pthread_mutex_unlock(&mutex_placa);
+            return e;
+        }
+    }
+    pthread_mutex_unlock(&mutex_placa);
+
+    fprintf(stderr, "[SIM] Limite de assinaturas de eventos (%d)\n", HAL_SIM_MAX_ASSINATURAS);
+    pthread_cond_destroy(&e->cond);
+    free(e);
+    return NULL;
+}
+
+/**
+ * @brief Espera a próxima borda, no relógio da simulação
+ */
+int hal_gpio_eventos_esperar(HalGpioEventos *e, HalGpioEvento *evento, int timeout_ms) {
+    if (!e) {
+        hal_delay(timeout_ms < HAL_GPIO_ESPERA_SEM_EVENTOS_MS ? timeout_ms : HAL_GPIO_ESPERA_SEM_EVENTOS_MS);
+        return 0;
+    }
+
+    pthread_mutex_lock(&mutex_placa);
+    double prazo = relogio_agora_ms() + timeout_ms;
+    while (e->quantidade == 0 && !e->acordar) {
+        double resta = prazo - relogio_agora_ms();
+        if (resta <= 0) {
+            break;
+        }
+        relogio_esperar_cond(&e->cond, &mutex_placa, (unsigned int)resta + 1);
+    }
+
+    int rc = 0;
+    if (e->quantidade > 0) {
+        *evento = e->fila[e->inicio];
+        e->inicio = (e->inicio + 1) % HAL_SIM_FILA_BORDAS;
+        e->quantidade--;
+        rc = 1;
+    } else {
+        e->acordar = false;
+    }
+    pthread_mutex_unlock(&mutex_placa);
+    return rc;
+}
+
+/**
+ * @brief Acorda a thread que espera na assinatura
+ */
+void hal_gpio_eventos_acordar(HalGpioEventos *e) {
+    if (!e) {
+        return;
+    }
+    pthread_mutex_lock(&mutex_placa);
+    e->acordar = true;
+    relogio_sinalizar(&e->cond);
+    pthread_mutex_unlock(&mutex_placa);
+}
+
+/**
+ * @brief Cancela a assinatura
+ */
+void hal_gpio_eventos_fechar(HalGpioEventos *e) {
+    if (!e) {
+        return;
+    }
+    pthread_mutex_lock(&mutex_placa);
+    for (int i = 0; i < HAL_SIM_MAX_ASSINATURAS; i++) {
+        if (assinaturas[i] == e) {
+            assinaturas[i] = NULL;
+        }
+    }
+    pthread_mutex_unlock(&mutex_placa);
+    pthread_cond_destroy(&e->cond);
+    free(e);
+}
+
+/**
+ * @brief Aguarda o tempo dado em milissegundos
+ */
+void hal_delay(unsigned int ms) {
+    relogio_dormir_ms(ms);
+}
+
+/**
+ * @brief Aguarda o tempo dado em microssegundos
+ */
+void hal_delay_us(unsigned int us) {
+    relogio_dormir_us(us);
+}
+
+// ========== Controle da placa simulada ==========
+
+/**
+ * @brief Ocupa ou libera uma vaga
+ */
+void hal_sim_vaga(int andar, int vaga, bool ocupada) {
+    if (andar < 0 || andar >= HAL_SIM_NUM_ANDARES || vaga < 0 || vaga >= HAL_SIM_MAX_VAGAS) {
+        return;
+    }
+    pthread_mutex_lock(&mutex_placa);
+    vagas[andar][vaga] = ocupada;
+    pthread_mutex_unlock(&mutex_placa);
+}
+
+/**
+ * @brief Monta mais um multiplexador de vagas na placa simulada
+ */
+bool hal_sim_adicionar_mux(const uint8_t *enderecos, int num_enderecos, uint8_t sensor, int primeira_vaga) {
+    if (num_enderecos < 1 || num_enderecos > HAL_SIM_MAX_ENDERECOS || sensor >= HAL_SIM_NUM_PINOS ||
+        primeira_vaga < 0 || primeira_vaga + (1 << num_enderecos) > HAL_SIM_MAX_VAGAS) {
+        return false;
+    }
+    for (int b = 0; b < num_enderecos; b++) {
+        if (enderecos[b] >= HAL_SIM_NUM_PINOS) {
+            return false;
+        }
+    }
+
+    pthread_mutex_lock(&mutex_placa);
+    bool montado = fiacao && fiacao->andar >= 0 && num_muxes < HAL_SIM_MAX_MUX;
+    if (montado) {
+        HalSimMux *mux = &muxes[num_muxes++];
+        mux->num_enderecos = num_enderecos;
+        memcpy(mux->enderecos, enderecos, num_enderecos);
+        mux->sensor = sensor;
+        mux->primeira_vaga = primeira_vaga;
+    }
+    pthread_mutex_unlock(&mutex_placa);
+    return montado;
+}
+
+/**
+ * @brief Estado simulado de uma vaga
+ */
+bool hal_sim_vaga_ocupada(int andar, int vaga) {
+    if (andar < 0 || andar >= HAL_SIM_NUM_ANDARES || vaga < 0 || vaga >= HAL_SIM_MAX_VAGAS) {
+        return false;
+    }
+    pthread_mutex_lock(&mutex_placa);
+    bool ocupada = vagas[andar][vaga];
+    pthread_mutex_unlock(&mutex_placa);
+    return ocupada;
+}
+
+/**
+ * @brief Monta mais uma cancela (faixa) na placa simulada
+ */
+bool hal_sim_adicionar_cancela(uint8_t abertura, uint8_t fechamento, uint8_t motor, bool entrada) {
+    if (abertura >= HAL_SIM_NUM_PINOS || fechamento >= HAL_SIM_NUM_PINOS || motor >= HAL_SIM_NUM_PINOS) {
+        return false;
+    }
+
+    pthread_mutex_lock(&mutex_placa);
+    bool montada = fiacao && num_cancelas < HAL_SIM_MAX_CANCELAS;
+    if (montada) {
+        cancelas[num_cancelas++] = (HalSimCancela){ 0, CARRO_AUSENTE, 0, false, 0,
+                                                    abertura, fechamento, motor, entrada };
+    }
+    pthread_mutex_unlock(&mutex_placa);
+    return montada;
+}
+
+/**
+ * @brief Coloca um carro na fila de uma faixa
+ */
+void hal_sim_carro_faixa(bool entrada, int faixa) {
+    pthread_mutex_lock(&mutex_placa);
+    chegar_carro(entrada, faixa);
+    pthread_mutex_unlock(&mutex_placa);
+}
+
+/**
+ * @brief Coloca um carro na fila da cancela de entrada
+ */
+void hal_sim_carro_entrada() {
+    hal_sim_carro_faixa(true, 0);
+}
+
+/**
+ * @brief Coloca um carro na fila da cancela de saída
+ */
+void hal_sim_carro_saida() {
+    hal_sim_carro_faixa(false, 0);
+}
+
+/**
+ * @brief Gera a sequência dos sensores de passagem de um andar
+ */
+void hal_sim_passagem(int andar, bool sobe) {
+    pthread_mutex_lock(&mutex_placa);
+    agendar_passagem(andar, sobe, agora_ms());
+    pthread_mutex_unlock(&mutex_placa);
+}
+
+/**
+ * @brief Nível atual de um pino
+ */
+uint8_t hal_sim_nivel(uint8_t pino) {
+    if (pino >= HAL_SIM_NUM_PINOS) {
+        return LOW;
+    }
+    pthread_mutex_lock(&mutex_placa);
+    uint8_t nivel = niveis[pino];
+    pthread_mutex_unlock(&mutex_placa);
+    return nivel;
+}
+
+/**
+ * @brief Força o nível de um pino de entrada
+ */
+void hal_sim_definir_nivel(uint8_t pino, uint8_t nivel) {
+    if (pino >= HAL_SIM_NUM_PINOS) {
+        return;
+    }
+    pthread_mutex_lock(&mutex_placa);
+    mudar_nivel(pino, nivel ? HIGH : LOW);
+    pthread_mutex_unlock(&mutex_placa);
+}
+
+/**
+ * @brief Carrega um roteiro de eventos
+ */
+bool hal_sim_carregar_roteiro(const char *arquivo) {
+    FILE *f = fopen(arquivo, "r");
+    if (!f) {
+        fprintf(stderr, "[SIM] Não foi possível abrir o roteiro %s\n", arquivo);
+        return false;
+    }
+
+    char linha[256];
+    int numero = 0;
+    int carregados = 0;
+    bool ok = true;
+
+    pthread_mutex_lock(&mutex_placa);
+    double base = agora_ms();
+    while (fgets(linha, sizeof(linha), f)) {
+        numero++;
+        char *comentario = strchr(linha, '#');
+        if (comentario) {
+            *comentario = '\0';
+        }
+
+        double instante;
+        char comando[32], arg[32];
+        int a = 0, b = 0, c = 0;
+        int campos = sscanf(linha, "%lf %31s", &instante, comando);
+        if (campos <= 0) {
+            continue;                   // Linha vazia
+        }
+
+        bool valido = campos == 2;
+        if (valido && strcasecmp(comando, "vaga") == 0) {
+            valido = sscanf(linha, "%*f %*s %d %d %d", &a, &b, &c) == 3 &&
+                     agendar(base + instante, EVENTO_VAGA, a, b, c);
+        } else if (valido && (strcasecmp(comando, "entrada") == 0 || strcasecmp(comando, "saida") == 0)) {
+            // Faixa opcional (0 = a da fiação)
+            sscanf(linha, "%*f %*s %d", &a);
+            valido = a >= 0 && a < HAL_SIM_MAX_CANCELAS &&
+                     agendar(base + instante, strcasecmp(comando, "entrada") == 0 ? EVENTO_ENTRADA : EVENTO_SAIDA,
+                             a, 0, 0);
+        } else if (valido && strcasecmp(comando, "passagem") == 0) {
+            valido = sscanf(linha, "%*f %*s %d %31s", &a, arg) == 2 &&
+                     agendar(base + instante, EVENTO_PASSAGEM, a, strcasecmp(arg, "sobe") == 0, 0);
+        } else if (valido && strcasecmp(comando, "nivel") == 0) {
+            valido = sscanf(linha, "%*f %*s %d %d", &a, &b) == 2 &&
+                     agendar(base + instante, EVENTO_NIVEL, a, b, 0);
+        } else {
+            valido = false;
+        }
+
+        if (!valido) {
+            fprintf(stderr, "[SIM] %s:%d: comando inválido\n", arquivo, numero);
+            ok = false;
+        } else {
+            carregados++;
+        }
+    }
+    pthread_mutex_unlock(&mutex_placa);
+    fclose(f);
+
+    printf("[SIM] Roteiro %s: %d evento(s)\n", arquivo, carregados);
+    return ok;
+}
+
+/**
+ * @brief Indica se todos os eventos agendados e carros simulados terminaram
+ */
+bool hal_sim_ocioso() {
+    pthread_mutex_lock(&mutex_placa);
+    bool ocioso = true;
+    for (int i = 0; i < num_cancelas && ocioso; i++) {
+        ocioso = cancelas[i].fila == 0 && cancelas[i].estado == CARRO_AUSENTE && !cancelas[i].saindo;
+    }
+    for (int i = 0; i < HAL_SIM_MAX_EVENTOS && ocioso; i++) {
+        if (eventos[i].ativo) {
+            ocioso = false;
+        }
+    }
+    pthread_mutex_unlock(&mutex_placa);
+    return ocioso;
+}
+
+/**
+ * @brief Copia os contadores de acesso ao GPIO
+ */
+void hal_sim_obter_estatisticas(HalSimEstatisticas *out) {
+    pthread_mutex_lock(&mutex_placa);
+    *out = estatisticas;
+    pthread_mutex_unlock(&mutex_placa);
+}
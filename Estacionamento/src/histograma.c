@@ -0,0 +1,122 @@
+#include "../inc/histograma.h"
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * @brief Zera o histograma
+ */
+void histograma_init(Histograma *h, double base_us) {
+    memset(h, 0, sizeof(*h));
+    h->base_us = base_us;
+}
+
+/**
+ * @brief Limite superior (us) da faixa i
+ */
+double histograma_limite_us(const Histograma *h, int faixa) {
+    return h->base_us * (double)(1UL << faixa);
+}
+
+/**
+ * @brief Registra uma amostra
+ */
+void histograma_registrar(Histograma *h, double valor_us) {
+    int faixa = 0;
+    while (faixa < HISTOGRAMA_FAIXAS - 1 && valor_us >= histograma_limite_us(h, faixa)) {
+        faixa++;
+    }
+
+    h->contagem[faixa]++;
+    h->total++;
+    h->soma_us += valor_us;
+    if (valor_us > h->max_us) {
+        h->max_us = valor_us;
+    }
+}
+
+/**
+ * @brief Estima um percentil pelo limite superior da faixa que o contém
+ */
+double histograma_percentil(const Histograma *h, double p) {
+    if (h->total == 0) {
+        return 0;
+    }
+
+    unsigned long alvo = (unsigned long)(h->total * p / 100.0 + 0.5);
+    if (alvo < 1) {
+        alvo = 1;
+    }
+
+    unsigned long acumulado = 0;
+    for (int i = 0; i < HISTOGRAMA_FAIXAS; i++) {
+        acumulado += h->contagem[i];
+        if (acumulado >= alvo) {
+            // A última faixa é aberta: o melhor limite conhecido é o máximo
+            if (i == HISTOGRAMA_FAIXAS - 1) {
+                return h->max_us;
+            }
+            double limite = histograma_limite_us(h, i);
+            return (limite < h->max_us) ? limite : h->max_us;
+        }
+    }
+    return h->max_us;
+}
+
+/**
+ * @brief Estima um percentil interpolando linearmente dentro da faixa
+ */
+double histograma_quantil(const Histograma *h, double p) {
+    if (h->total == 0) {
+        return 0;
+    }
+
+    double alvo = h->total * p / 100.0;
+    double acumulado = 0;
+    for (int i = 0; i < HISTOGRAMA_FAIXAS; i++) {
+        if (h->contagem[i] == 0) {
+            continue;
+        }
+        if (acumulado + h->contagem[i] >= alvo) {
+            double inferior = (i == 0) ? 0 : histograma_limite_us(h, i - 1);
+            double superior = (i == HISTOGRAMA_FAIXAS - 1) ? h->max_us : histograma_limite_us(h, i);
+            double valor = inferior + (superior - inferior) * (alvo - acumulado) / h->contagem[i];
+            return (valor < h->max_us) ? valor : h->max_us;
+        }
+        acumulado += h->contagem[i];
+    }
+    return h->max_us;
+}
+
+/**
+ * @brief Média das amostras em microssegundos
+ */
+double histograma_media(const Histograma *h) {
+    return (h->total > 0) ? h->soma_us / h->total : 0;
+}
+
+/**
+ * @brief Imprime resumo e faixas não vazias
+ */
+void histograma_imprimir(const char *prefixo, const char *nome, const Histograma *h) {
+    printf("%s %s: n=%lu média=%.2f ms p50≤%.2f ms p95≤%.2f ms máx=%.2f ms\n",
+           prefixo, nome, h->total, histograma_media(h) / 1000.0,
+           histograma_percentil(h, 50) / 1000.0, histograma_percentil(h, 95) / 1000.0,
+           h->max_us / 1000.0);
+
+    if (h->total == 0) {
+        return;
+    }
+
+    printf("%s   ", prefixo);
+    for (int i = 0; i < HISTOGRAMA_FAIXAS; i++) {
+        if (h->contagem[i] == 0) {
+            continue;
+        }
+        if (i == HISTOGRAMA_FAIXAS - 1) {
+            printf("≥%.2fms:%lu ", histograma_limite_us(h, i - 1) / 1000.0, h->contagem[i]);
+        } else {
+            printf("<%.2fms:%lu ", histograma_limite_us(h, i) / 1000.0, h->contagem[i]);
+        }
+    }
+    printf("\n");
+}
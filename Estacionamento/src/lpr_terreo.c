@@ -1,5 +1,7 @@
 #include "../inc/lpr_terreo.h"
 #include "../inc/modbus.h"
+#include "../inc/barramento.h"
+#include "../inc/relogio.h"
 #include <stdio.h>
 #include <string.h>
 #include <unistd.h>
@@ -9,168 +11,298 @@
 int lpr_entrada_fd = -1;
 int lpr_saida_fd = -1;
 
-// Mutexes para acesso seguro às câmeras
-pthread_mutex_t mutex_lpr_entrada = PTHREAD_MUTEX_INITIALIZER;
-pthread_mutex_t mutex_lpr_saida = PTHREAD_MUTEX_INITIALIZER;
+// Captura pendente na fila de uma câmera
+typedef struct {
+    int numeroCarro;
+    LPRCallback callback;
+    double disparo_ms;          // relogio_agora_ms no enfileiramento
+} LPRCaptura;
+
+// Fila e thread de trabalho de uma câmera: o sensor só enfileira a captura
+// e a cancela não espera pela câmera
+typedef struct {
+    uint8_t endereco;
+    bool entrada;
+    char tag[24];               // Prefixo do log ("[LPR-Entrada]", "[LPR-Saída 0x14]")
+    LPRCaptura fila[LPR_FILA_CAPTURAS];
+    int inicio;
+    int tamanho;
+    bool rodando;
+    bool registrada;            // A thread já participa do relógio
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    // Serializa o fluxo da câmera (trigger → status → leitura → reset).
+    // A exclusão no fio é garantida pelo árbitro do barramento (barramento.c).
+    pthread_mutex_t fluxo;
+} LPRTrabalhador;
+
+// Câmeras registradas (lpr_adicionar_camera, antes de lpr_init)
+static LPRTrabalhador cameras[LPR_MAX_CAMERAS];
+static int num_cameras = 0;
+
+static bool processar(LPRTrabalhador *cam, int numeroCarro, char *placa_out, int *confianca_out);
 
 /**
- * @brief Inicializa câmeras LPR
+ * @brief Thread de uma câmera: executa as capturas enfileiradas, uma por vez
  */
-bool lpr_init(const char *porta_serial) {
-    // Inicializa comunicação MODBUS
-    lpr_entrada_fd = modbus_init(porta_serial);
-    
-    if(lpr_entrada_fd < 0) {
-        fprintf(stderr, "[LPR] Erro ao inicializar porta serial %s\n", porta_serial);
-        fprintf(stderr, "[LPR] Sistema funcionará SEM reconhecimento de placas\n");
-        fprintf(stderr, "[LPR] Todos os carros receberão tickets temporários\n");
-        return false;
-    }
+static void *thread_trabalhador_lpr(void *arg) {
+    LPRTrabalhador *t = (LPRTrabalhador *)arg;
     
-    // Usa o mesmo file descriptor para ambas as câmeras (mesmo barramento RS485)
-    lpr_saida_fd = lpr_entrada_fd;
+    // A primeira captura pode já estar na fila: a transação no fio (tempo real)
+    // não pode deixar o relógio virtual correr sem esta thread
+    relogio_participar_thread();
+    pthread_mutex_lock(&t->mutex);
+    t->registrada = true;
+    pthread_cond_broadcast(&t->cond);
+    pthread_mutex_unlock(&t->mutex);
     
-    printf("[LPR] Câmeras LPR inicializadas com sucesso\n");
-    printf("[LPR] - Câmera Entrada: 0x%02X\n", MODBUS_ADDR_LPR_ENTRADA);
-    printf("[LPR] - Câmera Saída: 0x%02X\n", MODBUS_ADDR_LPR_SAIDA);
-    printf("[LPR] - Limiar de confiança: %d%%\n", LPR_CONFIANCA_LIMIAR);
+    while (1) {
+        pthread_mutex_lock(&t->mutex);
+        // Espera no relógio: no modo virtual a thread é participante (o polling
+        // de status dorme nele) e não pode bloquear fora dele
+        while (t->rodando && t->tamanho == 0) {
+            relogio_esperar_cond(&t->cond, &t->mutex, LPR_FILA_ESPERA_MS);
+        }
+        if (!t->rodando) {
+            pthread_mutex_unlock(&t->mutex);
+            break;
+        }
+        LPRCaptura captura = t->fila[t->inicio];
+        t->inicio = (t->inicio + 1) % LPR_FILA_CAPTURAS;
+        t->tamanho--;
+        pthread_mutex_unlock(&t->mutex);
+        
+        LPRResultado resultado;
+        memset(&resultado, 0, sizeof(resultado));
+        resultado.numeroCarro = captura.numeroCarro;
+        resultado.camera = t->endereco;
+        resultado.entrada = t->entrada;
+        resultado.sucesso = processar(t, captura.numeroCarro, resultado.placa, &resultado.confianca);
+        
+        resultado.latencia_ms = relogio_agora_ms() - captura.disparo_ms;
+        
+        if (captura.callback) {
+            captura.callback(&resultado);
+        }
+    }
     
-    return true;
+    return NULL;
 }
 
 /**
- * @brief Finaliza câmeras LPR
+ * @brief Inicia a thread de trabalho de uma câmera
+ * @note Só volta depois de a thread participar do relógio: no modo virtual, o
+ *       tempo não pode saltar entre a criação e a primeira captura
  */
-void lpr_cleanup() {
-    if(lpr_entrada_fd >= 0) {
-        modbus_close(lpr_entrada_fd);
-        lpr_entrada_fd = -1;
-        lpr_saida_fd = -1;
-        printf("[LPR] Câmeras LPR finalizadas\n");
+static void iniciar_trabalhador(LPRTrabalhador *t) {
+    pthread_mutex_lock(&t->mutex);
+    t->inicio = 0;
+    t->tamanho = 0;
+    t->rodando = true;
+    t->registrada = false;
+    pthread_create(&t->thread, NULL, thread_trabalhador_lpr, t);
+    while (!t->registrada) {
+        pthread_cond_wait(&t->cond, &t->mutex);
     }
+    pthread_mutex_unlock(&t->mutex);
 }
 
 /**
- * @brief Processa entrada de um carro com LPR
+ * @brief Para a thread de trabalho de uma câmera (capturas pendentes são descartadas)
  */
-bool lpr_processar_entrada(int numeroCarro, char *placa_out, int *confianca_out) {
-    if(lpr_entrada_fd < 0) {
-        // Modo degradado: sem LPR
-        strcpy(placa_out, "");
-        *confianca_out = 0;
+static void parar_trabalhador(LPRTrabalhador *t) {
+    pthread_mutex_lock(&t->mutex);
+    bool rodando = t->rodando;
+    t->rodando = false;
+    relogio_sinalizar(&t->cond);
+    pthread_mutex_unlock(&t->mutex);
+    
+    if (rodando) {
+        relogio_liberar_thread();
+        pthread_join(t->thread, NULL);
+    }
+}
+
+/**
+ * @brief Enfileira uma captura para a câmera
+ */
+static bool agendar_captura(LPRTrabalhador *t, int numeroCarro, LPRCallback callback) {
+    // Câmera inexistente ou fora do ar: o chamador segue direto com ticket temporário
+    if (t == NULL || lpr_entrada_fd < 0 || !modbus_escravo_disponivel(t->endereco)) {
         return false;
     }
     
-    pthread_mutex_lock(&mutex_lpr_entrada);
-    
-    printf("[LPR-Entrada] Processando carro #%d...\n", numeroCarro);
-    
-    // Passo 1: Dispara trigger na câmera de entrada (0x11)
-    if(!lpr_trigger_capture(lpr_entrada_fd, MODBUS_ADDR_LPR_ENTRADA)) {
-        pthread_mutex_unlock(&mutex_lpr_entrada);
-        fprintf(stderr, "[LPR-Entrada] Erro ao disparar trigger\n");
-        strcpy(placa_out, "");
-        *confianca_out = 0;
+    pthread_mutex_lock(&t->mutex);
+    if (!t->rodando || t->tamanho >= LPR_FILA_CAPTURAS) {
+        pthread_mutex_unlock(&t->mutex);
+        fprintf(stderr, "[LPR 0x%02X] Fila de capturas cheia - carro #%d sem leitura de placa\n",
+                t->endereco, numeroCarro);
         return false;
     }
     
-    // Passo 2: Aguarda processamento (polling no status) com timeout de 2s
-    LPRStatus status = lpr_wait_processing(lpr_entrada_fd, MODBUS_ADDR_LPR_ENTRADA, 2000);
+    LPRCaptura *captura = &t->fila[(t->inicio + t->tamanho) % LPR_FILA_CAPTURAS];
+    captura->numeroCarro = numeroCarro;
+    captura->callback = callback;
+    captura->disparo_ms = relogio_agora_ms();
+    t->tamanho++;
+    relogio_sinalizar(&t->cond);
+    pthread_mutex_unlock(&t->mutex);
     
-    if(status != LPR_STATUS_OK) {
-        pthread_mutex_unlock(&mutex_lpr_entrada);
-        fprintf(stderr, "[LPR-Entrada] Erro ou timeout no processamento (status=%d)\n", status);
-        strcpy(placa_out, "");
-        *confianca_out = 0;
-        
-        // Zera trigger mesmo em caso de erro
-        lpr_reset_trigger(lpr_entrada_fd, MODBUS_ADDR_LPR_ENTRADA);
+    return true;
+}
+
+/**
+ * @brief Câmera registrada no endereço (NULL se não há)
+ */
+static LPRTrabalhador *buscar_camera(uint8_t endereco) {
+    for (int i = 0; i < num_cameras; i++) {
+        if (cameras[i].endereco == endereco) {
+            return &cameras[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Registra a câmera de uma faixa do térreo
+ */
+bool lpr_adicionar_camera(uint8_t endereco, bool entrada) {
+    if (lpr_entrada_fd >= 0) {
+        fprintf(stderr, "[LPR] Câmera 0x%02X registrada depois de lpr_init - ignorada\n", endereco);
         return false;
     }
     
-    // Passo 3: Lê dados da câmera (placa e confiança)
-    LPRData data;
-    if(!lpr_read_data(lpr_entrada_fd, MODBUS_ADDR_LPR_ENTRADA, &data)) {
-        pthread_mutex_unlock(&mutex_lpr_entrada);
-        fprintf(stderr, "[LPR-Entrada] Erro ao ler dados da câmera\n");
-        strcpy(placa_out, "");
-        *confianca_out = 0;
-        lpr_reset_trigger(lpr_entrada_fd, MODBUS_ADDR_LPR_ENTRADA);
+    // Duas faixas podem compartilhar a câmera, desde que na mesma direção
+    LPRTrabalhador *existente = buscar_camera(endereco);
+    if (existente) {
+        return existente->entrada == entrada;
+    }
+    if (num_cameras == LPR_MAX_CAMERAS) {
+        fprintf(stderr, "[LPR] Mais de %d câmeras - 0x%02X ignorada\n", LPR_MAX_CAMERAS, endereco);
         return false;
     }
     
-    // Passo 4: Zera trigger (conforme especificação)
-    lpr_reset_trigger(lpr_entrada_fd, MODBUS_ADDR_LPR_ENTRADA);
+    LPRTrabalhador *t = &cameras[num_cameras++];
+    memset(t, 0, sizeof(*t));
+    t->endereco = endereco;
+    t->entrada = entrada;
+    bool padrao = endereco == (entrada ? MODBUS_ADDR_LPR_ENTRADA : MODBUS_ADDR_LPR_SAIDA);
+    if (padrao) {
+        snprintf(t->tag, sizeof(t->tag), "[LPR-%s]", entrada ? "Entrada" : "Saída");
+    } else {
+        snprintf(t->tag, sizeof(t->tag), "[LPR-%s 0x%02X]", entrada ? "Entrada" : "Saída", endereco);
+    }
+    pthread_mutex_init(&t->mutex, NULL);
+    pthread_cond_init(&t->cond, NULL);
+    pthread_mutex_init(&t->fluxo, NULL);
+    return true;
+}
+
+/**
+ * @brief Inicializa câmeras LPR
+ */
+bool lpr_init(const char *porta_serial) {
+    // Câmeras e placar compartilham o barramento RS485: uma única thread é
+    // dona da porta e executa as transações de todos em ordem de prioridade
+    if(!barramento_init(porta_serial)) {
+        fprintf(stderr, "[LPR] Erro ao inicializar porta serial %s\n", porta_serial);
+        fprintf(stderr, "[LPR] Sistema funcionará SEM reconhecimento de placas\n");
+        fprintf(stderr, "[LPR] Todos os carros receberão tickets temporários\n");
+        return false;
+    }
     
-    pthread_mutex_unlock(&mutex_lpr_entrada);
+    if (num_cameras == 0) {
+        lpr_adicionar_camera(MODBUS_ADDR_LPR_ENTRADA, true);
+        lpr_adicionar_camera(MODBUS_ADDR_LPR_SAIDA, false);
+    }
     
-    // Copia resultados
-    strncpy(placa_out, data.placa, 8);
-    placa_out[8] = '\0';
-    *confianca_out = data.confianca;
+    // Usa o mesmo file descriptor para todas as câmeras (mesmo barramento RS485)
+    lpr_entrada_fd = barramento_fd();
+    lpr_saida_fd = lpr_entrada_fd;
     
-    // Log do resultado
-    if(data.confianca >= LPR_CONFIANCA_LIMIAR) {
-        printf("[LPR-Entrada] ✅ Placa lida: %s (confiança: %d%%)\n", data.placa, data.confianca);
-    } else {
-        printf("[LPR-Entrada] ⚠️  Baixa confiança: %s (%d%%) - será criado ticket temporário\n", 
-               data.placa, data.confianca);
+    printf("[LPR] Câmeras LPR inicializadas com sucesso\n");
+    for (int i = 0; i < num_cameras; i++) {
+        // Câmeras das faixas extras herdam a prioridade da direção no barramento
+        barramento_definir_prioridade(cameras[i].endereco,
+                                      cameras[i].entrada ? BARRAMENTO_PRIO_LPR_ENTRADA : BARRAMENTO_PRIO_LPR_SAIDA);
+        iniciar_trabalhador(&cameras[i]);
+        printf("[LPR] - Câmera %s: 0x%02X\n", cameras[i].entrada ? "Entrada" : "Saída", cameras[i].endereco);
     }
+    printf("[LPR] - Limiar de confiança: %d%%\n", LPR_CONFIANCA_LIMIAR);
     
     return true;
 }
 
 /**
- * @brief Processa saída de um carro com LPR
+ * @brief Finaliza câmeras LPR
+ * @note A porta serial pertence ao barramento (fechada por barramento_finalizar)
  */
-bool lpr_processar_saida(char *placa_out, int *confianca_out) {
-    if(lpr_saida_fd < 0) {
+void lpr_cleanup() {
+    if(lpr_entrada_fd >= 0) {
+        for (int i = 0; i < num_cameras; i++) {
+            parar_trabalhador(&cameras[i]);
+        }
+        lpr_entrada_fd = -1;
+        lpr_saida_fd = -1;
+        printf("[LPR] Câmeras LPR finalizadas\n");
+    }
+}
+
+/**
+ * @brief Fluxo de uma captura na câmera (thread de trabalho ou chamada direta)
+ * @param cam Câmera registrada (NULL = modo degradado)
+ */
+static bool processar(LPRTrabalhador *cam, int numeroCarro, char *placa_out, int *confianca_out) {
+    strcpy(placa_out, "");
+    *confianca_out = 0;
+    
+    if(cam == NULL || lpr_entrada_fd < 0) {
         // Modo degradado: sem LPR
-        strcpy(placa_out, "");
-        *confianca_out = 0;
         return false;
     }
     
-    pthread_mutex_lock(&mutex_lpr_saida);
-    
-    printf("[LPR-Saída] Processando saída...\n");
-    
-    // Passo 1: Dispara trigger na câmera de saída (0x12)
-    if(!lpr_trigger_capture(lpr_saida_fd, MODBUS_ADDR_LPR_SAIDA)) {
-        pthread_mutex_unlock(&mutex_lpr_saida);
-        fprintf(stderr, "[LPR-Saída] Erro ao disparar trigger\n");
-        strcpy(placa_out, "");
-        *confianca_out = 0;
+    // Câmera fora do ar (disjuntor aberto): ticket temporário sem esperar
+    if(!modbus_escravo_disponivel(cam->endereco)) {
+        printf("%s Câmera fora do ar - seguindo sem leitura de placa\n", cam->tag);
         return false;
     }
     
-    // Passo 2: Aguarda processamento (polling no status) com timeout de 2s
-    LPRStatus status = lpr_wait_processing(lpr_saida_fd, MODBUS_ADDR_LPR_SAIDA, 2000);
+    pthread_mutex_lock(&cam->fluxo);
     
-    if(status != LPR_STATUS_OK) {
-        pthread_mutex_unlock(&mutex_lpr_saida);
-        fprintf(stderr, "[LPR-Saída] Erro ou timeout no processamento (status=%d)\n", status);
-        strcpy(placa_out, "");
-        *confianca_out = 0;
-        lpr_reset_trigger(lpr_saida_fd, MODBUS_ADDR_LPR_SAIDA);
+    printf("%s Processando carro #%d...\n", cam->tag, numeroCarro);
+    
+    // Passo 1: Dispara trigger e já lê status/placa na mesma transação (0x17)
+    LPRData data;
+    if(!lpr_trigger_and_read(lpr_entrada_fd, cam->endereco, &data)) {
+        fprintf(stderr, "%s Erro ao disparar trigger\n", cam->tag);
+        
+        // A escrita pode ter chegado mesmo sem resposta: zera antes de liberar a câmera
+        lpr_reset_trigger(lpr_entrada_fd, cam->endereco);
+        pthread_mutex_unlock(&cam->fluxo);
         return false;
     }
     
-    // Passo 3: Lê dados da câmera (placa e confiança)
-    LPRData data;
-    if(!lpr_read_data(lpr_saida_fd, MODBUS_ADDR_LPR_SAIDA, &data)) {
-        pthread_mutex_unlock(&mutex_lpr_saida);
-        fprintf(stderr, "[LPR-Saída] Erro ao ler dados da câmera\n");
-        strcpy(placa_out, "");
-        *confianca_out = 0;
-        lpr_reset_trigger(lpr_saida_fd, MODBUS_ADDR_LPR_SAIDA);
+    // Passo 2: Aguarda processamento (polling no status) com timeout de 2s.
+    // Cada consulta lê o bloco inteiro: a que vê OK já traz placa e confiança
+    LPRStatus status = data.status;
+    if(status != LPR_STATUS_OK && status != LPR_STATUS_ERRO) {
+        status = lpr_wait_processing(lpr_entrada_fd, cam->endereco, 2000, &data);
+    }
+    
+    if(status != LPR_STATUS_OK) {
+        fprintf(stderr, "%s Erro ou timeout no processamento (status=%d)\n", cam->tag, status);
+        
+        // Zera trigger mesmo em caso de erro, antes de liberar a câmera
+        lpr_reset_trigger(lpr_entrada_fd, cam->endereco);
+        pthread_mutex_unlock(&cam->fluxo);
         return false;
     }
     
-    // Passo 4: Zera trigger
-    lpr_reset_trigger(lpr_saida_fd, MODBUS_ADDR_LPR_SAIDA);
+    // Passo 3: Zera trigger (conforme especificação)
+    lpr_reset_trigger(lpr_entrada_fd, cam->endereco);
     
-    pthread_mutex_unlock(&mutex_lpr_saida);
+    pthread_mutex_unlock(&cam->fluxo);
     
     // Copia resultados
     strncpy(placa_out, data.placa, 8);
@@ -179,11 +311,34 @@ bool lpr_processar_saida(char *placa_out, int *confianca_out) {
     
     // Log do resultado
     if(data.confianca >= LPR_CONFIANCA_LIMIAR) {
-        printf("[LPR-Saída] ✅ Placa lida: %s (confiança: %d%%)\n", data.placa, data.confianca);
+        printf("%s ✅ Placa lida: %s (confiança: %d%%)\n", cam->tag, data.placa, data.confianca);
+    } else if(cam->entrada) {
+        printf("%s ⚠️  Baixa confiança: %s (%d%%) - será criado ticket temporário\n",
+               cam->tag, data.placa, data.confianca);
     } else {
-        printf("[LPR-Saída] ⚠️  Baixa confiança: %s (%d%%)\n", data.placa, data.confianca);
+        printf("%s ⚠️  Baixa confiança: %s (%d%%)\n", cam->tag, data.placa, data.confianca);
     }
     
     return true;
 }
 
+/**
+ * @brief Agenda a captura de placa numa câmera registrada sem bloquear
+ */
+bool lpr_capturar_async(uint8_t endereco, int numeroCarro, LPRCallback callback) {
+    return agendar_captura(buscar_camera(endereco), numeroCarro, callback);
+}
+
+/**
+ * @brief Agenda a captura de placa na câmera de entrada sem bloquear
+ */
+bool lpr_capturar_entrada_async(int numeroCarro, LPRCallback callback) {
+    return lpr_capturar_async(MODBUS_ADDR_LPR_ENTRADA, numeroCarro, callback);
+}
+
+/**
+ * @brief Agenda a captura de placa na câmera de saída sem bloquear
+ */
+bool lpr_capturar_saida_async(int numeroCarro, LPRCallback callback) {
+    return lpr_capturar_async(MODBUS_ADDR_LPR_SAIDA, numeroCarro, callback);
+}
@@ -1,4 +1,3 @@
-#include <bcm2835.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <pthread.h>
@@ -1,4 +1,7 @@
+#define _GNU_SOURCE  // ppoll()
 #include "../inc/modbus.h"
+#include "../inc/barramento.h"
+#include "../inc/relogio.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -6,12 +9,46 @@
 #include <fcntl.h>
 #include <termios.h>
 #include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <time.h>
 #include <sys/time.h>
 
+// Parâmetros do disjuntor (ambiente ou padrão), lidos por modbus_init
+static int disjuntor_falhas = MODBUS_DISJUNTOR_FALHAS;
+static int disjuntor_sondagem_ms = MODBUS_DISJUNTOR_SONDAGEM_MS;
+
+/**
+ * @brief Porta serial configurada (ambiente MODBUS_SERIAL_PORT ou padrão)
+ */
+const char *modbus_porta_serial() {
+    const char *porta = getenv("MODBUS_SERIAL_PORT");
+    return (porta && porta[0]) ? porta : MODBUS_SERIAL_PORT;
+}
+
+/**
+ * @brief Inteiro positivo do ambiente, ou o padrão se ausente ou inválido
+ */
+static int inteiro_do_ambiente(const char *nome, int padrao) {
+    const char *texto = getenv(nome);
+    if (!texto || !texto[0]) {
+        return padrao;
+    }
+    int n = atoi(texto);
+    if (n <= 0) {
+        printf("[MODBUS] %s inválido '%s', usando %d\n", nome, texto, padrao);
+        return padrao;
+    }
+    return n;
+}
+
 /**
  * @brief Inicializa a comunicação MODBUS serial
  */
 int modbus_init(const char *porta) {
+    disjuntor_falhas = inteiro_do_ambiente("MODBUS_DISJUNTOR_FALHAS", MODBUS_DISJUNTOR_FALHAS);
+    disjuntor_sondagem_ms = inteiro_do_ambiente("MODBUS_DISJUNTOR_SONDAGEM_MS", MODBUS_DISJUNTOR_SONDAGEM_MS);
+    
     int fd = open(porta, O_RDWR | O_NOCTTY | O_NDELAY);
     
     if (fd == -1) {
@@ -123,101 +160,561 @@ static void print_hex_debug(const char *prefix, uint8_t *buffer, int length) {
 }
 
 /**
- * @brief Lê holding registers (função 0x03) com retry automático
+ * @brief Calcula o tamanho total esperado de um quadro de resposta
+ * @return tamanho em bytes, 0 se ainda não é possível determinar,
+ *         -1 se a função é desconhecida (fim do quadro só pelo silêncio)
  */
-bool modbus_read_holding_registers(int fd, uint8_t slave_addr, uint16_t start_addr, 
-                                   uint16_t num_regs, uint16_t *output) {
-    uint8_t request[12];
-    uint8_t response[256];
+static int modbus_tamanho_esperado(const uint8_t *quadro, int len) {
+    if (len < 2) {
+        return 0;
+    }
     
-    // Array de delays progressivos para retries
-    const int delays_ms[] = {MODBUS_MIN_DELAY_MS, MODBUS_MEDIUM_DELAY_MS, MODBUS_MAX_DELAY_MS};
+    // Resposta de exceção: addr, func|0x80, código, CRC(2)
+    if (quadro[1] & 0x80) {
+        return 5;
+    }
     
-    // Monta requisição MODBUS (Little Endian - compatível com C++)
-    request[0] = slave_addr;
-    request[1] = MODBUS_FUNC_READ_HOLDING;
-    request[2] = start_addr & 0xFF;         // LSB first (Little Endian)
-    request[3] = (start_addr >> 8) & 0xFF;  // MSB second
-    request[4] = num_regs & 0xFF;           // LSB first (Little Endian)
-    request[5] = (num_regs >> 8) & 0xFF;    // MSB second
+    switch (quadro[1]) {
+        case MODBUS_FUNC_READ_HOLDING:
+        case MODBUS_FUNC_READ_WRITE_MULTIPLE:
+            // addr, func, byte_count, dados[byte_count], CRC(2)
+            return (len < 3) ? 0 : 5 + quadro[2];
+        case MODBUS_FUNC_WRITE_MULTIPLE:
+            // addr, func, start(2), num_regs(2), CRC(2)
+            return 8;
+        default:
+            return -1;
+    }
+}
+
+/**
+ * @brief Recebe um quadro RTU de forma incremental
+ * 
+ * Espera o primeiro byte por até timeout_ms. A partir daí o quadro
+ * termina quando atinge o tamanho esperado (deduzido do cabeçalho) ou quando
+ * a linha fica em silêncio por 3,5 caracteres (MODBUS_SILENCIO_T35_US).
+ * 
+ * @param timeout_ms Espera máxima pelo primeiro byte
+ * @param primeiro_byte Preenchido com o instante em que chegou o primeiro byte
+ * @return número de bytes recebidos (0 = timeout sem resposta, -1 = erro)
+ */
+static int modbus_receber_quadro(int fd, uint8_t *quadro, int max_len, int timeout_ms,
+                                 struct timespec *primeiro_byte) {
+    struct pollfd pfd = { .fd = fd, .events = POLLIN };
+    int len = 0;
+    int esperado = 0;
     
-    // Matrícula binária antes do CRC (conforme implementação C++)
-    request[6] = MODBUS_MATRICULA[0];  // 0x00
-    request[7] = MODBUS_MATRICULA[1];  // 0x07
-    request[8] = MODBUS_MATRICULA[2];  // 0x07
-    request[9] = MODBUS_MATRICULA[3];  // 0x00
+    while (len < max_len) {
+        struct timespec espera;
+        if (len == 0) {
+            espera.tv_sec = timeout_ms / 1000;
+            espera.tv_nsec = (timeout_ms % 1000) * 1000000L;
+        } else {
+            espera.tv_sec = 0;
+            espera.tv_nsec = MODBUS_SILENCIO_T35_US * 1000L;
+        }
+        
+        int pronto = ppoll(&pfd, 1, &espera, NULL);
+        if (pronto < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            fprintf(stderr, "[MODBUS] Erro no poll: %s\n", strerror(errno));
+            return -1;
+        }
+        if (pronto == 0) {
+            break;  // Timeout (len == 0) ou silêncio de fim de quadro
+        }
+        
+        // Lê no máximo até o fim do quadro esperado para não consumir o próximo
+        int limite = (esperado > 0) ? esperado - len : max_len - len;
+        int n = read(fd, quadro + len, limite);
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EINTR) {
+                continue;
+            }
+            fprintf(stderr, "[MODBUS] Erro na leitura: %s\n", strerror(errno));
+            return -1;
+        }
+        if (len == 0 && n > 0) {
+            clock_gettime(CLOCK_MONOTONIC, primeiro_byte);
+        }
+        len += n;
+        
+        if (esperado <= 0) {
+            esperado = modbus_tamanho_esperado(quadro, len);
+            if (esperado > max_len) {
+                esperado = max_len;
+            }
+        }
+        if (esperado > 0 && len >= esperado) {
+            break;  // Quadro completo: não precisa esperar o silêncio
+        }
+    }
     
-    // Calcula CRC incluindo a matrícula
-    uint16_t crc = modbus_crc16(request, 10);
-    request[10] = crc & 0xFF;
-    request[11] = (crc >> 8) & 0xFF;
+    return len;
+}
+
+// ========== Disjuntor por escravo ==========
+
+// Estado de saúde indexado pelo endereço do escravo
+typedef struct {
+    ModbusSaude estado;
+    int falhas_consecutivas;
+    struct timespec ultima_sondagem;    // Abertura ou última sondagem
+    unsigned long aberturas;
+    unsigned long rejeitadas;           // Chamadas que falharam sem ir ao fio
+} ModbusDisjuntor;
+
+static ModbusDisjuntor disjuntores[256];
+static pthread_mutex_t mutex_disjuntores = PTHREAD_MUTEX_INITIALIZER;
+
+static const char *nomes_saude[] = {"FECHADO", "ABERTO", "MEIO-ABERTO"};
+
+/**
+ * @brief Atualiza o disjuntor com o resultado de uma transação
+ * @param respondeu true se o escravo devolveu um quadro válido (inclusive exceção)
+ */
+static void disjuntor_registrar(uint8_t slave_addr, bool respondeu) {
+    pthread_mutex_lock(&mutex_disjuntores);
+    ModbusDisjuntor *d = &disjuntores[slave_addr];
+    
+    if (respondeu) {
+        if (d->estado != MODBUS_SAUDE_FECHADO) {
+            printf("[MODBUS 0x%02X] ✅ Dispositivo respondeu - disjuntor FECHADO\n", slave_addr);
+        }
+        d->estado = MODBUS_SAUDE_FECHADO;
+        d->falhas_consecutivas = 0;
+    } else {
+        d->falhas_consecutivas++;
+        if (d->estado == MODBUS_SAUDE_MEIO_ABERTO ||
+            (d->estado == MODBUS_SAUDE_FECHADO && d->falhas_consecutivas >= disjuntor_falhas)) {
+            if (d->estado == MODBUS_SAUDE_FECHADO) {
+                d->aberturas++;
+                fprintf(stderr, "[MODBUS 0x%02X] ⚠️  %d falhas seguidas - disjuntor ABERTO "
+                        "(chamadas falham sem acessar o barramento)\n", slave_addr, d->falhas_consecutivas);
+            }
+            d->estado = MODBUS_SAUDE_ABERTO;
+            clock_gettime(CLOCK_MONOTONIC, &d->ultima_sondagem);
+        }
+    }
+    
+    pthread_mutex_unlock(&mutex_disjuntores);
+}
+
+/**
+ * @brief Indica se o escravo pode receber tráfego normal
+ */
+bool modbus_escravo_disponivel(uint8_t slave_addr) {
+    pthread_mutex_lock(&mutex_disjuntores);
+    bool disponivel = disjuntores[slave_addr].estado == MODBUS_SAUDE_FECHADO;
+    pthread_mutex_unlock(&mutex_disjuntores);
+    return disponivel;
+}
+
+/**
+ * @brief Estado atual do disjuntor do escravo
+ */
+ModbusSaude modbus_saude_escravo(uint8_t slave_addr) {
+    pthread_mutex_lock(&mutex_disjuntores);
+    ModbusSaude estado = disjuntores[slave_addr].estado;
+    pthread_mutex_unlock(&mutex_disjuntores);
+    return estado;
+}
+
+// ========== Instrumentação por escravo ==========
+
+// Estatísticas indexadas pelo endereço do escravo
+static ModbusEstatisticas estatisticas_escravos[256];
+static bool estatisticas_iniciadas[256];
+static pthread_mutex_t mutex_estatisticas = PTHREAD_MUTEX_INITIALIZER;
+
+// Resultado de uma transação, acumulado sem trava e publicado no final
+typedef struct {
+    int tentativas;
+    int timeouts;
+    int erros_crc;
+    int endereco_errado;
+    int quadros_invalidos;
+    int excecoes;
+    bool sucesso;
+    bool interrompida;              // Parou antes do fim por falta de orçamento
+    double primeiro_byte_us[MODBUS_RETRIES];
+    int amostras_primeiro_byte;
+    double total_us;
+} ModbusResumoTransacao;
+
+static double diff_us(struct timespec a, struct timespec b) {
+    return (b.tv_sec - a.tv_sec) * 1000000.0 + (b.tv_nsec - a.tv_nsec) / 1000.0;
+}
+
+/**
+ * @brief Retorna as estatísticas do escravo, inicializando na primeira vez
+ * @note Deve ser chamada com mutex_estatisticas travado
+ */
+static ModbusEstatisticas *estatisticas_de(uint8_t slave_addr) {
+    ModbusEstatisticas *e = &estatisticas_escravos[slave_addr];
+    if (!estatisticas_iniciadas[slave_addr]) {
+        memset(e, 0, sizeof(*e));
+        histograma_init(&e->primeiro_byte, MODBUS_HIST_BASE_US);
+        histograma_init(&e->transacao, MODBUS_HIST_BASE_US);
+        estatisticas_iniciadas[slave_addr] = true;
+    }
+    return e;
+}
+
+/**
+ * @brief Publica o resumo de uma transação nas estatísticas do escravo
+ */
+static void estatisticas_registrar(uint8_t slave_addr, const ModbusResumoTransacao *r) {
+    pthread_mutex_lock(&mutex_estatisticas);
+    ModbusEstatisticas *e = estatisticas_de(slave_addr);
     
-    // Sistema de retry com delays progressivos
-    for (int retry = 0; retry < MODBUS_RETRIES; retry++) {
+    e->transacoes++;
+    if (r->sucesso) {
+        e->sucessos++;
+    } else {
+        e->falhas++;
+    }
+    e->retries += (r->tentativas > 1) ? r->tentativas - 1 : 0;
+    e->timeouts += r->timeouts;
+    e->erros_crc += r->erros_crc;
+    e->endereco_errado += r->endereco_errado;
+    e->quadros_invalidos += r->quadros_invalidos;
+    e->excecoes += r->excecoes;
+    e->interrompidas += r->interrompida ? 1 : 0;
+    for (int i = 0; i < r->amostras_primeiro_byte; i++) {
+        histograma_registrar(&e->primeiro_byte, r->primeiro_byte_us[i]);
+    }
+    histograma_registrar(&e->transacao, r->total_us);
+    
+    pthread_mutex_unlock(&mutex_estatisticas);
+}
+
+/**
+ * @brief Copia as estatísticas de um escravo
+ */
+bool modbus_estatisticas_obter(uint8_t slave_addr, ModbusEstatisticas *out) {
+    pthread_mutex_lock(&mutex_estatisticas);
+    bool existe = estatisticas_iniciadas[slave_addr];
+    if (existe) {
+        *out = estatisticas_escravos[slave_addr];
+    }
+    pthread_mutex_unlock(&mutex_estatisticas);
+    return existe;
+}
+
+/**
+ * @brief Zera as estatísticas de todos os escravos
+ */
+void modbus_estatisticas_zerar() {
+    pthread_mutex_lock(&mutex_estatisticas);
+    memset(estatisticas_iniciadas, 0, sizeof(estatisticas_iniciadas));
+    pthread_mutex_unlock(&mutex_estatisticas);
+}
+
+/**
+ * @brief Imprime contadores e histogramas de todos os escravos com tráfego
+ */
+void modbus_estatisticas_imprimir() {
+    for (int addr = 0; addr < 256; addr++) {
+        ModbusEstatisticas e;
+        if (!modbus_estatisticas_obter((uint8_t)addr, &e)) {
+            continue;
+        }
+        
+        char prefixo[32];
+        snprintf(prefixo, sizeof(prefixo), "[MODBUS 0x%02X]", addr);
+        printf("%s transações=%lu sucesso=%lu falha=%lu retries=%lu timeouts=%lu "
+               "crc=%lu endereço_errado=%lu inválidos=%lu exceções=%lu interrompidas=%lu\n",
+               prefixo, e.transacoes, e.sucessos, e.falhas, e.retries, e.timeouts,
+               e.erros_crc, e.endereco_errado, e.quadros_invalidos, e.excecoes,
+               e.interrompidas);
+        pthread_mutex_lock(&mutex_disjuntores);
+        ModbusDisjuntor d = disjuntores[addr];
+        pthread_mutex_unlock(&mutex_disjuntores);
+        printf("%s disjuntor=%s aberturas=%lu rejeitadas=%lu\n",
+               prefixo, nomes_saude[d.estado], d.aberturas, d.rejeitadas);
+        histograma_imprimir(prefixo, "1º byte", &e.primeiro_byte);
+        histograma_imprimir(prefixo, "transação", &e.transacao);
+    }
+}
+
+/**
+ * @brief Executa uma transação MODBUS no fio com o número de tentativas dado
+ * 
+ * Retorna assim que um quadro válido chega, em vez de dormir o timeout
+ * inteiro antes de ler a porta. Com orçamento, cada tentativa só começa se
+ * couber no tempo restante (backoff + MODBUS_ORCAMENTO_MIN_MS) e a espera pelo
+ * primeiro byte é encurtada para não passar dele.
+ */
+static bool modbus_transacao_fio(int fd, uint8_t *request, int req_len,
+                                 uint8_t *response, int resp_len, const char *rotulo,
+                                 int tentativas, ModbusOrcamento orcamento) {
+    uint8_t slave_addr = request[0];
+    uint8_t funcao = request[1];
+    ModbusResumoTransacao resumo;
+    memset(&resumo, 0, sizeof(resumo));
+    
+    struct timespec inicio, enviado, primeiro_byte, fim;
+    clock_gettime(CLOCK_MONOTONIC, &inicio);
+    
+    // Array de delays progressivos para retries
+    const int delays_ms[] = {MODBUS_MIN_DELAY_MS, MODBUS_MEDIUM_DELAY_MS, MODBUS_MAX_DELAY_MS};
+    
+    for (int retry = 0; retry < tentativas && !resumo.sucesso; retry++) {
+        int atraso_ms = (retry > 0) ? delays_ms[retry - 1] : 0;
+        int timeout_ms = MODBUS_TIMEOUT_MS;
+        if (orcamento) {
+            int restante_ms = orcamento() - atraso_ms;
+            if (restante_ms < MODBUS_ORCAMENTO_MIN_MS) {
+                fprintf(stderr, "[MODBUS] %s interrompida antes da tentativa %d/%d "
+                        "(orçamento esgotado ou pedido mais urgente na fila)\n",
+                        rotulo, retry + 1, tentativas);
+                resumo.interrompida = true;
+                break;
+            }
+            if (restante_ms < timeout_ms) {
+                timeout_ms = restante_ms;
+                resumo.interrompida = true;     // Vale só se esta tentativa também falhar
+            }
+        }
         if (retry > 0) {
-            fprintf(stderr, "[MODBUS] Tentativa %d/%d...\n", retry + 1, MODBUS_RETRIES);
-            usleep(delays_ms[retry - 1] * 1000);
+            fprintf(stderr, "[MODBUS] %s tentativa %d/%d...\n", rotulo, retry + 1, tentativas);
+            usleep(atraso_ms * 1000);
         }
+        resumo.tentativas++;
         
-        // Envia requisição
+        // Descarta lixo de transações anteriores e envia requisição
         tcflush(fd, TCIOFLUSH);
-        int written = write(fd, request, 12);
-        if (written != 12) {
+        int written = write(fd, request, req_len);
+        if (written != req_len) {
             fprintf(stderr, "[MODBUS] Erro ao enviar (tentativa %d): %s\n", retry + 1, strerror(errno));
             continue;
         }
+        clock_gettime(CLOCK_MONOTONIC, &enviado);
         
         // Debug: mostra pacote enviado (apenas na primeira tentativa)
         if (retry == 0) {
-            print_hex_debug("TX", request, 12);
+            char prefixo[32];
+            snprintf(prefixo, sizeof(prefixo), "TX %s", rotulo);
+            print_hex_debug(prefixo, request, req_len);
         }
         
-        // Aguarda resposta
-        usleep(MODBUS_TIMEOUT_MS * 1000);
+        int bytes_read = modbus_receber_quadro(fd, response, resp_len, timeout_ms, &primeiro_byte);
         
-        int expected_len = 5 + (num_regs * 2);
-        int bytes_read = read(fd, response, expected_len);
-        
-        if (bytes_read < expected_len) {
-            fprintf(stderr, "[MODBUS] Timeout (esperado %d, recebido %d)\n", expected_len, bytes_read);
+        if (bytes_read <= 0) {
+            resumo.timeouts++;
+            fprintf(stderr, "[MODBUS] Timeout (esperado %d, recebido %d)\n", resp_len, bytes_read);
             continue;
         }
+        resumo.primeiro_byte_us[resumo.amostras_primeiro_byte++] = diff_us(enviado, primeiro_byte);
         
         // Debug: mostra resposta recebida (apenas na primeira tentativa)
         if (retry == 0) {
-            print_hex_debug("RX", response, bytes_read);
+            char prefixo[32];
+            snprintf(prefixo, sizeof(prefixo), "RX %s", rotulo);
+            print_hex_debug(prefixo, response, bytes_read);
         }
         
         // Verifica endereço e função
-        if (response[0] != slave_addr || response[1] != MODBUS_FUNC_READ_HOLDING) {
+        if (response[0] != slave_addr || (response[1] & 0x7F) != funcao) {
+            resumo.endereco_errado++;
             fprintf(stderr, "[MODBUS] Resposta inválida (addr=0x%02X func=0x%02X)\n", 
                     response[0], response[1]);
             continue;
         }
         
+        if (bytes_read < 5) {
+            resumo.quadros_invalidos++;
+            fprintf(stderr, "[MODBUS] Quadro truncado (%d bytes)\n", bytes_read);
+            continue;
+        }
+        
         // Verifica CRC
         uint16_t received_crc = response[bytes_read - 2] | (response[bytes_read - 1] << 8);
         uint16_t calculated_crc = modbus_crc16(response, bytes_read - 2);
         
         if (received_crc != calculated_crc) {
+            resumo.erros_crc++;
             fprintf(stderr, "[MODBUS] Erro de CRC (esperado 0x%04X, recebido 0x%04X)\n", 
                     calculated_crc, received_crc);
             continue;
         }
         
-        // Extrai dados (Little Endian - compatível com C++)
-        int byte_count = response[2];
-        for (int i = 0; i < num_regs; i++) {
-            output[i] = response[3 + i * 2] | (response[4 + i * 2] << 8);  // LSB | MSB
+        // Exceção MODBUS: o escravo respondeu, mas recusou a requisição
+        if (response[1] & 0x80) {
+            resumo.excecoes++;
+            fprintf(stderr, "[MODBUS] Exceção 0x%02X do escravo 0x%02X (func=0x%02X)\n",
+                    response[2], slave_addr, funcao);
+            break;
+        }
+        
+        if (bytes_read != resp_len) {
+            resumo.quadros_invalidos++;
+            fprintf(stderr, "[MODBUS] Tamanho inesperado (esperado %d, recebido %d)\n",
+                    resp_len, bytes_read);
+            continue;
         }
         
         // Sucesso!
-        return true;
+        resumo.sucesso = true;
+    }
+    
+    bool respondeu = resumo.sucesso || resumo.excecoes > 0;
+    resumo.interrompida = resumo.interrompida && !respondeu;
+    clock_gettime(CLOCK_MONOTONIC, &fim);
+    resumo.total_us = diff_us(inicio, fim);
+    estatisticas_registrar(slave_addr, &resumo);
+    
+    // Transação cortada pelo orçamento não prova que o escravo está fora do ar
+    if (!resumo.interrompida) {
+        disjuntor_registrar(slave_addr, respondeu);
+    }
+    
+    if (!respondeu && !resumo.interrompida) {
+        // Falhou após todas as tentativas
+        fprintf(stderr, "[MODBUS] %s falhou após %d tentativas\n", rotulo, tentativas);
+    }
+    return resumo.sucesso;
+}
+
+/**
+ * @brief Executa uma transação MODBUS diretamente no fio, com retry
+ */
+bool modbus_transacao_direta(int fd, uint8_t *request, int req_len,
+                             uint8_t *response, int resp_len, const char *rotulo,
+                             ModbusOrcamento orcamento) {
+    return modbus_transacao_fio(fd, request, req_len, response, resp_len, rotulo,
+                                MODBUS_RETRIES, orcamento);
+}
+
+/**
+ * @brief Sonda os escravos com disjuntor aberto cujo intervalo de sondagem venceu
+ * 
+ * Cada sondagem é uma única leitura do registro 0, sem retry: o dispositivo
+ * volta ao tráfego normal assim que responder. As sondagens param assim que o
+ * orçamento se esgota (um pedido chegou à fila); as restantes ficam para a
+ * próxima folga do barramento.
+ */
+void modbus_sondar_escravos(int fd, ModbusOrcamento orcamento) {
+    struct timespec agora;
+    clock_gettime(CLOCK_MONOTONIC, &agora);
+    
+    for (int addr = 0; addr < 256; addr++) {
+        if (orcamento && orcamento() < MODBUS_ORCAMENTO_MIN_MS) {
+            return;
+        }
+        
+        pthread_mutex_lock(&mutex_disjuntores);
+        ModbusDisjuntor *d = &disjuntores[addr];
+        struct timespec sondagem_anterior = d->ultima_sondagem;
+        bool vencida = d->estado == MODBUS_SAUDE_ABERTO &&
+                       diff_us(d->ultima_sondagem, agora) >= disjuntor_sondagem_ms * 1000.0;
+        if (vencida) {
+            d->estado = MODBUS_SAUDE_MEIO_ABERTO;
+            d->ultima_sondagem = agora;
+        }
+        pthread_mutex_unlock(&mutex_disjuntores);
+        
+        if (!vencida) {
+            continue;
+        }
+        
+        // Leitura do registro 0 (status da câmera / primeiro registro do placar)
+        uint8_t request[12];
+        uint8_t response[7];
+        request[0] = (uint8_t)addr;
+        request[1] = MODBUS_FUNC_READ_HOLDING;
+        request[2] = 0;
+        request[3] = 0;
+        request[4] = 1;
+        request[5] = 0;
+        memcpy(&request[6], MODBUS_MATRICULA, 4);
+        uint16_t crc = modbus_crc16(request, 10);
+        request[10] = crc & 0xFF;
+        request[11] = (crc >> 8) & 0xFF;
+        
+        modbus_transacao_fio(fd, request, sizeof(request), response, sizeof(response), "Sonda",
+                             1, orcamento);
+        
+        // Sondagem interrompida não registra no disjuntor: volta a ABERTO e
+        // continua vencida para a próxima folga
+        pthread_mutex_lock(&mutex_disjuntores);
+        if (d->estado == MODBUS_SAUDE_MEIO_ABERTO) {
+            d->estado = MODBUS_SAUDE_ABERTO;
+            d->ultima_sondagem = sondagem_anterior;
+        }
+        pthread_mutex_unlock(&mutex_disjuntores);
+    }
+}
+
+/**
+ * @brief Executa uma transação, passando pelo árbitro do barramento se ele
+ *        for o dono da porta
+ */
+static bool modbus_transacao(int fd, uint8_t *request, int req_len,
+                             uint8_t *response, int resp_len, const char *rotulo) {
+    // Dispositivo fora do ar: falha imediatamente, sem ocupar o barramento
+    if (!modbus_escravo_disponivel(request[0])) {
+        pthread_mutex_lock(&mutex_disjuntores);
+        disjuntores[request[0]].rejeitadas++;
+        pthread_mutex_unlock(&mutex_disjuntores);
+        return false;
+    }
+    
+    if (barramento_deve_encaminhar(fd)) {
+        BarramentoPedido pedido;
+        barramento_preparar_pedido(&pedido, request, req_len, response, resp_len, rotulo);
+        return barramento_executar(&pedido);
+    }
+    
+    return modbus_transacao_direta(fd, request, req_len, response, resp_len, rotulo, NULL);
+}
+
+/**
+ * @brief Lê holding registers (função 0x03) com retry automático
+ */
+bool modbus_read_holding_registers(int fd, uint8_t slave_addr, uint16_t start_addr, 
+                                   uint16_t num_regs, uint16_t *output) {
+    uint8_t request[12];
+    uint8_t response[256];
+    
+    if (num_regs == 0 || num_regs > MODBUS_MAX_REGS_LEITURA) {
+        fprintf(stderr, "[MODBUS] Número de registros inválido para leitura: %d\n", num_regs);
+        return false;
+    }
+    
+    // Monta requisição MODBUS (Little Endian - compatível com C++)
+    request[0] = slave_addr;
+    request[1] = MODBUS_FUNC_READ_HOLDING;
+    request[2] = start_addr & 0xFF;         // LSB first (Little Endian)
+    request[3] = (start_addr >> 8) & 0xFF;  // MSB second
+    request[4] = num_regs & 0xFF;           // LSB first (Little Endian)
+    request[5] = (num_regs >> 8) & 0xFF;    // MSB second
+    
+    // Matrícula binária antes do CRC (conforme implementação C++)
+    request[6] = MODBUS_MATRICULA[0];  // 0x00
+    request[7] = MODBUS_MATRICULA[1];  // 0x07
+    request[8] = MODBUS_MATRICULA[2];  // 0x07
+    request[9] = MODBUS_MATRICULA[3];  // 0x00
+    
+    // Calcula CRC incluindo a matrícula
+    uint16_t crc = modbus_crc16(request, 10);
+    request[10] = crc & 0xFF;
+    request[11] = (crc >> 8) & 0xFF;
+    
+    int expected_len = 5 + (num_regs * 2);
+    if (!modbus_transacao(fd, request, 12, response, expected_len, "Read")) {
+        return false;
+    }
+    
+    // Extrai dados (Little Endian - compatível com C++)
+    for (int i = 0; i < num_regs; i++) {
+        output[i] = response[3 + i * 2] | (response[4 + i * 2] << 8);  // LSB | MSB
     }
     
-    // Falhou após todas as tentativas
-    fprintf(stderr, "[MODBUS] Falha após %d tentativas\n", MODBUS_RETRIES);
-    return false;
+    return true;
 }
 
 /**
@@ -226,10 +723,12 @@ bool modbus_read_holding_registers(int fd, uint8_t slave_addr, uint16_t start_ad
 bool modbus_write_multiple_registers(int fd, uint8_t slave_addr, uint16_t start_addr,
                                      uint16_t num_regs, uint16_t *data) {
     uint8_t request[260];
-    uint8_t response[12];
+    uint8_t response[8];
     
-    // Array de delays progressivos para retries
-    const int delays_ms[] = {MODBUS_MIN_DELAY_MS, MODBUS_MEDIUM_DELAY_MS, MODBUS_MAX_DELAY_MS};
+    if (num_regs == 0 || num_regs > MODBUS_MAX_REGS_ESCRITA) {
+        fprintf(stderr, "[MODBUS] Número de registros inválido para escrita: %d\n", num_regs);
+        return false;
+    }
     
     int byte_count = num_regs * 2;
     
@@ -261,54 +760,88 @@ bool modbus_write_multiple_registers(int fd, uint8_t slave_addr, uint16_t start_
     request[total_len] = crc & 0xFF;
     request[total_len + 1] = (crc >> 8) & 0xFF;
     
-    // Sistema de retry com delays progressivos
-    for (int retry = 0; retry < MODBUS_RETRIES; retry++) {
-        if (retry > 0) {
-            fprintf(stderr, "[MODBUS] Tentativa de escrita %d/%d...\n", retry + 1, MODBUS_RETRIES);
-            usleep(delays_ms[retry - 1] * 1000);
-        }
-        
-        // Envia requisição
-        tcflush(fd, TCIOFLUSH);
-        int written = write(fd, request, total_len + 2);
-        if (written != total_len + 2) {
-            fprintf(stderr, "[MODBUS] Erro ao enviar (tentativa %d)\n", retry + 1);
-            continue;
-        }
-        
-        // Debug: mostra pacote enviado (apenas na primeira tentativa)
-        if (retry == 0) {
-            print_hex_debug("TX Write", request, total_len + 2);
-        }
-        
-        // Aguarda confirmação
-        usleep(MODBUS_TIMEOUT_MS * 1000);
-        int bytes_read = read(fd, response, 8);
-        
-        if (bytes_read < 8) {
-            fprintf(stderr, "[MODBUS] Timeout na confirmação (recebido %d bytes)\n", bytes_read);
-            continue;
-        }
-        
-        // Debug: mostra resposta (apenas na primeira tentativa)
-        if (retry == 0) {
-            print_hex_debug("RX Write", response, bytes_read);
-        }
-        
-        // Verifica resposta
-        if (response[0] != slave_addr || response[1] != MODBUS_FUNC_WRITE_MULTIPLE) {
-            fprintf(stderr, "[MODBUS] Erro na confirmação (addr=0x%02X func=0x%02X)\n", 
-                    response[0], response[1]);
-            continue;
+    // Confirmação: addr, func, start(2), num_regs(2), CRC(2)
+    return modbus_transacao(fd, request, total_len + 2, response, 8, "Write");
+}
+
+// Escravos que já recusaram a função 0x17 com exceção (protegido por mutex_disjuntores)
+static bool sem_leitura_escrita[256];
+
+/**
+ * @brief Indica se vale tentar a função 0x17 com o escravo
+ */
+bool modbus_suporta_leitura_escrita(uint8_t slave_addr) {
+    pthread_mutex_lock(&mutex_disjuntores);
+    bool suporta = !sem_leitura_escrita[slave_addr];
+    pthread_mutex_unlock(&mutex_disjuntores);
+    return suporta;
+}
+
+/**
+ * @brief Escreve e lê holding registers numa única transação (função 0x17)
+ */
+bool modbus_read_write_multiple_registers(int fd, uint8_t slave_addr,
+                                          uint16_t read_start, uint16_t read_regs, uint16_t *output,
+                                          uint16_t write_start, uint16_t write_regs, uint16_t *data) {
+    uint8_t request[260];
+    uint8_t response[256];
+    
+    if (read_regs == 0 || read_regs > MODBUS_MAX_REGS_LEITURA ||
+        write_regs == 0 || write_regs > MODBUS_MAX_REGS_ESCRITA_RW) {
+        fprintf(stderr, "[MODBUS] Número de registros inválido para leitura/escrita: %d/%d\n",
+                read_regs, write_regs);
+        return false;
+    }
+    
+    int byte_count = write_regs * 2;
+    
+    // Monta requisição MODBUS (Little Endian - compatível com C++)
+    request[0] = slave_addr;
+    request[1] = MODBUS_FUNC_READ_WRITE_MULTIPLE;
+    request[2] = read_start & 0xFF;
+    request[3] = (read_start >> 8) & 0xFF;
+    request[4] = read_regs & 0xFF;
+    request[5] = (read_regs >> 8) & 0xFF;
+    request[6] = write_start & 0xFF;
+    request[7] = (write_start >> 8) & 0xFF;
+    request[8] = write_regs & 0xFF;
+    request[9] = (write_regs >> 8) & 0xFF;
+    request[10] = byte_count;
+    
+    for (int i = 0; i < write_regs; i++) {
+        request[11 + i * 2] = data[i] & 0xFF;
+        request[12 + i * 2] = (data[i] >> 8) & 0xFF;
+    }
+    
+    // Matrícula binária antes do CRC
+    int data_len = 11 + byte_count;
+    memcpy(&request[data_len], MODBUS_MATRICULA, 4);
+    
+    int total_len = data_len + 4;
+    uint16_t crc = modbus_crc16(request, total_len);
+    request[total_len] = crc & 0xFF;
+    request[total_len + 1] = (crc >> 8) & 0xFF;
+    
+    response[1] = 0;
+    int expected_len = 5 + (read_regs * 2);
+    if (!modbus_transacao(fd, request, total_len + 2, response, expected_len, "ReadWrite")) {
+        // Função ilegal: o escravo não implementa 0x17, não tenta de novo
+        if (response[0] == slave_addr && response[1] == (MODBUS_FUNC_READ_WRITE_MULTIPLE | 0x80) &&
+            response[2] == 0x01) {
+            pthread_mutex_lock(&mutex_disjuntores);
+            sem_leitura_escrita[slave_addr] = true;
+            pthread_mutex_unlock(&mutex_disjuntores);
+            printf("[MODBUS 0x%02X] Escravo não implementa a função 0x17 - usando 0x10 + 0x03\n",
+                   slave_addr);
         }
-        
-        // Sucesso!
-        return true;
+        return false;
     }
     
-    // Falhou após todas as tentativas
-    fprintf(stderr, "[MODBUS] Escrita falhou após %d tentativas\n", MODBUS_RETRIES);
-    return false;
+    for (int i = 0; i < read_regs; i++) {
+        output[i] = response[3 + i * 2] | (response[4 + i * 2] << 8);
+    }
+    
+    return true;
 }
 
 // ========== Funções específicas para LPR ==========
@@ -331,16 +864,9 @@ bool lpr_trigger_capture(int fd, uint8_t camera_addr) {
 }
 
 /**
- * @brief Lê dados da câmera LPR
+ * @brief Converte o bloco de registros da câmera na estrutura LPRData
  */
-bool lpr_read_data(int fd, uint8_t camera_addr, LPRData *data) {
-    uint16_t registers[8];
-    
-    // Lê 8 registros a partir do offset 0 (status, trigger, placa[4 regs], confiança, erro)
-    if (!modbus_read_holding_registers(fd, camera_addr, 0, 8, registers)) {
-        return false;
-    }
-    
+static void lpr_decodificar(const uint16_t *registers, LPRData *data) {
     // Status (offset 0)
     data->status = (LPRStatus)(registers[0] & 0xFF);
     
@@ -363,40 +889,245 @@ bool lpr_read_data(int fd, uint8_t camera_addr, LPRData *data) {
     
     // Erro (offset 7)
     data->erro = registers[7] & 0xFF;
+}
+
+/**
+ * @brief Lê dados da câmera LPR
+ */
+bool lpr_read_data(int fd, uint8_t camera_addr, LPRData *data) {
+    uint16_t registers[LPR_NUM_REGS];
+    
+    // Lê 8 registros a partir do offset 0 (status, trigger, placa[4 regs], confiança, erro)
+    if (!modbus_read_holding_registers(fd, camera_addr, 0, LPR_NUM_REGS, registers)) {
+        return false;
+    }
     
+    lpr_decodificar(registers, data);
     return true;
 }
 
 /**
- * @brief Aguarda processamento da placa (polling no status)
+ * @brief Dispara a captura e lê o bloco de status/placa na mesma transação
  */
-LPRStatus lpr_wait_processing(int fd, uint8_t camera_addr, int timeout_ms) {
-    struct timeval start, now;
-    gettimeofday(&start, NULL);
+bool lpr_trigger_and_read(int fd, uint8_t camera_addr, LPRData *data) {
+    if (modbus_suporta_leitura_escrita(camera_addr)) {
+        uint16_t trigger_value = 1;
+        uint16_t registers[LPR_NUM_REGS];
+        
+        if (modbus_read_write_multiple_registers(fd, camera_addr, 0, LPR_NUM_REGS, registers,
+                                                 1, 1, &trigger_value)) {
+            lpr_decodificar(registers, data);
+            printf("[LPR 0x%02X] Trigger disparado (status=%d)\n", camera_addr, data->status);
+            return true;
+        }
+        
+        // Falha que não foi recusa da função: não insiste com o trigger separado
+        if (modbus_suporta_leitura_escrita(camera_addr)) {
+            fprintf(stderr, "[LPR 0x%02X] Erro ao disparar trigger\n", camera_addr);
+            return false;
+        }
+    }
+    
+    // Câmera sem 0x17: trigger simples, estado ainda desconhecido
+    memset(data, 0, sizeof(*data));
+    data->status = LPR_STATUS_PROCESSANDO;
+    return lpr_trigger_capture(fd, camera_addr);
+}
+
+// Histórico de processamento das câmeras: uma posição por câmera vista no
+// barramento, na ordem da primeira captura (uma câmera por faixa do térreo)
+static LPRTempos tempos_lpr[LPR_MAX_CAMERAS];
+static uint8_t tempos_lpr_enderecos[LPR_MAX_CAMERAS];
+static int num_tempos_lpr = 0;
+static pthread_mutex_t mutex_tempos_lpr = PTHREAD_MUTEX_INITIALIZER;
+
+// Percentis que definem os instantes das consultas
+static const double percentis_consulta[] = {50, 75, 90, 95, 99};
+#define NUM_PERCENTIS_CONSULTA (int)(sizeof(percentis_consulta) / sizeof(percentis_consulta[0]))
+
+/**
+ * @brief Histórico da câmera
+ * @param criar Ocupa uma posição livre se a câmera ainda não tem histórico
+ * @return NULL se a câmera não tem histórico (e não foi criado)
+ * @note Deve ser chamada com mutex_tempos_lpr travado
+ */
+static LPRTempos *tempos_da_camera(uint8_t camera_addr, bool criar) {
+    for (int i = 0; i < num_tempos_lpr; i++) {
+        if (tempos_lpr_enderecos[i] == camera_addr) {
+            return &tempos_lpr[i];
+        }
+    }
+    if (!criar || num_tempos_lpr == LPR_MAX_CAMERAS) {
+        return NULL;
+    }
+    
+    LPRTempos *t = &tempos_lpr[num_tempos_lpr];
+    memset(t, 0, sizeof(*t));
+    histograma_init(&t->processamento, LPR_HIST_BASE_US);
+    tempos_lpr_enderecos[num_tempos_lpr++] = camera_addr;
+    return t;
+}
+
+/**
+ * @brief Calcula os instantes (ms após o trigger) das consultas de status
+ * @return número de instantes preenchidos (0 = sem histórico suficiente)
+ */
+static int lpr_agenda_consultas(uint8_t camera_addr, double *instantes_ms) {
+    int n = 0;
+    
+    pthread_mutex_lock(&mutex_tempos_lpr);
+    LPRTempos *t = tempos_da_camera(camera_addr, false);
+    if (t && t->capturas >= LPR_POLL_AMOSTRAS_MIN) {
+        double anterior = 0;
+        for (int i = 0; i < NUM_PERCENTIS_CONSULTA; i++) {
+            double instante = histograma_quantil(&t->processamento, percentis_consulta[i]) / 1000.0;
+            if (instante < anterior + LPR_POLL_MIN_MS) {
+                instante = anterior + LPR_POLL_MIN_MS;
+            }
+            instantes_ms[n++] = instante;
+            anterior = instante;
+        }
+    }
+    pthread_mutex_unlock(&mutex_tempos_lpr);
+    
+    return n;
+}
+
+/**
+ * @brief Registra uma captura observada no histórico da câmera
+ */
+static void lpr_registrar_processamento(uint8_t camera_addr, double processamento_ms, int consultas) {
+    pthread_mutex_lock(&mutex_tempos_lpr);
+    LPRTempos *t = tempos_da_camera(camera_addr, true);
+    if (t) {
+        histograma_registrar(&t->processamento, processamento_ms * 1000.0);
+        t->capturas++;
+        t->consultas += consultas;
+    }
+    pthread_mutex_unlock(&mutex_tempos_lpr);
+}
+
+/**
+ * @brief Copia o histograma de tempo de processamento de uma câmera
+ */
+bool lpr_obter_tempos(uint8_t camera_addr, LPRTempos *out) {
+    pthread_mutex_lock(&mutex_tempos_lpr);
+    LPRTempos *t = tempos_da_camera(camera_addr, false);
+    bool existe = t && t->capturas > 0;
+    if (existe) {
+        *out = *t;
+    }
+    pthread_mutex_unlock(&mutex_tempos_lpr);
+    return existe;
+}
+
+/**
+ * @brief Imprime o tempo de processamento e consultas por captura de cada câmera
+ */
+void lpr_imprimir_tempos() {
+    // Copia sob a trava: as threads das câmeras continuam registrando capturas
+    LPRTempos copia[LPR_MAX_CAMERAS];
+    uint8_t enderecos[LPR_MAX_CAMERAS];
+    pthread_mutex_lock(&mutex_tempos_lpr);
+    int n = num_tempos_lpr;
+    memcpy(copia, tempos_lpr, n * sizeof(LPRTempos));
+    memcpy(enderecos, tempos_lpr_enderecos, n * sizeof(uint8_t));
+    pthread_mutex_unlock(&mutex_tempos_lpr);
+    
+    for (int i = 0; i < n; i++) {
+        const LPRTempos *t = &copia[i];
+        if (t->capturas == 0) {
+            continue;
+        }
+        
+        char prefixo[32];
+        snprintf(prefixo, sizeof(prefixo), "[LPR 0x%02X]", enderecos[i]);
+        printf("%s capturas=%lu consultas/captura=%.2f mediana≈%.1f ms\n", prefixo, t->capturas,
+               (double)t->consultas / t->capturas, histograma_quantil(&t->processamento, 50) / 1000.0);
+        histograma_imprimir(prefixo, "processamento", &t->processamento);
+    }
+}
+
+/**
+ * @brief Aguarda processamento da placa (polling adaptativo no status)
+ * 
+ * O tempo registrado é o meio do intervalo entre a última consulta que viu
+ * PROCESSANDO e a que viu o resultado; assim a mediana aprendida não sobe
+ * sozinha por causa do atraso do próprio polling. As esperas entre consultas e
+ * o timeout seguem o relógio do nó (relogio.h); só o quadro de cada consulta
+ * corre no relógio real.
+ */
+LPRStatus lpr_wait_processing(int fd, uint8_t camera_addr, int timeout_ms, LPRData *data) {
+    double inicio_ms = relogio_agora_ms();
+    
+    double instantes_ms[NUM_PERCENTIS_CONSULTA];
+    int num_instantes = lpr_agenda_consultas(camera_addr, instantes_ms);
+    
+    // Sem histórico, a primeira consulta espera um intervalo inteiro: logo após o
+    // trigger a câmera ainda está processando (e com 0x17 o status já foi lido)
+    double proxima_ms = (num_instantes > 0) ? instantes_ms[0] : LPR_POLL_PADRAO_MS;
+    double intervalo_ms = (num_instantes > 0) ? LPR_POLL_MIN_MS : LPR_POLL_PADRAO_MS;
+    double ultima_negativa_ms = 0;
+    int consultas = 0;
     
     while (1) {
-        uint16_t status_reg;
+        // Dorme até o instante da próxima consulta
+        double decorrido_ms = relogio_agora_ms() - inicio_ms;
+        if (proxima_ms > decorrido_ms) {
+            double espera_ms = proxima_ms - decorrido_ms;
+            if (decorrido_ms + espera_ms > timeout_ms) {
+                espera_ms = timeout_ms - decorrido_ms;
+            }
+            if (espera_ms > 0) {
+                relogio_dormir_us((unsigned int)(espera_ms * 1000));
+            }
+        }
         
-        // Lê apenas o status (offset 0)
-        if (modbus_read_holding_registers(fd, camera_addr, 0, 1, &status_reg)) {
-            LPRStatus status = (LPRStatus)(status_reg & 0xFF);
+        uint16_t registers[LPR_NUM_REGS];
+        int num_regs = data ? LPR_NUM_REGS : 1;
+        consultas++;
+        
+        // Lê o status (offset 0) e, se pedido, a placa e a confiança junto
+        if (modbus_read_holding_registers(fd, camera_addr, 0, num_regs, registers)) {
+            LPRStatus status = (LPRStatus)(registers[0] & 0xFF);
+            if (data) {
+                lpr_decodificar(registers, data);
+            }
+            
+            decorrido_ms = relogio_agora_ms() - inicio_ms;
             
             if (status == LPR_STATUS_OK || status == LPR_STATUS_ERRO) {
+                lpr_registrar_processamento(camera_addr, (ultima_negativa_ms + decorrido_ms) / 2, consultas);
                 return status;
             }
+            ultima_negativa_ms = decorrido_ms;
+        }
+        
+        // Câmera caiu durante o processamento: não adianta continuar consultando
+        if (!modbus_escravo_disponivel(camera_addr)) {
+            return LPR_STATUS_ERRO;
         }
         
         // Verifica timeout
-        gettimeofday(&now, NULL);
-        long elapsed_ms = (now.tv_sec - start.tv_sec) * 1000 + 
-                         (now.tv_usec - start.tv_usec) / 1000;
+        decorrido_ms = relogio_agora_ms() - inicio_ms;
         
-        if (elapsed_ms >= timeout_ms) {
+        if (decorrido_ms >= timeout_ms) {
             fprintf(stderr, "[LPR 0x%02X] Timeout aguardando processamento\n", camera_addr);
             return LPR_STATUS_ERRO;
         }
         
-        usleep(100000); // Aguarda 100ms entre tentativas (conforme especificação)
+        // Próxima consulta: próximo percentil do histórico, depois recuo exponencial
+        if (consultas < num_instantes) {
+            proxima_ms = instantes_ms[consultas];
+        } else {
+            if (num_instantes > 0) {
+                intervalo_ms *= 2;
+                if (intervalo_ms > LPR_POLL_MAX_MS) {
+                    intervalo_ms = LPR_POLL_MAX_MS;
+                }
+            }
+            proxima_ms = decorrido_ms + intervalo_ms;
+        }
     }
 }
 
@@ -411,11 +1142,9 @@ bool lpr_reset_trigger(int fd, uint8_t camera_addr) {
 // ========== Funções específicas para Placar (0x20) ==========
 
 /**
- * @brief Atualiza os dados no placar MODBUS
+ * @brief Converte a estrutura do placar na imagem dos 13 registros
  */
-bool placar_update(int fd, PlacarData *data) {
-    uint16_t registers[13];
-    
+void placar_para_registros(const PlacarData *data, uint16_t *registers) {
     registers[0] = data->vagas_livres_terreo_pne;
     registers[1] = data->vagas_livres_terreo_idoso;
     registers[2] = data->vagas_livres_terreo_comuns;
@@ -429,8 +1158,17 @@ bool placar_update(int fd, PlacarData *data) {
     registers[10] = data->num_carros_a1;
     registers[11] = data->num_carros_a2;
     registers[12] = data->flags;
+}
+
+/**
+ * @brief Atualiza os dados no placar MODBUS
+ */
+bool placar_update(int fd, PlacarData *data) {
+    uint16_t registers[PLACAR_NUM_REGS];
+    
+    placar_para_registros(data, registers);
     
-    bool success = modbus_write_multiple_registers(fd, MODBUS_ADDR_PLACAR, 0, 13, registers);
+    bool success = modbus_write_multiple_registers(fd, MODBUS_ADDR_PLACAR, 0, PLACAR_NUM_REGS, registers);
     
     if (success) {
         printf("[PLACAR] Dados atualizados (Flags: 0x%04X)\n", data->flags);
@@ -441,6 +1179,66 @@ bool placar_update(int fd, PlacarData *data) {
     return success;
 }
 
+/**
+ * @brief Atualiza o placar escrevendo só os trechos que mudaram
+ * 
+ * Compara a imagem nova com o espelho do que já está no placar. Trechos
+ * alterados separados por até PLACAR_GAP_MAXIMO registros iguais viram uma
+ * única escrita (reescrever alguns registros custa menos que outro quadro).
+ */
+bool placar_update_delta(int fd, PlacarEspelho *espelho, PlacarData *data, bool completo) {
+    uint16_t registers[PLACAR_NUM_REGS];
+    placar_para_registros(data, registers);
+    
+    // Sem espelho confiável (início ou falha anterior): ressincroniza tudo
+    if (completo || !espelho->valido) {
+        bool success = placar_update(fd, data);
+        if (success) {
+            memcpy(espelho->regs, registers, sizeof(registers));
+            espelho->valido = true;
+            espelho->escritas_completas++;
+        }
+        return success;
+    }
+    
+    int i = 0;
+    int escritos = 0;
+    while (i < PLACAR_NUM_REGS) {
+        if (registers[i] == espelho->regs[i]) {
+            i++;
+            continue;
+        }
+        
+        // Estende o trecho enquanto houver mudanças próximas
+        int inicio = i;
+        int fim = i;
+        for (int j = i + 1; j < PLACAR_NUM_REGS && j - fim <= PLACAR_GAP_MAXIMO + 1; j++) {
+            if (registers[j] != espelho->regs[j]) {
+                fim = j;
+            }
+        }
+        
+        int quantidade = fim - inicio + 1;
+        if (!modbus_write_multiple_registers(fd, MODBUS_ADDR_PLACAR, inicio, quantidade, &registers[inicio])) {
+            // Não sabemos o que o placar tem agora: força escrita completa na próxima
+            espelho->valido = false;
+            fprintf(stderr, "[PLACAR] Erro ao atualizar registros %d-%d\n", inicio, fim);
+            return false;
+        }
+        
+        memcpy(&espelho->regs[inicio], &registers[inicio], quantidade * sizeof(uint16_t));
+        espelho->escritas_parciais++;
+        escritos += quantidade;
+        i = fim + 1;
+    }
+    
+    if (escritos > 0) {
+        printf("[PLACAR] %d registro(s) atualizados (Flags: 0x%04X)\n", escritos, data->flags);
+    }
+    
+    return true;
+}
+
 /**
  * @brief Lê os dados do placar MODBUS
  */
@@ -0,0 +1,226 @@
+#include "../inc/passagem.h"
+#include "../inc/relogio.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Prepara o detector com os níveis atuais dos sensores
+ */
+void passagem_init(DetectorPassagem *d, const RampaConfig *rampa, double distancia_m, unsigned int timeout_ms) {
+    memset(d, 0, sizeof(*d));
+    d->rampa = rampa;
+    d->pinos[0] = rampa->sensor1;
+    d->pinos[1] = rampa->sensor2;
+    d->distancia_m = distancia_m;
+    d->timeout_ms = timeout_ms;
+    d->niveis[0] = hal_gpio_lev(rampa->sensor1);
+    d->niveis[1] = hal_gpio_lev(rampa->sensor2);
+}
+
+/**
+ * @brief Retira a travessia i da fila, mantendo a ordem de chegada
+ */
+static void remover(DetectorPassagem *d, int i) {
+    memmove(&d->em_curso[i], &d->em_curso[i + 1], (d->num_em_curso - i - 1) * sizeof(d->em_curso[0]));
+    d->num_em_curso--;
+}
+
+/**
+ * @brief Fecha a travessia i como passagem e a retira da fila
+ * @param fim_ns Traseira deixou o destino (0 = sensor preso, sem tempo de travessia)
+ */
+static void concluir(DetectorPassagem *d, int i, uint64_t fim_ns, Passagem *out) {
+    const TravessiaEmCurso *t = &d->em_curso[i];
+    out->direcao = (t->origem == 0) ? PASSAGEM_SOBE : PASSAGEM_DESCE;
+    out->entre_sensores_ms = (t->chegada_ns - t->inicio_ns) / 1e6;
+    out->travessia_ms = fim_ns ? (fim_ns - t->inicio_ns) / 1e6 : 0;
+    out->velocidade_kmh = (out->entre_sensores_ms > 0) ?
+                          d->distancia_m / (out->entre_sensores_ms / 1000.0) * 3.6 : 0;
+    out->andar_origem = (t->origem == 0) ? d->rampa->andar_baixo : d->rampa->andar_cima;
+    out->andar_destino = (t->origem == 0) ? d->rampa->andar_cima : d->rampa->andar_baixo;
+    if (out->direcao == PASSAGEM_SOBE) {
+        d->subidas++;
+    } else {
+        d->descidas++;
+    }
+    remover(d, i);
+}
+
+/**
+ * @brief Processa uma borda de um dos sensores
+ */
+ResultadoPassagem passagem_borda(DetectorPassagem *d, const HalGpioEvento *e, Passagem *out) {
+    int s = (e->pino == d->pinos[0]) ? 0 : (e->pino == d->pinos[1]) ? 1 : -1;
+    if (s < 0 || e->nivel == d->niveis[s]) {
+        return PASSAGEM_NADA;               // Outro pino ou borda repetida
+    }
+    d->niveis[s] = e->nivel;
+
+    if (e->nivel == HIGH) {
+        // Frente de um carro: chega ao destino da travessia mais antiga do outro lado...
+        for (int i = 0; i < d->num_em_curso; i++) {
+            TravessiaEmCurso *t = &d->em_curso[i];
+            if (t->origem != s && !t->chegou) {
+                t->chegou = true;
+                t->chegada_ns = e->instante_ns;
+                return PASSAGEM_NADA;
+            }
+        }
+
+        // ...ou é um carro novo entrando na rampa
+        if (d->num_em_curso == PASSAGEM_MAX_EM_CURSO) {
+            printf("[PASSAGEM] %s: fila cheia, travessia mais antiga descartada\n", d->rampa->nome);
+            d->descartadas++;
+            remover(d, 0);
+        }
+        TravessiaEmCurso *t = &d->em_curso[d->num_em_curso++];
+        *t = (TravessiaEmCurso){ s, false, false, e->instante_ns, 0, relogio_agora_ms() };
+        return PASSAGEM_INICIO;
+    }
+
+    // Traseira de um carro deixando o sensor s
+    for (int i = 0; i < d->num_em_curso; i++) {
+        TravessiaEmCurso *t = &d->em_curso[i];
+        if (t->origem != s && t->chegou) {
+            if (t->saiu_origem) {
+                concluir(d, i, e->instante_ns, out);
+                return PASSAGEM_CONCLUIDA;
+            }
+            t->chegou = false;              // Recuou do destino
+            return PASSAGEM_NADA;
+        }
+    }
+    for (int i = 0; i < d->num_em_curso; i++) {
+        TravessiaEmCurso *t = &d->em_curso[i];
+        if (t->origem == s && !t->saiu_origem) {
+            t->saiu_origem = true;
+            return PASSAGEM_NADA;
+        }
+    }
+    return PASSAGEM_NADA;
+}
+
+/**
+ * @brief Encerra a travessia mais antiga vencida
+ */
+bool passagem_expirar(DetectorPassagem *d, double agora_ms, Passagem *out) {
+    for (int i = 0; i < d->num_em_curso; i++) {
+        TravessiaEmCurso *t = &d->em_curso[i];
+        if (agora_ms - t->aberta_ms < d->timeout_ms) {
+            continue;
+        }
+        if (t->chegou) {
+            printf("[PASSAGEM] %s: sensor %d acionado há mais de %u s\n",
+                   d->rampa->nome, (t->origem == 0) ? 2 : 1, d->timeout_ms / 1000);
+            concluir(d, i, 0, out);
+            return true;
+        }
+        printf("[PASSAGEM] %s: travessia abortada (carro voltou pelo sensor %d)\n",
+               d->rampa->nome, t->origem + 1);
+        d->abortadas++;
+        remover(d, i);
+        i--;
+    }
+    return false;
+}
+
+/**
+ * @brief Bordas a partir de uma leitura (backend sem eventos)
+ */
+int passagem_bordas_da_leitura(const DetectorPassagem *d, uint32_t niveis, HalGpioEvento bordas[2]) {
+    uint64_t agora_ns = (uint64_t)(relogio_agora_ms() * 1000000.0);
+    int n = 0;
+    for (int s = 0; s < 2; s++) {
+        uint8_t nivel = HAL_GPIO_NIVEL(niveis, d->pinos[s]);
+        if (nivel != d->niveis[s]) {
+            bordas[n++] = (HalGpioEvento){ d->pinos[s], nivel, agora_ns };
+        }
+    }
+    return n;
+}
+
+/**
+ * @brief Timeout das travessias: PASSAGEM_TIMEOUT (s) do ambiente, ou PASSAGEM_TIMEOUT_S
+ */
+static unsigned int timeout_do_ambiente() {
+    const char *texto = getenv("PASSAGEM_TIMEOUT");
+    if (texto && texto[0]) {
+        if (atoi(texto) > 0) {
+            return (unsigned int)atoi(texto) * 1000;
+        }
+        printf("[PASSAGEM] PASSAGEM_TIMEOUT inválido '%s', usando %d s\n", texto, PASSAGEM_TIMEOUT_S);
+    }
+    return PASSAGEM_TIMEOUT_S * 1000;
+}
+
+/**
+ * @brief Vigia as rampas do nó numa só thread
+ */
+void passagem_monitorar(const RampaConfig *rampas, int num_rampas, PassagemCallback callback) {
+    if (num_rampas > PASSAGEM_MAX_RAMPAS) {
+        printf("[PASSAGEM] %d rampas configuradas, vigiando só as %d primeiras\n",
+               num_rampas, PASSAGEM_MAX_RAMPAS);
+        num_rampas = PASSAGEM_MAX_RAMPAS;
+    }
+
+    unsigned int timeout_ms = timeout_do_ambiente();
+    DetectorPassagem detectores[PASSAGEM_MAX_RAMPAS];
+    uint8_t pinos[2 * PASSAGEM_MAX_RAMPAS];
+    for (int i = 0; i < num_rampas; i++) {
+        passagem_init(&detectores[i], &rampas[i], PASSAGEM_DISTANCIA_M, timeout_ms);
+        pinos[2 * i] = rampas[i].sensor1;
+        pinos[2 * i + 1] = rampas[i].sensor2;
+        printf("[PASSAGEM] %s: sensores %d e %d, %s ↔ %s\n", rampas[i].nome, rampas[i].sensor1,
+               rampas[i].sensor2, passagem_nome_andar(rampas[i].andar_baixo),
+               passagem_nome_andar(rampas[i].andar_cima));
+    }
+    HalGpioEventos *eventos = hal_gpio_eventos_abrir(pinos, 2 * num_rampas, HAL_BORDA_AMBAS);
+
+    while (1) {
+        // Dorme até a próxima borda de qualquer rampa (o kernel enfileira as bordas);
+        // sem eventos, as bordas saem da comparação de duas leituras
+        HalGpioEvento bordas[2 * PASSAGEM_MAX_RAMPAS];
+        int num_bordas = hal_gpio_eventos_esperar(eventos, &bordas[0], PASSAGEM_ESPERA_MS);
+        if (num_bordas < 0) {
+            // Assinatura quebrada: repetir a espera giraria sem dormir
+            printf("[PASSAGEM] Erro na espera por bordas, voltando à leitura periódica\n");
+            hal_gpio_eventos_fechar(eventos);
+            eventos = NULL;
+            num_bordas = 0;
+        }
+        if (num_bordas == 0 && eventos == NULL) {
+            uint32_t niveis = hal_gpio_lev_todos();
+            for (int i = 0; i < num_rampas; i++) {
+                num_bordas += passagem_bordas_da_leitura(&detectores[i], niveis, &bordas[num_bordas]);
+            }
+        }
+
+        for (int b = 0; b < num_bordas; b++) {
+            for (int i = 0; i < num_rampas; i++) {
+                Passagem passagem;
+                ResultadoPassagem r = passagem_borda(&detectores[i], &bordas[b], &passagem);
+                if (r != PASSAGEM_NADA) {
+                    callback(&rampas[i], r, (r == PASSAGEM_CONCLUIDA) ? &passagem : NULL);
+                    break;
+                }
+            }
+        }
+
+        double agora = relogio_agora_ms();
+        for (int i = 0; i < num_rampas; i++) {
+            Passagem passagem;
+            while (passagem_expirar(&detectores[i], agora, &passagem)) {
+                callback(&rampas[i], PASSAGEM_CONCLUIDA, &passagem);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Nome de um andar para o log
+ */
+const char *passagem_nome_andar(int andar) {
+    static const char *nomes[PASSAGEM_NUM_ANDARES] = { "Térreo", "1º Andar", "2º Andar" };
+    return (andar >= 0 && andar < PASSAGEM_NUM_ANDARES) ? nomes[andar] : "?";
+}
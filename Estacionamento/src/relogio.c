@@ -0,0 +1,431 @@
+#include "../inc/relogio.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+
+static pthread_once_t relogio_iniciado = PTHREAD_ONCE_INIT;
+static RelogioModo modo_atual = RELOGIO_REAL;
+static double fator_atual = 1.0;
+static double inicio_parede_ms;         // Hora de parede (ms desde a época) no instante 0
+static double ancora_ms;                // Relógio real no instante 0 (base do modo acelerado)
+static struct timespec ancora_monotonica;
+
+// ========== Modo virtual ==========
+// Cada thread que dorme no relógio vira participante. Quando todas as
+// participantes estão dormindo, ninguém mais pode gerar eventos no instante
+// atual e o relógio salta para o menor prazo pendente.
+
+typedef struct {
+    bool usado;
+    bool acordado;
+    double prazo_ms;
+    const void *chave;                  // Condição que interrompe a espera (relogio_sinalizar)
+} RelogioDorminhoco;
+
+static pthread_mutex_t mutex_virtual = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cond_virtual = PTHREAD_COND_INITIALIZER;
+static double virtual_ms = 0;
+static int participantes = 0;
+static int dormindo = 0;
+static unsigned long mudancas = 0;      // Conta saltos, sonos e saídas (detecta relógio parado)
+static RelogioDorminhoco dorminhocos[RELOGIO_VIRTUAL_MAX_THREADS];
+static pthread_key_t chave_participante;    // Marca as participantes; o destrutor as remove ao sair
+
+/**
+ * @brief Milissegundos de um relógio do sistema
+ */
+static double ler_ms(clockid_t relogio) {
+    struct timespec t;
+    clock_gettime(relogio, &t);
+    return t.tv_sec * 1000.0 + t.tv_nsec / 1000000.0;
+}
+
+/**
+ * @brief Converte "AAAA-MM-DD HH:MM:SS" (hora local) em segundos desde a época
+ * @return 0 se o texto for inválido
+ */
+static time_t ler_data(const char *texto) {
+    struct tm tm;
+    memset(&tm, 0, sizeof(tm));
+    if (sscanf(texto, "%d-%d-%d %d:%d:%d", &tm.tm_year, &tm.tm_mon, &tm.tm_mday,
+               &tm.tm_hour, &tm.tm_min, &tm.tm_sec) != 6) {
+        return 0;
+    }
+    tm.tm_year -= 1900;
+    tm.tm_mon -= 1;
+    tm.tm_isdst = -1;
+    time_t t = mktime(&tm);
+    return (t == (time_t)-1) ? 0 : t;
+}
+
+/**
+ * @brief Ajusta o relógio para um modo (chamada com a configuração final)
+ */
+static void aplicar(RelogioModo modo, double fator, time_t inicio, double ancora) {
+    modo_atual = modo;
+    fator_atual = (modo == RELOGIO_ACELERADO) ? fator : 1.0;
+    ancora_ms = (ancora > 0) ? ancora : ler_ms(CLOCK_REALTIME);
+    inicio_parede_ms = (inicio > 0) ? inicio * 1000.0 : ancora_ms;
+    clock_gettime(CLOCK_MONOTONIC, &ancora_monotonica);
+
+    pthread_mutex_lock(&mutex_virtual);
+    virtual_ms = 0;
+    pthread_mutex_unlock(&mutex_virtual);
+
+    if (modo != RELOGIO_REAL) {
+        time_t t = (time_t)(inicio_parede_ms / 1000.0);
+        struct tm *tm_info = localtime(&t);
+        char data[32];
+        strftime(data, sizeof(data), "%Y-%m-%d %H:%M:%S", tm_info);
+        if (modo == RELOGIO_ACELERADO) {
+            printf("[RELOGIO] Modo acelerado (%.0fx), início %s\n", fator_atual, data);
+        } else {
+            printf("[RELOGIO] Modo virtual, início %s\n", data);
+        }
+    }
+}
+
+/**
+ * @brief Lê RELOGIO, RELOGIO_FATOR, RELOGIO_INICIO e RELOGIO_ANCORA
+ */
+static void ler_ambiente() {
+    RelogioModo modo = RELOGIO_REAL;
+    const char *nome = getenv("RELOGIO");
+    if (nome && strcmp(nome, "acelerado") == 0) {
+        modo = RELOGIO_ACELERADO;
+    } else if (nome && strcmp(nome, "virtual") == 0) {
+        modo = RELOGIO_VIRTUAL;
+    } else if (nome && strcmp(nome, "real") != 0) {
+        printf("[RELOGIO] Modo desconhecido '%s', usando o relógio real\n", nome);
+    }
+
+    double fator = RELOGIO_FATOR_PADRAO;
+    const char *texto = getenv("RELOGIO_FATOR");
+    if (texto && atof(texto) > 0) {
+        fator = atof(texto);
+    }
+
+    time_t inicio = 0;
+    texto = getenv("RELOGIO_INICIO");
+    if (texto && (inicio = ler_data(texto)) == 0) {
+        printf("[RELOGIO] RELOGIO_INICIO inválido '%s' (use AAAA-MM-DD HH:MM:SS)\n", texto);
+    }
+
+    // Instante real (segundos desde a época) que corresponde a RELOGIO_INICIO:
+    // com o mesmo valor em todos os processos, central e nós concordam na hora
+    double ancora = 0;
+    texto = getenv("RELOGIO_ANCORA");
+    if (texto) {
+        ancora = atof(texto) * 1000.0;
+    }
+
+    aplicar(modo, fator, inicio, ancora);
+}
+
+/**
+ * @brief Thread participante terminou: não segura mais o relógio virtual
+ */
+static void sair_participante(void *marca) {
+    (void)marca;
+    pthread_mutex_lock(&mutex_virtual);
+    participantes--;
+    mudancas++;
+    if (dormindo >= participantes) {
+        pthread_cond_broadcast(&cond_virtual);
+    }
+    pthread_mutex_unlock(&mutex_virtual);
+}
+
+static void iniciar() {
+    pthread_key_create(&chave_participante, sair_participante);
+    ler_ambiente();
+}
+
+static void garantir_iniciado() {
+    pthread_once(&relogio_iniciado, iniciar);
+}
+
+/**
+ * @brief Escolhe o modo do relógio
+ */
+void relogio_configurar(RelogioModo modo, double fator, time_t inicio) {
+    garantir_iniciado();
+    aplicar(modo, (fator > 0) ? fator : RELOGIO_FATOR_PADRAO, inicio, 0);
+}
+
+/**
+ * @brief Modo em uso
+ */
+RelogioModo relogio_modo() {
+    garantir_iniciado();
+    return modo_atual;
+}
+
+/**
+ * @brief Acorda as threads cujo prazo venceu
+ * @note Deve ser chamada com mutex_virtual travado
+ */
+static void avancar_para(double alvo_ms) {
+    if (alvo_ms > virtual_ms) {
+        virtual_ms = alvo_ms;
+    }
+    mudancas++;
+    for (int i = 0; i < RELOGIO_VIRTUAL_MAX_THREADS; i++) {
+        if (dorminhocos[i].usado && !dorminhocos[i].acordado && dorminhocos[i].prazo_ms <= virtual_ms) {
+            dorminhocos[i].acordado = true;
+            dormindo--;
+        }
+    }
+    pthread_cond_broadcast(&cond_virtual);
+}
+
+/**
+ * @brief Menor prazo entre as threads dormindo
+ * @note Deve ser chamada com mutex_virtual travado
+ */
+static double menor_prazo() {
+    double menor = -1;
+    for (int i = 0; i < RELOGIO_VIRTUAL_MAX_THREADS; i++) {
+        if (dorminhocos[i].usado && !dorminhocos[i].acordado &&
+            (menor < 0 || dorminhocos[i].prazo_ms < menor)) {
+            menor = dorminhocos[i].prazo_ms;
+        }
+    }
+    return (menor < 0) ? virtual_ms : menor;
+}
+
+/**
+ * @brief Torna a thread participante do relógio virtual antes da primeira espera
+ */
+void relogio_participar_thread() {
+    garantir_iniciado();
+    if (modo_atual != RELOGIO_VIRTUAL) {
+        return;
+    }
+    pthread_mutex_lock(&mutex_virtual);
+    if (pthread_getspecific(chave_participante) == NULL) {
+        pthread_setspecific(chave_participante, &participantes);
+        participantes++;
+        mudancas++;
+    }
+    pthread_mutex_unlock(&mutex_virtual);
+}
+
+/**
+ * @brief Tira a thread das participantes do relógio virtual
+ */
+void relogio_liberar_thread() {
+    garantir_iniciado();
+    if (pthread_getspecific(chave_participante) != NULL) {
+        pthread_setspecific(chave_participante, NULL);
+        sair_participante(NULL);
+    }
+}
+
+/**
+ * @brief Encerra o processo: o relógio virtual não pode mais avançar sem
+ *        depender do tempo real
+ * @note Deve ser chamada com mutex_virtual travado
+ */
+static void relogio_travado(const char *motivo) {
+    fprintf(stderr, "[RELOGIO] Relógio virtual parado em %.3f ms: %s (%d de %d participantes dormindo)\n",
+            virtual_ms, motivo, dormindo, participantes);
+    fprintf(stderr, "[RELOGIO] Toda thread que bloqueia fora do relógio (socket, teclado, "
+            "pthread_join, fila sem relogio_esperar_cond) deve chamar relogio_liberar_thread antes\n");
+    abort();
+}
+
+/**
+ * @brief Dorme no relógio virtual até o prazo ou até relogio_sinalizar(chave)
+ * @param externo Mutex do chamador, solto só depois de a thread estar registrada
+ *                (o sinal não se perde); travado de novo na volta
+ */
+static void dormir_virtual(double ms, const void *chave, pthread_mutex_t *externo) {
+    pthread_mutex_lock(&mutex_virtual);
+    if (externo) {
+        pthread_mutex_unlock(externo);
+    }
+    if (pthread_getspecific(chave_participante) == NULL) {
+        pthread_setspecific(chave_participante, &participantes);
+        participantes++;
+    }
+
+    int slot = -1;
+    for (int i = 0; i < RELOGIO_VIRTUAL_MAX_THREADS; i++) {
+        if (!dorminhocos[i].usado) {
+            slot = i;
+            break;
+        }
+    }
+    if (slot < 0) {
+        relogio_travado("mais threads dormindo que RELOGIO_VIRTUAL_MAX_THREADS");
+    }
+
+    RelogioDorminhoco *d = &dorminhocos[slot];
+    d->usado = true;
+    d->acordado = false;
+    d->prazo_ms = virtual_ms + ms;
+    d->chave = chave;
+    dormindo++;
+    mudancas++;
+
+    while (!d->acordado) {
+        if (d->prazo_ms <= virtual_ms || dormindo >= participantes) {
+            avancar_para(menor_prazo());
+            continue;
+        }
+
+        // Alguma participante está acordada: espera ela dormir, sem prazo no
+        // relógio real (senão o tempo simulado dependeria da carga da máquina).
+        // O limite real só acusa uma participante que bloqueou fora do relógio
+        unsigned long antes = mudancas;
+        struct timespec limite;
+        clock_gettime(CLOCK_REALTIME, &limite);
+        limite.tv_sec += RELOGIO_VIRTUAL_TRAVADO_S;
+        int rc = pthread_cond_timedwait(&cond_virtual, &mutex_virtual, &limite);
+        if (rc == ETIMEDOUT && !d->acordado && mudancas == antes) {
+            relogio_travado("participante acordada sem voltar ao relógio");
+        }
+    }
+
+    d->usado = false;
+    pthread_mutex_unlock(&mutex_virtual);
+    if (externo) {
+        pthread_mutex_lock(externo);
+    }
+}
+
+/**
+ * @brief Milissegundos desde o início do relógio
+ */
+double relogio_agora_ms() {
+    garantir_iniciado();
+    if (modo_atual == RELOGIO_VIRTUAL) {
+        pthread_mutex_lock(&mutex_virtual);
+        double t = virtual_ms;
+        pthread_mutex_unlock(&mutex_virtual);
+        return t;
+    }
+    if (modo_atual == RELOGIO_ACELERADO) {
+        return (ler_ms(CLOCK_REALTIME) - ancora_ms) * fator_atual;
+    }
+    struct timespec agora;
+    clock_gettime(CLOCK_MONOTONIC, &agora);
+    return (agora.tv_sec - ancora_monotonica.tv_sec) * 1000.0 +
+           (agora.tv_nsec - ancora_monotonica.tv_nsec) / 1000000.0;
+}
+
+/**
+ * @brief Hora de parede, como gettimeofday
+ */
+void relogio_gettimeofday(struct timeval *tv) {
+    garantir_iniciado();
+    if (modo_atual == RELOGIO_REAL) {
+        gettimeofday(tv, NULL);
+        return;
+    }
+    double ms = inicio_parede_ms + relogio_agora_ms();
+    tv->tv_sec = (time_t)(ms / 1000.0);
+    tv->tv_usec = (suseconds_t)((ms - tv->tv_sec * 1000.0) * 1000.0);
+}
+
+/**
+ * @brief Hora de parede em segundos, como time(NULL)
+ */
+time_t relogio_time() {
+    struct timeval tv;
+    relogio_gettimeofday(&tv);
+    return tv.tv_sec;
+}
+
+/**
+ * @brief Dorme uma fração de milissegundos do relógio
+ */
+static void dormir(double ms) {
+    garantir_iniciado();
+    if (modo_atual == RELOGIO_VIRTUAL) {
+        dormir_virtual(ms, NULL, NULL);
+        return;
+    }
+
+    double real_ms = ms / fator_atual;
+    struct timespec espera;
+    espera.tv_sec = (time_t)(real_ms / 1000.0);
+    espera.tv_nsec = (long)((real_ms - espera.tv_sec * 1000.0) * 1000000.0);
+    while (nanosleep(&espera, &espera) != 0 && errno == EINTR) {
+    }
+}
+
+/**
+ * @brief Dorme o tempo dado em milissegundos do relógio
+ */
+void relogio_dormir_ms(unsigned int ms) {
+    dormir(ms);
+}
+
+/**
+ * @brief Dorme o tempo dado em microssegundos do relógio
+ */
+void relogio_dormir_us(unsigned int us) {
+    dormir(us / 1000.0);
+}
+
+/**
+ * @brief Avança o relógio virtual e acorda as threads cujo prazo venceu
+ */
+void relogio_avancar_ms(double ms) {
+    garantir_iniciado();
+    if (modo_atual != RELOGIO_VIRTUAL) {
+        return;
+    }
+    pthread_mutex_lock(&mutex_virtual);
+    avancar_para(virtual_ms + ms);
+    pthread_mutex_unlock(&mutex_virtual);
+}
+
+/**
+ * @brief Espera um sinal na condição por até ms do relógio
+ */
+void relogio_esperar_cond(pthread_cond_t *cond, pthread_mutex_t *mutex, unsigned int ms) {
+    garantir_iniciado();
+    if (modo_atual == RELOGIO_VIRTUAL) {
+        dormir_virtual(ms, cond, mutex);
+        return;
+    }
+
+    double real_ms = ms / fator_atual;
+    struct timespec limite;
+    clock_gettime(CLOCK_REALTIME, &limite);
+    long long ns = limite.tv_nsec + (long long)(real_ms * 1000000.0);
+    limite.tv_sec += ns / 1000000000LL;
+    limite.tv_nsec = ns % 1000000000LL;
+    pthread_cond_timedwait(cond, mutex, &limite);
+}
+
+/**
+ * @brief Acorda as threads em relogio_esperar_cond nesta condição
+ */
+void relogio_sinalizar(pthread_cond_t *cond) {
+    garantir_iniciado();
+    pthread_cond_broadcast(cond);
+    if (modo_atual != RELOGIO_VIRTUAL) {
+        return;
+    }
+
+    pthread_mutex_lock(&mutex_virtual);
+    bool acordou = false;
+    for (int i = 0; i < RELOGIO_VIRTUAL_MAX_THREADS; i++) {
+        if (dorminhocos[i].usado && !dorminhocos[i].acordado && dorminhocos[i].chave == cond) {
+            dorminhocos[i].acordado = true;
+            dormindo--;
+            mudancas++;
+            acordou = true;
+        }
+    }
+    if (acordou) {
+        pthread_cond_broadcast(&cond_virtual);
+    }
+    pthread_mutex_unlock(&mutex_virtual);
+}
@@ -3,22 +3,26 @@
 #include <string.h>
 #include <sys/socket.h>
 #include <arpa/inet.h>
+#include <netinet/tcp.h>
 #include <unistd.h>
-#include <bcm2835.h>
+#include "../inc/hal_gpio.h"
+#include "../inc/relogio.h"
 #include <pthread.h>
 #include <stdbool.h>
 #include <termios.h>
 #include <fcntl.h>
 #include <ctype.h>
 #include "../inc/modbus.h"
+#include "../inc/passagem.h"
 
 #define tamVetorReceber 23
 #define tamVetorEnviar 5
+#define tamVetorReceberAndar (tamVetorReceber + PASSAGEM_NUM_CONTADORES)   // + passagens por par de andares
 #define MAX_CARROS 20  // Capacidade máxima do estacionamento
 
 int terreo[tamVetorReceber];
-int andar1[tamVetorReceber];
-int andar2[tamVetorReceber];
+int andar1[tamVetorReceberAndar];
+int andar2[tamVetorReceberAndar];
 int enviar[tamVetorEnviar];
 int r = 0;
 int manual =  0;
@@ -94,7 +98,7 @@ void limparBuffer(void) {
 void registrarEvento(const char *evento) {
     FILE *log = fopen("estacionamento_log.txt", "a");
     if(log) {
-        time_t t = time(NULL);
+        time_t t = relogio_time();
         struct tm *tm_info = localtime(&t);
         char buffer[64];
         strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", tm_info);
@@ -103,6 +107,30 @@ void registrarEvento(const char *evento) {
     }
 }
 
+/**
+ * @brief Registra as passagens novas de um nó de andar
+ * @param contadores Passagens acumuladas por par de andares (PASSAGEM_INDICE)
+ * @param registradas Passagens já registradas, atualizadas aqui
+ */
+void registrarPassagens(const int *contadores, int *registradas) {
+    for(int origem = 0; origem < PASSAGEM_NUM_ANDARES; origem++){
+        for(int destino = 0; destino < PASSAGEM_NUM_ANDARES; destino++){
+            int k = PASSAGEM_INDICE(origem, destino);
+            if(contadores[k] < registradas[k]){
+                registradas[k] = 0;     // Nó reiniciado: contadores recomeçaram
+            }
+            for(; registradas[k] < contadores[k]; registradas[k]++){
+                char mensagem[200];
+                sprintf(mensagem, "🚗%s Veículo %s: %s → %s", (destino > origem) ? "↑" : "↓",
+                        (destino > origem) ? "SUBINDO" : "DESCENDO",
+                        passagem_nome_andar(origem), passagem_nome_andar(destino));
+                registrarEvento(mensagem);
+                printf("%s\n", mensagem);
+            }
+        }
+    }
+}
+
 /**
  * @brief Inicializa o sistema de rastreamento de carros
  */
@@ -154,7 +182,7 @@ bool adicionarCarro(int numeroCarro, int andar, int vaga) {
             carros[i].confianca = -1;
             carros[i].andar = andar;
             carros[i].vaga = vaga;
-            carros[i].timestamp = time(NULL);
+            carros[i].timestamp = relogio_time();
             carros[i].ativo = true;
             carros[i].ticket_temporario = false;
             carros[i].reconciliado = false;
@@ -171,7 +199,7 @@ bool adicionarCarro(int numeroCarro, int andar, int vaga) {
             // Log para arquivo
             FILE *log = fopen("estacionamento_log.txt", "a");
             if(log) {
-                time_t t = time(NULL);
+                time_t t = relogio_time();
                 struct tm *tm_info = localtime(&t);
                 char buffer[64];
                 strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", tm_info);
@@ -190,7 +218,7 @@ bool adicionarCarro(int numeroCarro, int andar, int vaga) {
     // Log do erro
     FILE *log = fopen("estacionamento_log.txt", "a");
     if(log) {
-        time_t t = time(NULL);
+        time_t t = relogio_time();
         struct tm *tm_info = localtime(&t);
         char buffer[64];
         strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", tm_info);
@@ -238,7 +266,7 @@ bool adicionarCarroComPlaca(int numeroCarro, const char *placa, int confianca, i
             carros[i].confianca = confianca;
             carros[i].andar = andar;
             carros[i].vaga = vaga;
-            carros[i].timestamp = time(NULL);
+            carros[i].timestamp = relogio_time();
             carros[i].ativo = true;
             pthread_mutex_unlock(&mutex_carros);
             
@@ -258,7 +286,7 @@ bool adicionarCarroComPlaca(int numeroCarro, const char *placa, int confianca, i
             // Log para arquivo
             FILE *log = fopen("estacionamento_log.txt", "a");
             if(log) {
-                time_t t = time(NULL);
+                time_t t = relogio_time();
                 struct tm *tm_info = localtime(&t);
                 char buffer[64];
                 strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", tm_info);
@@ -306,7 +334,7 @@ bool removerCarro(int numeroCarro) {
         int i = indice_mais_recente;
         
         // Calcula tempo e valor para o log
-        time_t agora = time(NULL);
+        time_t agora = relogio_time();
         int segundos = (int)difftime(agora, carros[i].timestamp);
         int minutos = (segundos + 59) / 60;
         if(minutos < 1) minutos = 1;
@@ -323,7 +351,7 @@ bool removerCarro(int numeroCarro) {
         // Log para arquivo
         FILE *log = fopen("estacionamento_log.txt", "a");
         if(log) {
-            time_t t = time(NULL);
+            time_t t = relogio_time();
             struct tm *tm_info = localtime(&t);
             char buffer[64];
             strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", tm_info);
@@ -355,7 +383,7 @@ bool removerCarro(int numeroCarro) {
     // Log do alerta para arquivo
     FILE *log = fopen("estacionamento_log.txt", "a");
     if(log) {
-        time_t t = time(NULL);
+        time_t t = relogio_time();
         struct tm *tm_info = localtime(&t);
         char buffer[64];
         strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", tm_info);
@@ -457,7 +485,7 @@ bool reconciliarTicket(int numeroCarro, const char *placaReal) {
             // Log para arquivo
             FILE *log = fopen("estacionamento_log.txt", "a");
             if(log) {
-                time_t t = time(NULL);
+                time_t t = relogio_time();
                 struct tm *tm_info = localtime(&t);
                 char buffer[64];
                 strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", tm_info);
@@ -491,7 +519,7 @@ void listarTicketsTemporarios() {
     printf("├────────┼──────────────┼──────────┼──────┼─────────────────┼──────────────┤\n");
     
     int totalTickets = 0;
-    time_t agora = time(NULL);
+    time_t agora = relogio_time();
     
     for(int i = 0; i < MAX_CARROS; i++) {
         if(carros[i].ativo && carros[i].ticket_temporario && !carros[i].reconciliado) {
@@ -586,7 +614,7 @@ void listarTodosCarros() {
     int totalTickets = 0;
     int totalComPlaca = 0;
     float totalArrecadado = 0.0;
-    time_t agora = time(NULL);
+    time_t agora = relogio_time();
     
     for(int i = 0; i < MAX_CARROS; i++) {
         if(carros[i].ativo) {
@@ -791,21 +819,21 @@ void menu(pthread_t fRecebeTerreo, pthread_t fRecebePrimeiroAndar, pthread_t fRe
             printf("             | Carro %d saiu da vaga A%d pagou %.2f |\n", andar1[15], andar1[17], y);
             printf("              ------------------------------------\n");
             removerCarro(andar1[15]);  // Remove do rastreamento
-            delay(1500);
+            hal_delay(1500);
         }
         if(andar2[14]==1){
             printf("\n              ------------------------------------\n");
             printf("             | Carro %d saiu da vaga B%d pagou %.2f |\n", andar2[15], andar2[17], w);
             printf("              ------------------------------------\n");
             removerCarro(andar2[15]);  // Remove do rastreamento
-            delay(1500);
+            hal_delay(1500);
         }   
         if(terreo[14]==1){
             printf("\n              ------------------------------------\n");
             printf("             | Carro %d saiu da vaga T%d pagou %.2f |\n", terreo[15], terreo[17], z);
             printf("              ------------------------------------\n");
             removerCarro(terreo[15]);  // Remove do rastreamento
-            delay(1500);
+            hal_delay(1500);
         }
         // Controle de entradas - previne duplicatas
         static int ultimoCarroTerreo = 0, ultimoCarroA1 = 0, ultimoCarroA2 = 0;
@@ -816,7 +844,7 @@ void menu(pthread_t fRecebeTerreo, pthread_t fRecebePrimeiroAndar, pthread_t fRe
             printf("                       ---------------------------\n");
             adicionarCarro(andar1[12], 1, andar1[13]);  // Registra no rastreamento
             ultimoCarroA1 = andar1[12];
-            delay(1500);
+            hal_delay(1500);
         } else if(andar1[11] == 0) {
             ultimoCarroA1 = 0;  // Reseta quando flag desativa
         }
@@ -827,7 +855,7 @@ void menu(pthread_t fRecebeTerreo, pthread_t fRecebePrimeiroAndar, pthread_t fRe
             printf("                       ---------------------------\n");
             adicionarCarro(andar2[12], 2, andar2[13]);  // Registra no rastreamento
             ultimoCarroA2 = andar2[12];
-            delay(1500);
+            hal_delay(1500);
         } else if(andar2[11] == 0) {
             ultimoCarroA2 = 0;  // Reseta quando flag desativa
         }
@@ -838,7 +866,7 @@ void menu(pthread_t fRecebeTerreo, pthread_t fRecebePrimeiroAndar, pthread_t fRe
             printf("                       ---------------------------\n");
             adicionarCarro(terreo[12], 0, terreo[13]);  // Registra no rastreamento
             ultimoCarroTerreo = terreo[12];
-            delay(1500);
+            hal_delay(1500);
         } else if(terreo[11] == 0) {
             ultimoCarroTerreo = 0;  // Reseta quando flag desativa
         }
@@ -876,6 +904,7 @@ void menu(pthread_t fRecebeTerreo, pthread_t fRecebePrimeiroAndar, pthread_t fRe
         }
         
         if(kbhit()){
+            relogio_liberar_thread();   // O operador pode demorar: não segura o relógio virtual
             char opcao = toupper(getchar());  // Converte para maiúscula
             pausarAtualizacao = true;
             
@@ -974,7 +1003,7 @@ void menu(pthread_t fRecebeTerreo, pthread_t fRecebePrimeiroAndar, pthread_t fRe
                 printf("\n╔════════════════════════════════════════╗\n");
                 printf("║   >>> ENCERRANDO ESTACIONAMENTO <<<   ║\n");
                 printf("╚════════════════════════════════════════╝\n");
-                delay(1000);
+                hal_delay(1000);
                 pthread_cancel(fRecebeTerreo);
                 pthread_cancel(fRecebePrimeiroAndar);
                 pthread_cancel(fRecebeSegundoAndar);
@@ -993,7 +1022,7 @@ void menu(pthread_t fRecebeTerreo, pthread_t fRecebePrimeiroAndar, pthread_t fRe
         
         if(!pausarAtualizacao){
             printf("\n");
-            delay(1000);
+            hal_delay(1000);
         }
     }  
 }
@@ -1033,28 +1062,21 @@ void *recebePrimeiroAndar(){
 
 
         addr_size = sizeof(client_addr);
+        relogio_liberar_thread();   // Espera o nó no socket: não segura o relógio virtual
         client_sock = accept(server_sock, (struct sockaddr*)&client_addr, &addr_size);
         printf("Client Connected\n");
     
+    int passagens[PASSAGEM_NUM_CONTADORES] = {0};     // Passagens já registradas
     while(1){
-        recv(client_sock, andar1, tamVetorReceber * sizeof(int), 0);
+        relogio_liberar_thread();
+        recv(client_sock, andar1, tamVetorReceberAndar * sizeof(int), 0);
         send (client_sock, enviar, tamVetorEnviar *sizeof(int) , 0);
         
-        // ✅ Detecta e registra passagem entre andares
-        if(andar1[22] == 1){  // Flag de evento de passagem
-            char mensagem[200];
-            if(andar1[21] == 1){
-                // Subindo: Térreo → 1º Andar
-                sprintf(mensagem, "🚗↑ Veículo SUBINDO: Térreo → 1º Andar");
-            } else if(andar1[21] == 2){
-                // Descendo: 1º Andar → Térreo
-                sprintf(mensagem, "🚗↓ Veículo DESCENDO: 1º Andar → Térreo");
-            }
-            registrarEvento(mensagem);
-            printf("%s\n", mensagem);
-        }
+        // ✅ Registra as passagens entre andares (contadores acumulados por par de
+        // andares, então duas passagens no mesmo ciclo não se perdem)
+        registrarPassagens(&andar1[tamVetorReceber], passagens);
         
-        delay(1000);
+        hal_delay(1000);
     }
     close(client_sock);
     printf("Client Disconnected\n");
@@ -1094,28 +1116,21 @@ void *recebeSegundoAndar(){
 
 
         addr_size = sizeof(client_addr);
+        relogio_liberar_thread();   // Espera o nó no socket: não segura o relógio virtual
         client_sock = accept(server_sock, (struct sockaddr*)&client_addr, &addr_size);
         printf("Client Connected\n");
     
+    int passagens[PASSAGEM_NUM_CONTADORES] = {0};     // Passagens já registradas
     while(1){
-        recv(client_sock, andar2, tamVetorReceber * sizeof(int), 0);
+        relogio_liberar_thread();
+        recv(client_sock, andar2, tamVetorReceberAndar * sizeof(int), 0);
         send (client_sock, enviar, tamVetorEnviar *sizeof(int) , 0);
         
-        // ✅ Detecta e registra passagem entre andares
-        if(andar2[22] == 1){  // Flag de evento de passagem
-            char mensagem[200];
-            if(andar2[21] == 1){
-                // Subindo: 1º Andar → 2º Andar
-                sprintf(mensagem, "🚗↑ Veículo SUBINDO: 1º Andar → 2º Andar");
-            } else if(andar2[21] == 2){
-                // Descendo: 2º Andar → 1º Andar
-                sprintf(mensagem, "🚗↓ Veículo DESCENDO: 2º Andar → 1º Andar");
-            }
-            registrarEvento(mensagem);
-            printf("%s\n", mensagem);
-        }
+        // ✅ Registra as passagens entre andares (contadores acumulados por par de
+        // andares, então duas passagens no mesmo ciclo não se perdem)
+        registrarPassagens(&andar2[tamVetorReceber], passagens);
         
-        delay(1000);
+        hal_delay(1000);
     }
     close(client_sock);
     printf("Client 2 Disconnected\n");
@@ -1162,8 +1177,13 @@ void *recebeTerreo(){
 
 
         addr_size = sizeof(client_addr);
+        relogio_liberar_thread();   // Espera o nó no socket: não segura o relógio virtual
         client_sock = accept(server_sock, (struct sockaddr*)&client_addr, &addr_size);
 
+        // Cada ciclo envia duas mensagens seguidas (comandos e placar): sem isto o
+        // algoritmo de Nagle segura a segunda até o ACK atrasado do Térreo (~40 ms)
+        int semAtraso = 1;
+        setsockopt(client_sock, IPPROTO_TCP, TCP_NODELAY, &semAtraso, sizeof(semAtraso));
 
         printf("Client 3 Connected\n");
     
@@ -1171,6 +1191,7 @@ void *recebeTerreo(){
     int dadosPlacar[14];
     
     while(1){
+        relogio_liberar_thread();
         recv(client_sock, terreo, tamVetorReceber * sizeof(int), 0);
         send (client_sock, enviar, tamVetorEnviar *sizeof(int) , 0);
         enviar[0] = terreo[12];
@@ -1226,7 +1247,7 @@ void *recebeTerreo(){
         // Envia dados do placar ao Térreo para ele escrever no MODBUS
         send(client_sock, dadosPlacar, 14 * sizeof(int), 0);
         
-        delay(1000);
+        hal_delay(1000);
     }
     close(client_sock);
     printf("Client Disconnected\n");
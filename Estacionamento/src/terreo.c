@@ -1,4 +1,8 @@
-#include <bcm2835.h>
+#include "../inc/hal_gpio.h"
+#include "../inc/relogio.h"
+#include "../inc/varredura.h"
+#include "../inc/filtro_vagas.h"
+#include "../inc/cancela.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <pthread.h>
@@ -12,13 +16,14 @@
 #include <string.h>
 #include "../inc/lpr_terreo.h"
 #include "../inc/modbus.h"
+#include "../inc/barramento.h"
 
 
 //ANDAR TÉRREO
 #define ENDERECO_01 17                                          // GPIO 17 - SAÍDA
 #define ENDERECO_02 18                                          // GPIO 18 - SAÍDA
 #define SENSOR_DE_VAGA 8                                        // GPIO 08 - ENTRADA
-#define SINAL_DE_LOTADO_FECHADO RPI_V2_GPIO_P1_13               // PINO 27 - SAÍDA // Comentar essa linha se não for usado
+#define SINAL_DE_LOTADO_FECHADO 27                              // GPIO 27 - Pino físico 13 - SAÍDA // Comentar essa linha se não for usado
 #define SENSOR_ABERTURA_CANCELA_ENTRADA 7                       // GPIO 07 - ENTRADA
 #define SENSOR_FECHAMENTO_CANCELA_ENTRADA 1                     // GPIO 01 - ENTRADA
 #define MOTOR_CANCELA_ENTRADA 23                                // GPIO 23 - SAÍDA
@@ -26,29 +31,66 @@
 #define SENSOR_FECHAMENTO_CANCELA_SAIDA 25                      // GPIO 25 - ENTRADA
 #define MOTOR_CANCELA_SAIDA 24                                  // GPIO 24 - SAÍDA
 
+// Multiplexador das vagas do térreo: vaga 1 PcD, vaga 2 idoso, vagas 3 e 4 comuns
+static const DescritorAndar andarTerreo = {
+    "Térreo", 1, { { { ENDERECO_01, ENDERECO_02 }, SENSOR_DE_VAGA } }, 2, 4, VARREDURA_ACOMODACAO_US,
+    { VAGA_PCD, VAGA_IDOSO, VAGA_COMUM, VAGA_COMUM }
+};
+
+// Filtro das leituras das vagas (N de M com permanência mínima); as variáveis
+// FILTRO_VAGAS_* do config.env definidas no ambiente substituem o padrão
+static FiltroVagasConfig filtroTerreoConfig = FILTRO_VAGAS_PADRAO;
+
+// Ritmo da varredura (lento com o andar parado, rápido com atividade) e
+// calibração do multiplexador; as variáveis VARREDURA_* do config.env definidas
+// no ambiente substituem o padrão
+static RitmoVarredura ritmoTerreo = RITMO_VARREDURA_PADRAO;
+static CalibracaoVarredura calibracaoTerreo = CALIBRACAO_VARREDURA_PADRAO;
+
+// Faixa do térreo: cancela (fiação e tempos padrão) e câmera LPR. Os tempos do
+// config.env definidos no ambiente valem para todas as faixas
+typedef struct {
+    CancelaConfig cancela;
+    bool entrada;               // true = faixa de entrada, false = saída
+    uint8_t camera;             // Endereço MODBUS da câmera LPR da faixa
+} FaixaTerreo;
+
+#define TERREO_MAX_FAIXAS 8     // Quatro faixas por direção
+
+// Faixas de entrada e de saída do térreo. Sites maiores acrescentam linhas com
+// os pinos da sua fiação e uma câmera por faixa, por exemplo:
+//   { { "Entrada 2", 5, 6, 13, TEMPOS_CANCELA_PADRAO }, true, 0x13 },
+//   { { "Saída 2", 16, 20, 21, TEMPOS_CANCELA_PADRAO }, false, 0x14 },
+static const FaixaTerreo faixasTerreo[] = {
+    { { "Entrada", SENSOR_ABERTURA_CANCELA_ENTRADA, SENSOR_FECHAMENTO_CANCELA_ENTRADA,
+        MOTOR_CANCELA_ENTRADA, TEMPOS_CANCELA_PADRAO }, true, MODBUS_ADDR_LPR_ENTRADA },
+    { { "Saída", SENSOR_ABERTURA_CANCELA_SAIDA, SENSOR_FECHAMENTO_CANCELA_SAIDA,
+        MOTOR_CANCELA_SAIDA, TEMPOS_CANCELA_PADRAO }, false, MODBUS_ADDR_LPR_SAIDA },
+};
+#define NUM_FAIXAS_TERREO ((int)(sizeof(faixasTerreo) / sizeof(faixasTerreo[0])))
+
+_Static_assert(NUM_FAIXAS_TERREO <= TERREO_MAX_FAIXAS, "faixas demais no térreo");
+
 void configuraPinos(){
-    bcm2835_gpio_fsel(ENDERECO_01, BCM2835_GPIO_FSEL_OUTP);
-    bcm2835_gpio_fsel(ENDERECO_02, BCM2835_GPIO_FSEL_OUTP);
-    bcm2835_gpio_fsel(SENSOR_DE_VAGA, BCM2835_GPIO_FSEL_INPT);
-    bcm2835_gpio_fsel(SINAL_DE_LOTADO_FECHADO, BCM2835_GPIO_FSEL_OUTP);
-    bcm2835_gpio_fsel(SENSOR_ABERTURA_CANCELA_ENTRADA, BCM2835_GPIO_FSEL_INPT);
-    bcm2835_gpio_fsel(SENSOR_FECHAMENTO_CANCELA_ENTRADA, BCM2835_GPIO_FSEL_INPT);
-    bcm2835_gpio_fsel(MOTOR_CANCELA_ENTRADA, BCM2835_GPIO_FSEL_OUTP);
-    bcm2835_gpio_fsel(SENSOR_ABERTURA_CANCELA_SAIDA, BCM2835_GPIO_FSEL_INPT);
-    bcm2835_gpio_fsel(SENSOR_FECHAMENTO_CANCELA_SAIDA, BCM2835_GPIO_FSEL_INPT);
-    bcm2835_gpio_fsel(MOTOR_CANCELA_SAIDA, BCM2835_GPIO_FSEL_OUTP);
+    hal_gpio_fsel(ENDERECO_01, HAL_GPIO_SAIDA);
+    hal_gpio_fsel(ENDERECO_02, HAL_GPIO_SAIDA);
+    hal_gpio_fsel(SENSOR_DE_VAGA, HAL_GPIO_ENTRADA);
+    hal_gpio_fsel(SINAL_DE_LOTADO_FECHADO, HAL_GPIO_SAIDA);
     
     // Configura pull-down nos sensores para evitar leituras falsas
-    bcm2835_gpio_set_pud(SENSOR_DE_VAGA, BCM2835_GPIO_PUD_DOWN);
-    bcm2835_gpio_set_pud(SENSOR_ABERTURA_CANCELA_ENTRADA, BCM2835_GPIO_PUD_DOWN);
-    bcm2835_gpio_set_pud(SENSOR_FECHAMENTO_CANCELA_ENTRADA, BCM2835_GPIO_PUD_DOWN);
-    bcm2835_gpio_set_pud(SENSOR_ABERTURA_CANCELA_SAIDA, BCM2835_GPIO_PUD_DOWN);
-    bcm2835_gpio_set_pud(SENSOR_FECHAMENTO_CANCELA_SAIDA, BCM2835_GPIO_PUD_DOWN);
+    hal_gpio_set_pud(SENSOR_DE_VAGA, HAL_PUD_DOWN);
     
-    // Inicializa motores das cancelas como LOW (fechadas)
-    bcm2835_gpio_write(MOTOR_CANCELA_ENTRADA, LOW);
-    bcm2835_gpio_write(MOTOR_CANCELA_SAIDA, LOW);
-    bcm2835_gpio_write(SINAL_DE_LOTADO_FECHADO, LOW);
+    // Sensores e motor de cada faixa; motores começam em LOW (cancelas fechadas)
+    for(int i = 0; i < NUM_FAIXAS_TERREO; i++){
+        const CancelaConfig *c = &faixasTerreo[i].cancela;
+        hal_gpio_fsel(c->sensor_abertura, HAL_GPIO_ENTRADA);
+        hal_gpio_fsel(c->sensor_fechamento, HAL_GPIO_ENTRADA);
+        hal_gpio_fsel(c->motor, HAL_GPIO_SAIDA);
+        hal_gpio_set_pud(c->sensor_abertura, HAL_PUD_DOWN);
+        hal_gpio_set_pud(c->sensor_fechamento, HAL_PUD_DOWN);
+        hal_gpio_write(c->motor, LOW);
+    }
+    hal_gpio_write(SINAL_DE_LOTADO_FECHADO, LOW);
 }
 
 typedef struct vaga
@@ -57,27 +99,20 @@ typedef struct vaga
     struct timeval hsaida;  // Horário de saída do carro da vaga
     int tempo;              // Tempo de permanência do carro na vaga
     int ncarro;             // Número do carro estacionado
-    int ocupado;            // ex: Vaga 1 = 1, Vaga 2 = 2, Vaga 3 = 3, Vaga 4 = 4, Vaga livre = 0
-    bool boolocupado;       // 0 = vaga livre, 1 = vaga ocupada
 }vaga;
 
-typedef struct vsoma{
-    int somaValores;    // Soma dos valores das vagas ocupadas (ex: 1+2+3+4 = 10)
-    int somaVagas;      // Soma das vagas ocupadas (ex: 1+1+1+1 = 4)
-}vsoma;
-
 int carro = 0;
-int valor;                          // Valor lido pelo sensor de vaga
 bool carroAndar = false;            // 0 = carro não está andando, 1 = carro está andando
 vaga *v;
-vsoma x;
-int k=0, j=0, carroTotal=0;
+Varredura varreduraTerreo;
+FiltroVagas filtroTerreo;
+MapaVagas ocupadasTerreo = 0;       // Bit i = vaga i com carro registrado
+int carroTotal=0;
 int idoso = 1, pcd = 1, normal = 2;
-int anteriorSomaValores = 0;
-bool entradaManual = false;         // Controle manual de entrada via ThingsBoard
-bool saidaManual = false;           // Controle manual de saída via ThingsBoard
-bool entradaManualEmAndamento = false; // Flag para controlar se uma entrada manual está em andamento
-bool carroPassouEntrada = false;    // Flag para detectar se o carro já passou
+Cancela cancelasTerreo[TERREO_MAX_FAIXAS];       // cancelasTerreo[i] é a faixa faixasTerreo[i]
+CancelaConfig configCancelas[TERREO_MAX_FAIXAS]; // Fiação da faixa com os tempos do ambiente
+TrabalhadorCancelas trabalhadoresCancela[CANCELA_TRABALHADORES(TERREO_MAX_FAIXAS)];
+int numTrabalhadoresCancela = 0;
 
 #define tamVetorEnviar 22
 #define tamVetorReceber 5
@@ -89,22 +124,111 @@ int dadosPlacar[tamDadosPlacar];  // Novo: dados do placar recebidos do Central
 int fechado = 0;
 
 // ✅ MODBUS centralizado no Térreo conforme especificação
+// A porta pertence ao barramento (barramento.c); este fd só identifica o barramento
 int modbus_fd_terreo = -1;
-pthread_mutex_t mutex_modbus_terreo = PTHREAD_MUTEX_INITIALIZER;
+
+// Tickets de entrada: a cancela abre com o ticket TEMP#### e a placa é
+// anexada quando a captura assíncrona da câmera termina
+#define TAM_TICKETS 32                  // Folga para quatro faixas de entrada em pipeline
+
+typedef struct ticketEntrada{
+    int numeroCarro;        // Número do carro (ID do ticket)
+    char placa[9];          // Placa lida ou "TEMP####"
+    int confianca;          // Confiança da leitura (0 se não lida)
+    bool temporario;        // true enquanto não houver placa confiável
+    bool pendente;          // true enquanto a captura está em andamento
+}ticketEntrada;
+
+ticketEntrada tickets[TAM_TICKETS];
+pthread_mutex_t mutex_tickets = PTHREAD_MUTEX_INITIALIZER;
+int numeroEntrada = 0;              // Contador de tickets de entrada (ID das capturas de entrada)
+int numeroSaida = 0;                // Contador de eventos de saída (ID das capturas de saída)
+                                    // Contadores compartilhados pelas faixas: sob mutex_tickets
+
+//Faixa de uma cancela do térreo
+static const FaixaTerreo *faixaDaCancela(const Cancela *c){
+    return &faixasTerreo[c - cancelasTerreo];
+}
+
+//Próximo número de um contador compartilhado pelas faixas
+static int proximoNumero(int *contador){
+    pthread_mutex_lock(&mutex_tickets);
+    int numero = ++*contador;
+    pthread_mutex_unlock(&mutex_tickets);
+    return numero;
+}
+
+//Função chamada pela thread da câmera de entrada quando a placa fica pronta
+void anexarPlacaTicket(const LPRResultado *r){
+    pthread_mutex_lock(&mutex_tickets);
+    ticketEntrada *t = &tickets[r->numeroCarro % TAM_TICKETS];
+    if(t->numeroCarro != r->numeroCarro){
+        pthread_mutex_unlock(&mutex_tickets);
+        fprintf(stderr, "[Ticket] Resultado da câmera para carro %d chegou tarde demais - descartado\n", r->numeroCarro);
+        return;
+    }
+    
+    if(r->sucesso && r->confianca >= LPR_CONFIANCA_LIMIAR){
+        strncpy(t->placa, r->placa, 8);
+        t->placa[8] = '\0';
+        t->temporario = false;
+    }
+    t->confianca = r->confianca;
+    t->pendente = false;
+    
+    if(t->temporario){
+        printf("[Ticket] Carro %d mantém ticket %s (placa não identificada, %.0f ms)\n",
+               t->numeroCarro, t->placa, r->latencia_ms);
+    } else {
+        printf("[Ticket] Carro %d ← placa %s (conf: %d%%, %.0f ms após o sensor)\n",
+               t->numeroCarro, t->placa, t->confianca, r->latencia_ms);
+    }
+    pthread_mutex_unlock(&mutex_tickets);
+}
+
+//Função que emite o ticket de entrada e agenda a leitura da placa na câmera da faixa sem bloquear a cancela
+void emitirTicketEntrada(int numeroCarro, uint8_t camera){
+    pthread_mutex_lock(&mutex_tickets);
+    ticketEntrada *t = &tickets[numeroCarro % TAM_TICKETS];
+    t->numeroCarro = numeroCarro;
+    snprintf(t->placa, sizeof(t->placa), "TEMP%04u", (unsigned)numeroCarro % 10000u);
+    t->confianca = 0;
+    t->temporario = true;
+    t->pendente = true;
+    pthread_mutex_unlock(&mutex_tickets);
+    
+    if(!lpr_capturar_async(camera, numeroCarro, anexarPlacaTicket)){
+        pthread_mutex_lock(&mutex_tickets);
+        t->pendente = false;
+        pthread_mutex_unlock(&mutex_tickets);
+        printf("[Ticket] Carro %d recebeu ticket temporário TEMP%04u (LPR indisponível)\n",
+               numeroCarro, (unsigned)numeroCarro % 10000u);
+    }
+}
+
+//Função chamada pela thread da câmera de saída quando a placa fica pronta
+void registrarPlacaSaida(const LPRResultado *r){
+    if(r->sucesso){
+        printf("[Saída] Evento %d: placa %s identificada (conf: %d%%, %.0f ms após o sensor)\n",
+               r->numeroCarro, r->placa, r->confianca, r->latencia_ms);
+    } else {
+        printf("[Saída] Evento %d: placa não identificada\n", r->numeroCarro);
+    }
+}
 
 // Função para inicializar todas as vagas como vazias
 void inicializarVagasTerreo(vaga *v){
     printf("Inicializando térreo - Todas as vagas vazias\n");
     for(int i = 0; i < 4; i++){
-        v[i].ocupado = 0;
-        v[i].boolocupado = 0;
         v[i].ncarro = 0;
         v[i].tempo = 0;
     }
-    x.somaValores = 0;
-    x.somaVagas = 0;
-    anteriorSomaValores = 0;
+    ocupadasTerreo = 0;
     carroTotal = 0;
+    varredura_parametros_do_ambiente(&ritmoTerreo, &calibracaoTerreo);
+    varredura_init(&varreduraTerreo, &andarTerreo, &ritmoTerreo, &calibracaoTerreo);
+    filtro_vagas_config_do_ambiente(&filtroTerreoConfig);
+    filtro_vagas_init(&filtroTerreo, &filtroTerreoConfig, andarTerreo.num_vagas);
     printf("Térreo inicializado com sucesso - 4 vagas disponíveis\n");
 }
 
@@ -113,207 +237,126 @@ int separaIguala(){
     parametros[0] = pcd;
     parametros[1] = idoso;
     parametros[2] = normal;
-    parametros[3] = v[0].boolocupado;
-    parametros[4] = v[1].boolocupado;
-    parametros[5] = v[2].boolocupado;
-    parametros[6] = v[3].boolocupado;
+    for(int i = 0; i < andarTerreo.num_vagas; i++){
+        parametros[3 + i] = (ocupadasTerreo & MAPA_VAGA(i)) != 0;
+    }
     parametros[12] = carroTotal;
-    parametros[18] = x.somaVagas;
+    parametros[18] = mapa_contar(ocupadasTerreo);
     fechado = recebe[1];
     parametros[19] = recebe[4];    
 }
 
-//Função que lê o sensor da cancela de entrada quando um carro está entrando no estacionamento
-void * sensorEntrada(){
-    while(1){
-        
-        // Se o estacionamento está fechado, reseta todos os flags e garante que a cancela está fechada
-        if(fechado==1){
-            bcm2835_gpio_write(MOTOR_CANCELA_ENTRADA, LOW);
-            entradaManual = false;
-            entradaManualEmAndamento = false;
-            carroPassouEntrada = false;
-            j = 0;
-            parametros[19] = 0;
-            delay(100);
-            continue;
-        }
-        
-        if(fechado==0){
+//Função que conta o carro que passou por uma cancela de entrada e mostra a placa do seu ticket
+void registrarEntrada(const char *faixa, int numeroTicket, bool manual){
+    char placa[9] = "?";
+    bool pendente = false;
+    pthread_mutex_lock(&mutex_tickets);
+    int numeroCarro = ++carroTotal;
+    ticketEntrada *t = &tickets[numeroTicket % TAM_TICKETS];
+    if(t->numeroCarro == numeroTicket){
+        strcpy(placa, t->placa);
+        pendente = t->pendente;
+    }
+    pthread_mutex_unlock(&mutex_tickets);
+    printf("Carro %d entrou %s na %s (ticket %d: %s%s)\n", numeroCarro,
+           manual ? "manualmente" : "pelo sensor", faixa, numeroTicket, placa,
+           pendente ? ", câmera ainda lendo" : "");
+}
 
-        // Controle manual via ThingsBoard - Permite apenas 1 carro por comando
-        if(entradaManual && !entradaManualEmAndamento){
-            // ✅ CORREÇÃO: Incrementa carroTotal ANTES de processar entrada
-            ++carroTotal;
-            printf("ENTRADA MANUAL ATIVADA - Carro %d entrando\n", carroTotal);
-            
-            // === INTEGRAÇÃO LPR: Dispara captura de placa ===
-            char placa[9];
-            int confianca = 0;
-            bool placaLida = lpr_processar_entrada(carroTotal, placa, &confianca);  // ← Usa carroTotal já incrementado
-            
-            bcm2835_gpio_write(MOTOR_CANCELA_ENTRADA, HIGH);
-            parametros[19]=1;
-            entradaManualEmAndamento = true; // Marca que uma operação manual está em andamento
-            carroPassouEntrada = false;
-            j = 1;  // ✅ Marca que carro já entrou (não incrementar novamente)
-            
-            if(placaLida) {
-                printf("Aguardando carro com placa %s (conf: %d%%) passar...\n", placa, confianca);
-            } else {
-                printf("Aguardando carro passar (placa não identificada)...\n");
-            }
-            delay(1000); // Delay para estabilizar a abertura
+//Alguma cancela de entrada em cima (parametros[19] só desce quando todas descem)
+static bool entradaAberta(){
+    for(int i = 0; i < NUM_FAIXAS_TERREO; i++){
+        EstadoCancela e = cancela_estado(&cancelasTerreo[i]);
+        if(faixasTerreo[i].entrada && e != CANCELA_OCIOSA && e != CANCELA_LENDO && e != CANCELA_FECHANDO){
+            return true;
         }
-        
-        // Se entrada manual está em andamento, aguarda o carro passar (ou simula)
-        if(entradaManualEmAndamento){
-            // Detecta quando o carro passa pelo sensor de fechamento (se hardware presente)
-            if(HIGH == bcm2835_gpio_lev(SENSOR_FECHAMENTO_CANCELA_ENTRADA)){
-                if(!carroPassouEntrada){
-                    carroPassouEntrada = true;
-                    printf("Carro %d detectado passando pela cancela (sensor físico)\n", carroTotal);
-                    delay(2000); // Aguarda o carro passar completamente
-                }
-            }
-            // ✅ CORREÇÃO: Se não há sensor físico, simula passagem após delay
-            else {
-                delay(2000);  // Simula tempo de passagem sem sensor
-                carroPassouEntrada = true;
-                printf("Carro %d passou pela cancela (entrada manual simulada)\n", carroTotal);
-            }
-            
-            // Após o carro passar, fecha a cancela e reseta os flags
-            if(carroPassouEntrada){
-                printf("ENTRADA MANUAL - Fechando cancela de entrada\n");
-                bcm2835_gpio_write(MOTOR_CANCELA_ENTRADA, LOW);
-                parametros[19]=0;
-                
-                // Reseta todos os flags para aguardar novo comando
-                entradaManual = false;
-                entradaManualEmAndamento = false;
-                carroPassouEntrada = false;
-                j=0;
-                printf("Cancela fechada. Aguardando novo comando para permitir outra entrada.\n");
-                delay(1000); // Delay de segurança
+    }
+    return false;
+}
+
+//Avisos de uma cancela de entrada: ticket na chegada, contagem na passagem
+bool avisoCancelaEntrada(Cancela *c, AvisoCancela aviso, VeiculoCancela *veiculo){
+    const FaixaTerreo *faixa = faixaDaCancela(c);
+    switch(aviso){
+        case CANCELA_AVISO_CHEGADA:
+            // Comando manual já validou as vagas; o carro no sensor só é barrado com o estacionamento fechado
+            if(!veiculo->manual && fechado == 1){
+                return false;
             }
-        }
-        // Controle por sensores físicos (modo automático) - Só funciona se não houver entrada manual em andamento
-        if(!entradaManual && !entradaManualEmAndamento){
-            //Lê o sensor de abertura da cancela de entrada e aciona o motor da cancela para abrir
-            if(HIGH == bcm2835_gpio_lev(SENSOR_ABERTURA_CANCELA_ENTRADA)){
-                // === INTEGRAÇÃO LPR: Dispara captura de placa ao detectar carro ===
-                char placa[9];
-                int confianca = 0;
-                bool placaLida = lpr_processar_entrada(carroTotal + 1, placa, &confianca);
-                
-                bcm2835_gpio_write(MOTOR_CANCELA_ENTRADA, HIGH);
-                parametros[19]=1;
-                
-                if(placaLida) {
-                    printf("[Entrada-Auto] Placa %s detectada (conf: %d%%)\n", placa, confianca);
-                } else {
-                    printf("[Entrada-Auto] Placa não identificada - ticket temporário será criado\n");
+            // Ticket na chegada: a captura da placa corre enquanto o carro anterior ainda passa
+            if(veiculo->id == 0){
+                veiculo->id = proximoNumero(&numeroEntrada);
+                if(veiculo->manual){
+                    printf("ENTRADA MANUAL ATIVADA na %s - Ticket %d\n", c->cfg->nome, veiculo->id);
                 }
-                
-                delay(100); // Delay para evitar detecções múltiplas
+                // === INTEGRAÇÃO LPR: Agenda captura na chegada do carro (a cancela não espera a câmera) ===
+                emitirTicketEntrada(veiculo->id, faixa->camera);
             }
-            //Lê o sensor de fechamento da cancela e aciona o motor da cancela para fechar
-            if(HIGH == bcm2835_gpio_lev(SENSOR_FECHAMENTO_CANCELA_ENTRADA)){
-                bcm2835_gpio_write(MOTOR_CANCELA_ENTRADA, LOW);
+            return true;
+        case CANCELA_AVISO_LIBERADA:
+            parametros[19]=1;
+            varredura_atividade(&varreduraTerreo, "cancela de entrada");
+            break;
+        case CANCELA_AVISO_PASSOU:
+            registrarEntrada(c->cfg->nome, veiculo->id, veiculo->manual);
+            break;
+        case CANCELA_AVISO_FECHANDO:
+            if(!entradaAberta()){
                 parametros[19]=0;
-                if(j==0){
-                    ++carroTotal;
-                    j=1;
-                    printf("Carro %d entrou automaticamente (sensor)\n", carroTotal);
-                    delay(2000); // Delay maior para evitar contagem duplicada
-                }
-            }else {
-                j=0;
             }
-        }
-        
-        }
-        
-        delay(100); // Delay principal do loop para evitar execução contínua
-        
+            break;
     }
+    return true;
 }
 
-//Função que lê o sensor da cancela de saída quando um carro está saindo do estacionamento
-void * sensorSaida(){
-    while(1){
-        
-        // Controle manual via ThingsBoard
-        if(saidaManual){
-            printf("SAÍDA MANUAL ATIVADA - Processando saída com LPR\n");
-            
-            // === INTEGRAÇÃO LPR: Lê placa na saída ===
-            char placa[9];
-            int confianca = 0;
-            bool placaLida = lpr_processar_saida(placa, &confianca);
-            
-            if(placaLida) {
-                printf("[Saída-Manual] Placa %s identificada (conf: %d%%)\n", placa, confianca);
-            } else {
-                printf("[Saída-Manual] Placa não identificada\n");
-            }
-            
-            bcm2835_gpio_write(MOTOR_CANCELA_SAIDA, HIGH);
-            delay(2000); // Simula tempo de abertura da cancela
-            
-            printf("SAÍDA MANUAL - Fechando cancela de saída\n");
-            bcm2835_gpio_write(MOTOR_CANCELA_SAIDA, LOW);
-            parametros[19]=0;
-            printf("Carro saiu manualmente\n");
-            delay(3000); // Delay para evitar operações duplicadas
-            saidaManual = false; // Reset do controle manual
-        }
-        // Controle por sensores físicos (modo automático)
-        else {
-            //Lê o sensor de abertura da cancela de saida e aciona o motor da cancela para abrir
-            if(HIGH == bcm2835_gpio_lev(SENSOR_ABERTURA_CANCELA_SAIDA)){
-                // === INTEGRAÇÃO LPR: Lê placa na saída (automático) ===
-                char placa[9];
-                int confianca = 0;
-                bool placaLida = lpr_processar_saida(placa, &confianca);
-                
-                if(placaLida) {
-                    printf("[Saída-Auto] Placa %s identificada (conf: %d%%)\n", placa, confianca);
-                } else {
-                    printf("[Saída-Auto] Placa não identificada\n");
+//Avisos de uma cancela de saída: leitura da placa na chegada
+bool avisoCancelaSaida(Cancela *c, AvisoCancela aviso, VeiculoCancela *veiculo){
+    const FaixaTerreo *faixa = faixaDaCancela(c);
+    switch(aviso){
+        case CANCELA_AVISO_CHEGADA:
+            // === INTEGRAÇÃO LPR: Agenda leitura da placa na chegada ===
+            if(veiculo->id == 0){
+                veiculo->id = proximoNumero(&numeroSaida);
+                if(!lpr_capturar_async(faixa->camera, veiculo->id, registrarPlacaSaida)) {
+                    printf("[Saída] LPR indisponível - saída sem leitura de placa\n");
                 }
-                
-                bcm2835_gpio_write(MOTOR_CANCELA_SAIDA, HIGH);
-                delay(100); // Delay para evitar detecções múltiplas
             }
-            //Lê o sensor de saída da cancela de saída e aciona o motor da cancela para fechar
-            if(HIGH == bcm2835_gpio_lev(SENSOR_FECHAMENTO_CANCELA_SAIDA)){
-                bcm2835_gpio_write(MOTOR_CANCELA_SAIDA, LOW);
+            return true;
+        case CANCELA_AVISO_LIBERADA:
+            varredura_atividade(&varreduraTerreo, "cancela de saída");
+            break;
+        case CANCELA_AVISO_PASSOU:
+            printf("Carro saiu %s na %s (evento %d)\n", veiculo->manual ? "manualmente" : "pelo sensor",
+                   c->cfg->nome, veiculo->id);
+            break;
+        case CANCELA_AVISO_FECHANDO:
+            if(!entradaAberta()){
                 parametros[19]=0;
-                delay(100); // Delay para evitar detecções múltiplas
             }
-        }
-        
-        delay(100); // Delay principal do loop para evitar execução contínua
+            break;
     }
+    return true;
 }
 
-//Função que verifica quais vagas estão ocupadas
-void vagasOcupadas(vaga *v){
-    
-    x.somaValores = 0;
-    x.somaVagas = 0;
-    for(int i = 0; i<4; i++){
-        if(v[i].ocupado != 0){
-            x.somaVagas++;
+//Faixa que atende um comando manual: a primeira ociosa da direção, senão a primeira da direção
+static Cancela *cancelaParaComando(bool entrada){
+    Cancela *escolhida = NULL;
+    for(int i = 0; i < NUM_FAIXAS_TERREO; i++){
+        if(faixasTerreo[i].entrada != entrada){
+            continue;
+        }
+        if(cancela_estado(&cancelasTerreo[i]) == CANCELA_OCIOSA){
+            return &cancelasTerreo[i];
+        }
+        if(escolhida == NULL){
+            escolhida = &cancelasTerreo[i];
         }
-        x.somaValores += v[i].ocupado;
     }
+    return escolhida;
 }
 
-//Função que verifica e imprime as vagas disponíveis por tipo
-void * vagasDisponiveis(vaga *v){
+//Função que calcula as vagas disponíveis por tipo
+void * vagasDisponiveis(){
     // Se o estacionamento está fechado, todas as vagas são consideradas indisponíveis
     if(fechado == 1){
         idoso = 0;
@@ -322,45 +365,10 @@ void * vagasDisponiveis(vaga *v){
         return NULL;
     }
     
-    idoso = 1;
-    pcd = 1;
-    normal = 2;
-    
-        // Vagas normais (vagas 3 e 4)
-        for(int i=2; i<4; i++){
-            if(v[i].ocupado > 0)
-                v[i].boolocupado = 1;
-            
-            else if(v[i].ocupado == 0)
-                v[i].boolocupado=0;
-            normal -= v[i].boolocupado;
-        }
-        
-        // Vaga idoso (vaga 2)
-        if(v[1].ocupado > 0){
-            v[1].boolocupado = 1;
-            idoso = 0;
-        }
-        else if(v[1].ocupado == 0) {
-            v[1].boolocupado = 0;
-            idoso = 1;
-        }
-        
-        // Vaga PCD (vaga 1)
-        if(v[0].ocupado > 0){
-            pcd=0;
-            v[0].boolocupado = 1;
-        }
-        else if(v[0].ocupado == 0) {
-            pcd=1;
-            v[0].boolocupado=0;
-        }
-
-}
-
-//Função que verifica a mudança de estado das vagas
-int mudancaEstadoVaga(vsoma *s, int anteriorSomaValores){
-    return anteriorSomaValores-s->somaValores; 
+    pcd = varredura_livres(&varreduraTerreo, ocupadasTerreo, VAGA_PCD);
+    idoso = varredura_livres(&varreduraTerreo, ocupadasTerreo, VAGA_IDOSO);
+    normal = varredura_livres(&varreduraTerreo, ocupadasTerreo, VAGA_COMUM);
+    return NULL;
 }
 
 //Função que calcula o tempo de permanência do carro na vaga
@@ -370,7 +378,7 @@ int timediff(struct timeval entrada, struct timeval saida){
 
 //Função que calcula o valor a ser pago pelo carro que estava na vaga
 void pagamento(int g, vaga *v){
-    gettimeofday(&v[g-1].hsaida,0);
+    relogio_gettimeofday(&v[g-1].hsaida);
     // Calcula tempo em segundos e arredonda para cima em minutos (conforme regra de negócio)
     int segundos = timediff(v[g-1].hent,v[g-1].hsaida);
     int minutos = (segundos + 59) / 60; // Arredonda para cima: qualquer fração = 1 minuto
@@ -382,19 +390,18 @@ void pagamento(int g, vaga *v){
     parametros[15]=v[g-1].ncarro;
     parametros[16]=minutos;
     parametros[17]=g;
-    delay(100);  // ✅ REDUZIDO: 100ms para atualização mais rápida
+    hal_delay(100);  // ✅ REDUZIDO: 100ms para atualização mais rápida
     parametros[14]=0;
 }
 
 //Função que verifica em qual vaga o carro estacionou
 void buscaCarro(int f , vaga *v){
-    f *= -1;
     v[f-1].ncarro = carroTotal;
-    gettimeofday(&v[f-1].hent,0);
+    relogio_gettimeofday(&v[f-1].hent);
     parametros[11] = 1;
     parametros[13] = f;
 
-    delay(1000);
+    hal_delay(1000);
     parametros[11] = 0;
 }
 
@@ -441,82 +448,57 @@ void ativarEntradaManual(){
         return;  // ← NÃO permite entrada
     }
     
-    entradaManual = true;
-    printf("✅ ENTRADA MANUAL SOLICITADA VIA THINGSBOARD (vagas disponíveis)\n");
+    Cancela *c = cancelaParaComando(true);
+    if(c == NULL){
+        printf("❌ ENTRADA MANUAL NEGADA - Nenhuma faixa de entrada configurada\n");
+        return;
+    }
+    cancela_comandar(c);
+    printf("✅ ENTRADA MANUAL SOLICITADA VIA THINGSBOARD na %s (vagas disponíveis)\n", c->cfg->nome);
 }
 
 //Função para ativar saída manual via ThingsBoard
 void ativarSaidaManual(){
-    saidaManual = true;
-    printf("SAÍDA MANUAL SOLICITADA VIA THINGSBOARD\n");
+    Cancela *c = cancelaParaComando(false);
+    if(c == NULL){
+        printf("SAÍDA MANUAL NEGADA - Nenhuma faixa de saída configurada\n");
+        return;
+    }
+    cancela_comandar(c);
+    printf("SAÍDA MANUAL SOLICITADA VIA THINGSBOARD na %s\n", c->cfg->nome);
 }
 
 //Função que lê o estado das vagas do terreo
 void leituraVagasTerreo(vaga *v){
-    k=0;
-    anteriorSomaValores = 0;        
-    x.somaVagas = 0;
-    x.somaValores = 0;
+    ocupadasTerreo = 0;
 
     while(1){
-        delay(50);
-        delay(50);
-        vagasOcupadas(v);
-        vagasDisponiveis(v);
+        varredura_aguardar(&varreduraTerreo);
+        vagasDisponiveis();
         separaIguala();
 
-        //Primeira vaga
-        bcm2835_gpio_write(ENDERECO_01, LOW);
-        bcm2835_gpio_write(ENDERECO_02, LOW);
-        delay(50);
-        valor = bcm2835_gpio_lev(SENSOR_DE_VAGA);
-        if(valor == 1)
-            v[0].ocupado = 1;
-
-        else if(valor == 0) 
-            v[0].ocupado = 0;
-        
-        //Segunda vaga
-        bcm2835_gpio_write(ENDERECO_01, HIGH);
-        bcm2835_gpio_write(ENDERECO_02, LOW);
-        delay(50);
-        valor = bcm2835_gpio_lev(SENSOR_DE_VAGA);
-        if(valor == 1)
-            v[1].ocupado = 2;
-        else if(valor == 0) 
-            v[1].ocupado = 0;
-
-        //Terceira vaga
-        bcm2835_gpio_write(ENDERECO_01, LOW);
-        bcm2835_gpio_write(ENDERECO_02, HIGH);
-        delay(50);
-        valor = bcm2835_gpio_lev(SENSOR_DE_VAGA);
-        if(valor == 1)
-            v[2].ocupado = 3;
-        else if(valor == 0) 
-            v[2].ocupado = 0;        
-
-        //Quarta vaga
-        bcm2835_gpio_write(ENDERECO_01, HIGH);
-        bcm2835_gpio_write(ENDERECO_02, HIGH);
-        delay(50);
-        valor = bcm2835_gpio_lev(SENSOR_DE_VAGA);
-        if(valor == 1)
-            v[3].ocupado = 4;
-        else if(valor == 0) 
-            v[3].ocupado = 0;        
-
-            
-        k = mudancaEstadoVaga(&x, anteriorSomaValores);
+        // Lê as 4 vagas pelo multiplexador, filtra o ruído e trata cada vaga que mudou
+        MapaVagas lidas = filtro_vagas_aplicar(&filtroTerreo, varredura_executar(&varreduraTerreo), relogio_agora_ms());
+        MapaVagas mudancas = lidas ^ ocupadasTerreo;
+        // Vaga mudando (ou ainda em confirmação no filtro): mantém o ritmo rápido
+        if(mudancas || filtroTerreo.pendentes){
+            varredura_atividade(&varreduraTerreo, "vaga");
+        }
         parametros[16]=0;
-        if(k>0 && k<5){
-            parametros[19] = 1;
-            pagamento(k, v);
-        }else if(k<0 && k>-5){  
-            parametros[19] = 0;
-            buscaCarro(k, v);
-        } 
-        anteriorSomaValores = x.somaValores;
+        int i;
+        while((i = mapa_retirar(&mudancas)) >= 0){
+            if(lidas & MAPA_VAGA(i)){
+                ocupadasTerreo |= MAPA_VAGA(i);
+                parametros[19] = 0;
+                varredura_registrar_publicacao(&varreduraTerreo, filtro_vagas_atraso_ms(&filtroTerreo, i, relogio_agora_ms()));
+                buscaCarro(i + 1, v);
+            } else {
+                ocupadasTerreo &= ~MAPA_VAGA(i);
+                parametros[19] = 1;
+                varredura_registrar_publicacao(&varreduraTerreo, filtro_vagas_atraso_ms(&filtroTerreo, i, relogio_agora_ms()));
+                pagamento(i + 1, v);
+            }
+        }
     
         // ✅ CORREÇÃO: Usa bit0 do placar MODBUS (já inclui lotado OU fechado)
         // dadosPlacar[12] = flags do Servidor Central
@@ -524,10 +506,10 @@ void leituraVagasTerreo(vaga *v){
         int bit0_lotado_ou_fechado = dadosPlacar[12] & 0x01;
         
         if(bit0_lotado_ou_fechado) {
-            bcm2835_gpio_write(SINAL_DE_LOTADO_FECHADO, HIGH);
+            hal_gpio_write(SINAL_DE_LOTADO_FECHADO, HIGH);
         }
         else {
-            bcm2835_gpio_write(SINAL_DE_LOTADO_FECHADO, LOW);
+            hal_gpio_write(SINAL_DE_LOTADO_FECHADO, LOW);
         }
     }
 }
@@ -545,15 +527,15 @@ void *chamaLeitura(){
  */
 void *atualizaPlacarModbus() {
     // Aguarda 3 segundos para estabilizar comunicação TCP/IP com Central
-    delay(3000);
+    hal_delay(3000);
     
     printf("[MODBUS-Placar-Térreo] Thread iniciada\n");
     printf("[MODBUS-Placar-Térreo] ✅ Centralizando interface MODBUS no Térreo (conforme spec)\n");
     
-    // ✅ Inicializa MODBUS no Térreo (conforme orientação da especificação)
-    pthread_mutex_lock(&mutex_modbus_terreo);
-    modbus_fd_terreo = modbus_init(MODBUS_SERIAL_PORT);
-    pthread_mutex_unlock(&mutex_modbus_terreo);
+    // ✅ Usa o barramento único do Térreo (já aberto pelo LPR, senão abre aqui)
+    if(barramento_init(modbus_porta_serial())) {
+        modbus_fd_terreo = barramento_fd();
+    }
     
     if(modbus_fd_terreo < 0) {
         fprintf(stderr, "[MODBUS-Placar-Térreo] AVISO: Falha ao inicializar porta serial\n");
@@ -564,6 +546,13 @@ void *atualizaPlacarModbus() {
         printf("[MODBUS-Placar-Térreo] ✅ Aguardando comandos do Servidor Central...\n");
     }
     
+    // Espelho do que já está no placar: só os registros alterados vão para o fio
+    PlacarEspelho espelho;
+    memset(&espelho, 0, sizeof(espelho));
+    struct timeval ultimoCompleto = {0, 0};
+    struct timeval inicioRajada = {0, 0};
+    bool rajadaPendente = false;
+    
     while(1) {
         // Verifica se há comando para atualizar (dadosPlacar[13] = 1)
         if(dadosPlacar[13] == 1 && modbus_fd_terreo >= 0) {
@@ -584,22 +573,45 @@ void *atualizaPlacarModbus() {
             placar.num_carros_a2 = dadosPlacar[11];
             placar.flags = dadosPlacar[12];
             
-            // ✅ Escreve no placar MODBUS 0x20 (conforme especificação)
-            pthread_mutex_lock(&mutex_modbus_terreo);
-            bool success = placar_update(modbus_fd_terreo, &placar);
-            pthread_mutex_unlock(&mutex_modbus_terreo);
+            uint16_t registros[PLACAR_NUM_REGS];
+            placar_para_registros(&placar, registros);
+            bool mudou = !espelho.valido || memcmp(registros, espelho.regs, sizeof(registros)) != 0;
             
-            if(!success) {
-                static int erro_count = 0;
-                erro_count++;
-                if(erro_count % 10 == 1) {
-                    fprintf(stderr, "[MODBUS-Placar-Térreo] Erro ao atualizar (total: %d erros)\n", erro_count);
+            struct timeval agora;
+            relogio_gettimeofday(&agora);
+            
+            // Primeira mudança de uma rajada: abre a janela de coalescência
+            if(mudou && !rajadaPendente) {
+                rajadaPendente = true;
+                inicioRajada = agora;
+            }
+            
+            long desdeRajada = (agora.tv_sec - inicioRajada.tv_sec) * 1000 +
+                               (agora.tv_usec - inicioRajada.tv_usec) / 1000;
+            bool refresh = (agora.tv_sec - ultimoCompleto.tv_sec) >= PLACAR_REFRESH_COMPLETO_S;
+            
+            if(refresh || (rajadaPendente && desdeRajada >= PLACAR_JANELA_COALESCENCIA_MS)) {
+                // ✅ Escreve no placar MODBUS 0x20 (conforme especificação)
+                // O árbitro coloca esta escrita atrás das transações das câmeras LPR
+                bool success = placar_update_delta(modbus_fd_terreo, &espelho, &placar, refresh);
+                
+                if(success) {
+                    rajadaPendente = false;
+                    if(refresh) {
+                        ultimoCompleto = agora;
+                    }
+                } else {
+                    static int erro_count = 0;
+                    erro_count++;
+                    if(erro_count % 10 == 1) {
+                        fprintf(stderr, "[MODBUS-Placar-Térreo] Erro ao atualizar (total: %d erros)\n", erro_count);
+                    }
                 }
             }
         }
         
-        // Atualiza a cada 1 segundo (conforme especificação)
-        delay(1000);
+        // Verificação frequente e barata: só vai ao barramento quando algo mudou
+        hal_delay(PLACAR_VERIFICACAO_MS);
     }
     
     return NULL;
@@ -626,7 +638,10 @@ void *enviaParametros(){
     addr.sin_addr.s_addr = inet_addr(ip);
     connect(sock, (struct sockaddr*)&addr, sizeof(addr));
     printf("Connected to Server\n");
+    double ultimoRelatorio = relogio_agora_ms();
     while(1){
+        relogio_liberar_thread();   // Espera o Central no socket: não segura o relógio virtual
+
         // Envia dados dos sensores ao Central
         send(sock, parametros, tamVetorEnviar * sizeof(int), 0);
         
@@ -636,7 +651,16 @@ void *enviaParametros(){
         // ✅ NOVO: Recebe dados do placar MODBUS do Central
         // Conforme especificação: "Placar: sob comando do Servidor Central, escrever..."
         recv(sock, dadosPlacar, tamDadosPlacar * sizeof(int), 0);
-        delay(1000);
+
+        // Relatório periódico dos tempos do laço de varredura e das cancelas
+        if(relogio_agora_ms() - ultimoRelatorio >= ritmoTerreo.relatorio_s * 1000.0){
+            ultimoRelatorio = relogio_agora_ms();
+            varredura_imprimir_estatisticas(&varreduraTerreo);
+            for(int i = 0; i < NUM_FAIXAS_TERREO; i++){
+                cancela_imprimir_estatisticas(&cancelasTerreo[i]);
+            }
+        }
+        hal_delay(1000);
     }
     close(sock);
     printf("Disconnected from server\n");
@@ -644,10 +668,22 @@ void *enviaParametros(){
 
 int mainT(){
     //mainT
-    if (!bcm2835_init())
+    if (!hal_gpio_init(HAL_PLACA_TERREO))
         return 1;
 
     configuraPinos();
+    for(int i = 0; i < NUM_FAIXAS_TERREO; i++){
+        const FaixaTerreo *f = &faixasTerreo[i];
+        configCancelas[i] = f->cancela;
+        cancela_tempos_do_ambiente(&configCancelas[i].tempos);
+        cancela_init(&cancelasTerreo[i], &configCancelas[i], f->entrada ? avisoCancelaEntrada : avisoCancelaSaida);
+        if(!lpr_adicionar_camera(f->camera, f->entrada)){
+            // Tabela de faixas inconsistente: sem a câmera a faixa nunca emitiria ticket
+            fprintf(stderr, "[Térreo] Câmera 0x%02X da faixa %d não registrada - abortando\n", f->camera, i);
+            hal_gpio_close();
+            return 1;
+        }
+    }
     carro = 0;
 
     v = calloc(4,sizeof(vaga));
@@ -657,7 +693,7 @@ int mainT(){
     
     // Aguarda 2 segundos para estabilizar os sensores
     printf("Aguardando estabilização dos sensores...\n");
-    delay(2000);
+    hal_delay(2000);
     
     // === INICIALIZA SISTEMA LPR (MODBUS) ===
     printf("\n╔═══════════════════════════════════════════════════════╗\n");
@@ -665,7 +701,7 @@ int mainT(){
     printf("╚═══════════════════════════════════════════════════════╝\n\n");
     
     // Tenta inicializar LPR - se falhar, continua em modo degradado
-    if(!lpr_init(MODBUS_SERIAL_PORT)) {
+    if(!lpr_init(modbus_porta_serial())) {
         printf("\n⚠️  AVISO: Sistema funcionará em MODO DEGRADADO\n");
         printf("    Todos os carros receberão tickets temporários (TEMP####)\n");
         printf("    Reconciliação manual será necessária via Central\n\n");
@@ -673,19 +709,21 @@ int mainT(){
         printf("\n✅ Sistema LPR operacional - Identificação automática de placas ativa\n\n");
     }
     
-    delay(1000);
+    hal_delay(1000);
 
-    pthread_t fEntrada, fSaida, fLeituraVagas, fEnviaParametros, fPlacarModbus;
+    pthread_t fLeituraVagas, fEnviaParametros, fPlacarModbus;
 
     pthread_create(&fLeituraVagas, NULL, chamaLeitura, NULL);
     pthread_create(&fEnviaParametros, NULL, enviaParametros, NULL);
-    pthread_create(&fEntrada,NULL,sensorEntrada,NULL);
-    pthread_create(&fSaida,NULL,sensorSaida,NULL);
+    // Cancelas de todas as faixas num pool pequeno de threads (máquina de estados em cancela.c)
+    numTrabalhadoresCancela = cancela_iniciar_trabalhadores(cancelasTerreo, NUM_FAIXAS_TERREO, trabalhadoresCancela);
     // ✅ NOVO: Thread do placar MODBUS (centralizada no Térreo conforme especificação)
     pthread_create(&fPlacarModbus, NULL, atualizaPlacarModbus, NULL);
 
-    pthread_join(fEntrada,NULL);
-    pthread_join(fSaida,NULL);
+    relogio_liberar_thread();    // A thread principal só espera as outras
+    for(int i = 0; i < numTrabalhadoresCancela; i++){
+        pthread_join(trabalhadoresCancela[i].thread, NULL);
+    }
     pthread_join(fLeituraVagas, NULL);
     pthread_join(fEnviaParametros, NULL);
     pthread_join(fPlacarModbus, NULL);  // ✅ Join da thread do placar
@@ -693,14 +731,10 @@ int mainT(){
     // Cleanup LPR
     lpr_cleanup();
     
-    // ✅ Cleanup MODBUS (centralizado no Térreo)
-    if(modbus_fd_terreo >= 0) {
-        pthread_mutex_lock(&mutex_modbus_terreo);
-        modbus_close(modbus_fd_terreo);
-        pthread_mutex_unlock(&mutex_modbus_terreo);
-        printf("[MODBUS-Placar-Térreo] Porta serial fechada\n");
-    }
+    // ✅ Cleanup MODBUS (centralizado no Térreo): encerra a thread dona do barramento
+    barramento_finalizar();
+    modbus_fd_terreo = -1;
     
-    bcm2835_close();
+    hal_gpio_close();
     return 0;
 }
\ No newline at end of file
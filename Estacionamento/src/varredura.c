@@ -0,0 +1,361 @@
+#include "../inc/varredura.h"
+#include "../inc/hal_gpio.h"
+#include "../inc/relogio.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Lê um inteiro do ambiente; ausente, inválido ou fora de [minimo, maximo] mantém o valor
+ * @return true se o valor veio do ambiente
+ */
+static bool ler_inteiro(const char *nome, long minimo, long maximo, unsigned int *valor) {
+    const char *texto = getenv(nome);
+    if (!texto || !texto[0]) {
+        return false;
+    }
+    char *fim;
+    long n = strtol(texto, &fim, 10);
+    if (*fim == '\0' && n >= minimo && n <= maximo) {
+        *valor = (unsigned int)n;
+        return true;
+    }
+    printf("[VARREDURA] %s inválido '%s', usando %u\n", nome, texto, *valor);
+    return false;
+}
+
+/**
+ * @brief Aplica ritmo e calibração do config.env definidos no ambiente
+ */
+void varredura_parametros_do_ambiente(RitmoVarredura *ritmo, CalibracaoVarredura *calibracao) {
+    RitmoVarredura lido = *ritmo;
+    ler_inteiro("VARREDURA_INTERVALO_RAPIDO_MS", 1, 60000, &lido.intervalo_rapido_ms);
+    ler_inteiro("VARREDURA_INTERVALO_LENTO_MS", 1, 60000, &lido.intervalo_lento_ms);
+    ler_inteiro("VARREDURA_RAPIDA_POR_MS", 0, 3600000, &lido.rapida_por_ms);
+    ler_inteiro("VARREDURA_RELATORIO_S", 1, 86400, &lido.relatorio_s);
+    if (lido.intervalo_lento_ms < lido.intervalo_rapido_ms) {
+        printf("[VARREDURA] Intervalo lento (%u ms) menor que o rápido (%u ms), usando %u/%u ms\n",
+               lido.intervalo_lento_ms, lido.intervalo_rapido_ms,
+               ritmo->intervalo_rapido_ms, ritmo->intervalo_lento_ms);
+        lido.intervalo_rapido_ms = ritmo->intervalo_rapido_ms;
+        lido.intervalo_lento_ms = ritmo->intervalo_lento_ms;
+    }
+    *ritmo = lido;
+
+    // Sem valor no ambiente fica a acomodação do descritor (0)
+    unsigned int acomodacao = calibracao->acomodacao_us ? calibracao->acomodacao_us : VARREDURA_ACOMODACAO_US;
+    if (ler_inteiro("VARREDURA_ACOMODACAO_US", VARREDURA_ACOMODACAO_MIN_US, VARREDURA_CALIBRACAO_MAX_US,
+                    &acomodacao)) {
+        calibracao->acomodacao_us = acomodacao;
+    }
+    ler_inteiro("VARREDURA_CALIBRACAO_MARGEM", 1, 10, &calibracao->margem);
+    ler_inteiro("VARREDURA_CALIBRACAO_FOLGA_US", 0, VARREDURA_CALIBRACAO_MAX_US, &calibracao->folga_us);
+    ler_inteiro("VARREDURA_RECALIBRACAO_MS", 1000, 86400000, &calibracao->recalibracao_ms);
+}
+
+/**
+ * @brief Prepara a varredura: monta a ordem de Gray das posições do multiplexador
+ */
+bool varredura_init(Varredura *v, const DescritorAndar *andar, const RitmoVarredura *ritmo,
+                    const CalibracaoVarredura *calibracao) {
+    bool valido = andar->num_enderecos >= 1 && andar->num_enderecos <= VARREDURA_MAX_ENDERECOS &&
+                  andar->num_grupos >= 1 && andar->num_grupos <= VARREDURA_MAX_GRUPOS &&
+                  andar->num_vagas >= 1 && andar->num_vagas <= andar->num_grupos << andar->num_enderecos &&
+                  andar->num_vagas <= VARREDURA_MAX_VAGAS;
+    // Os acessos em lote só alcançam os GPIO 0 a 31
+    for (int g = 0; valido && g < andar->num_grupos; g++) {
+        valido = andar->grupos[g].pino_sensor < 32;
+        for (int b = 0; valido && b < andar->num_enderecos; b++) {
+            valido = andar->grupos[g].pinos_endereco[b] < 32;
+        }
+    }
+    if (!valido) {
+        printf("[VARREDURA] Descritor inválido para %s\n", andar->nome);
+        return false;
+    }
+
+    memset(v, 0, sizeof(*v));
+    v->andar = andar;
+    v->endereco = -1;
+    v->calibracao = *calibracao;
+    v->acomodacao_us = calibracao->acomodacao_us ? calibracao->acomodacao_us : andar->acomodacao_us;
+    v->calibrada_ms = -1;
+    v->ritmo = *ritmo;
+    pthread_mutex_init(&v->mutex_ritmo, NULL);
+    pthread_cond_init(&v->cond_ritmo, NULL);
+    v->rapida_ate_ms = relogio_agora_ms() + ritmo->rapida_por_ms;   // Começa atento
+    v->rapida = true;
+    v->motivo = "início";
+    pthread_mutex_init(&v->mutex_estatisticas, NULL);
+    histograma_init(&v->estatisticas.periodo, VARREDURA_HIST_PERIODO_BASE_US);
+    histograma_init(&v->estatisticas.duracao, VARREDURA_HIST_PERIODO_BASE_US);
+    histograma_init(&v->estatisticas.passo, VARREDURA_HIST_PASSO_BASE_US);
+    histograma_init(&v->estatisticas.publicacao, VARREDURA_HIST_PUBLICACAO_BASE_US);
+    v->inicio_anterior_ms = -1;
+
+    for (int i = 0; i < andar->num_vagas; i++) {
+        v->todas |= MAPA_VAGA(i);
+        v->mascaras[andar->tipos[i]] |= MAPA_VAGA(i);
+    }
+
+    // Palavra de cada endereço, pronta para o acesso mascarado: a mesma posição
+    // é selecionada em todos os grupos de uma vez (linhas próprias ou compartilhadas)
+    int posicoes = 1 << andar->num_enderecos;
+    for (int g = 0; g < andar->num_grupos; g++) {
+        const GrupoMux *grupo = &andar->grupos[g];
+        v->mascara_sensores |= HAL_GPIO_BIT(grupo->pino_sensor);
+        for (int b = 0; b < andar->num_enderecos; b++) {
+            v->mascara_endereco |= HAL_GPIO_BIT(grupo->pinos_endereco[b]);
+        }
+        for (int e = 0; e < posicoes; e++) {
+            for (int b = 0; b < andar->num_enderecos; b++) {
+                if (e & (1 << b)) {
+                    v->palavras[e] |= HAL_GPIO_BIT(grupo->pinos_endereco[b]);
+                }
+            }
+        }
+    }
+
+    // Código Gray refletido: posições vizinhas diferem em um bit, inclusive na
+    // volta ao começo. O ciclo é sempre completo; pular as posições que não têm
+    // vaga juntaria endereços que diferem em mais de uma linha. As leituras
+    // dessas posições são descartadas em varredura_executar
+    for (int i = 0; i < posicoes; i++) {
+        v->ordem[v->passos++] = (uint8_t)(i ^ (i >> 1));
+    }
+    return true;
+}
+
+/**
+ * @brief Coloca um endereço nas linhas num só acesso ao GPIO
+ */
+static void selecionar(Varredura *v, int endereco) {
+    if (endereco != v->endereco) {
+        hal_gpio_write_mask(v->palavras[endereco], v->mascara_endereco);
+        v->endereco = endereco;
+    }
+}
+
+/**
+ * @brief Troca o endereço e relê o sensor até a saída estabilizar
+ * @return Microssegundos até o início da sequência estável, ou -1 se não estabilizou
+ */
+static double medir_troca(Varredura *v, int de, int para) {
+    selecionar(v, de);
+    hal_delay_us(VARREDURA_CALIBRACAO_MAX_US);
+
+    double inicio = relogio_agora_ms();
+    selecionar(v, para);
+
+    // Todas as linhas de sensor juntas: estável quando nenhuma muda
+    uint32_t ultimo = 0;
+    int iguais = 0;
+    double estavel_desde = 0;
+    while (1) {
+        double t = (relogio_agora_ms() - inicio) * 1000.0;
+        uint32_t nivel = hal_gpio_lev_todos() & v->mascara_sensores;
+        if (iguais == 0 || nivel != ultimo) {
+            ultimo = nivel;
+            iguais = 1;
+            estavel_desde = t;
+        } else {
+            iguais++;
+        }
+        if (iguais >= VARREDURA_CALIBRACAO_LEITURAS && t - estavel_desde >= VARREDURA_CALIBRACAO_JANELA_US) {
+            return estavel_desde;
+        }
+        // Falha só se a saída ainda mudava depois do limite (com releituras
+        // espaçadas, a confirmação da sequência estável pode passar dele)
+        if (estavel_desde > VARREDURA_CALIBRACAO_MAX_US || t > 4 * VARREDURA_CALIBRACAO_MAX_US) {
+            return -1;
+        }
+        hal_delay_us(VARREDURA_CALIBRACAO_PASSO_US);
+    }
+}
+
+/**
+ * @brief Mede a acomodação do multiplexador e ajusta a espera da varredura
+ */
+bool varredura_calibrar(Varredura *v) {
+    double pior = 0;
+    v->calibrada_ms = relogio_agora_ms();
+
+    // As mesmas trocas que a varredura faz, incluindo a volta ao começo
+    for (int r = 0; r < VARREDURA_CALIBRACAO_REPETICOES; r++) {
+        for (int p = 0; p < v->passos; p++) {
+            int de = v->ordem[(p + v->passos - 1) % v->passos];
+            double us = medir_troca(v, de, v->ordem[p]);
+            if (us < 0) {
+                printf("[VARREDURA] %s: multiplexador não estabilizou em %d µs, acomodação continua %u µs\n",
+                       v->andar->nome, VARREDURA_CALIBRACAO_MAX_US, v->acomodacao_us);
+                return false;
+            }
+            if (us > pior) {
+                pior = us;
+            }
+        }
+    }
+
+    unsigned int nova = (unsigned int)(pior * v->calibracao.margem) + v->calibracao.folga_us;
+    if (nova < VARREDURA_ACOMODACAO_MIN_US) {
+        nova = VARREDURA_ACOMODACAO_MIN_US;
+    }
+    if (nova > VARREDURA_CALIBRACAO_MAX_US) {
+        nova = VARREDURA_CALIBRACAO_MAX_US;
+    }
+    v->acomodacao_medida_us = (unsigned int)pior;
+    if (nova != v->acomodacao_us) {
+        printf("[VARREDURA] %s: acomodação medida %u µs, usando %u µs (antes %u µs)\n",
+               v->andar->nome, v->acomodacao_medida_us, nova, v->acomodacao_us);
+    }
+    v->acomodacao_us = nova;
+    return true;
+}
+
+/**
+ * @brief Lê todas as vagas do andar
+ */
+MapaVagas varredura_executar(Varredura *v) {
+    const DescritorAndar *andar = v->andar;
+    MapaVagas ocupadas = 0;
+    double passos_us[VARREDURA_MAX_VAGAS];
+
+    double chamada = relogio_agora_ms();
+    double inicio = chamada;
+    if (v->calibrada_ms < 0 || chamada - v->calibrada_ms >= v->calibracao.recalibracao_ms) {
+        varredura_calibrar(v);
+        inicio = relogio_agora_ms();
+    }
+
+    // Um passo por posição: todos os grupos são lidos do mesmo retrato do GPIO
+    double marca = inicio;
+    for (int p = 0; p < v->passos; p++) {
+        int endereco = v->ordem[p];
+        selecionar(v, endereco);
+        hal_delay_us(v->acomodacao_us);
+        uint32_t niveis = hal_gpio_lev_todos();
+        for (int g = 0, vaga = endereco; g < andar->num_grupos; g++, vaga += 1 << andar->num_enderecos) {
+            if (vaga < andar->num_vagas && HAL_GPIO_NIVEL(niveis, andar->grupos[g].pino_sensor) == HIGH) {
+                ocupadas |= MAPA_VAGA(vaga);
+            }
+        }
+        double agora = relogio_agora_ms();
+        passos_us[p] = (agora - marca) * 1000.0;
+        marca = agora;
+    }
+
+    // Publica os tempos desta varredura de uma vez
+    VarreduraEstatisticas *e = &v->estatisticas;
+    pthread_mutex_lock(&v->mutex_estatisticas);
+    e->varreduras++;
+    e->acomodacao_us = v->acomodacao_us;
+    if (v->inicio_anterior_ms >= 0) {
+        histograma_registrar(&e->periodo, (chamada - v->inicio_anterior_ms) * 1000.0);
+    }
+    histograma_registrar(&e->duracao, (marca - inicio) * 1000.0);
+    for (int p = 0; p < v->passos; p++) {
+        histograma_registrar(&e->passo, passos_us[p]);
+    }
+    pthread_mutex_unlock(&v->mutex_estatisticas);
+    v->inicio_anterior_ms = chamada;
+
+    return ocupadas;
+}
+
+/**
+ * @brief Registra a publicação de uma entrada ou cobrança do andar
+ */
+void varredura_registrar_publicacao(Varredura *v, double atraso_ms) {
+    pthread_mutex_lock(&v->mutex_estatisticas);
+    v->estatisticas.publicacoes++;
+    histograma_registrar(&v->estatisticas.publicacao, atraso_ms * 1000.0);
+    pthread_mutex_unlock(&v->mutex_estatisticas);
+}
+
+/**
+ * @brief Copia as estatísticas do laço de varredura
+ */
+void varredura_estatisticas_obter(Varredura *v, VarreduraEstatisticas *out) {
+    pthread_mutex_lock(&v->mutex_estatisticas);
+    *out = v->estatisticas;
+    pthread_mutex_unlock(&v->mutex_estatisticas);
+    out->intervalo_ms = varredura_intervalo_ms(v);
+}
+
+/**
+ * @brief Imprime contadores e histogramas do laço de varredura do andar
+ */
+void varredura_imprimir_estatisticas(Varredura *v) {
+    VarreduraEstatisticas e;
+    varredura_estatisticas_obter(v, &e);
+
+    char prefixo[48];
+    snprintf(prefixo, sizeof(prefixo), "[VARREDURA %s]", v->andar->nome);
+    printf("%s varreduras=%lu ritmo=%u ms acomodação=%u µs publicações=%lu\n",
+           prefixo, e.varreduras, e.intervalo_ms, e.acomodacao_us, e.publicacoes);
+    histograma_imprimir(prefixo, "período", &e.periodo);
+    histograma_imprimir(prefixo, "duração", &e.duracao);
+    histograma_imprimir(prefixo, "passo", &e.passo);
+    histograma_imprimir(prefixo, "detecção→publicação", &e.publicacao);
+}
+
+/**
+ * @brief Vagas livres de um tipo
+ */
+int varredura_livres(const Varredura *v, MapaVagas ocupadas, TipoVaga tipo) {
+    return mapa_contar(v->mascaras[tipo] & ~ocupadas);
+}
+
+/**
+ * @brief Avisa atividade ligada ao andar
+ */
+void varredura_atividade(Varredura *v, const char *motivo) {
+    pthread_mutex_lock(&v->mutex_ritmo);
+    v->rapida_ate_ms = relogio_agora_ms() + v->ritmo.rapida_por_ms;
+    v->motivo = motivo;
+    if (!v->rapida) {
+        // Corta a espera lenta em andamento
+        relogio_sinalizar(&v->cond_ritmo);
+    }
+    pthread_mutex_unlock(&v->mutex_ritmo);
+}
+
+/**
+ * @brief Espera até a próxima varredura, no ritmo atual
+ */
+void varredura_aguardar(Varredura *v) {
+    pthread_mutex_lock(&v->mutex_ritmo);
+    double inicio = relogio_agora_ms();
+    while (1) {
+        double agora = relogio_agora_ms();
+        bool rapida = agora < v->rapida_ate_ms;
+        if (rapida != v->rapida) {
+            v->rapida = rapida;
+            if (rapida) {
+                printf("[VARREDURA] %s: ritmo rápido (%u ms) - %s\n",
+                       v->andar->nome, v->ritmo.intervalo_rapido_ms, v->motivo);
+            } else {
+                printf("[VARREDURA] %s: ritmo lento (%u ms) - %u s sem atividade\n",
+                       v->andar->nome, v->ritmo.intervalo_lento_ms, v->ritmo.rapida_por_ms / 1000);
+            }
+        }
+
+        unsigned int intervalo = rapida ? v->ritmo.intervalo_rapido_ms : v->ritmo.intervalo_lento_ms;
+        double resta = inicio + intervalo - agora;
+        if (resta <= 0) {
+            break;
+        }
+        relogio_esperar_cond(&v->cond_ritmo, &v->mutex_ritmo, (unsigned int)resta + 1);
+    }
+    pthread_mutex_unlock(&v->mutex_ritmo);
+}
+
+/**
+ * @brief Intervalo atual entre varreduras do andar
+ */
+unsigned int varredura_intervalo_ms(Varredura *v) {
+    pthread_mutex_lock(&v->mutex_ritmo);
+    unsigned int intervalo = v->rapida ? v->ritmo.intervalo_rapido_ms : v->ritmo.intervalo_lento_ms;
+    pthread_mutex_unlock(&v->mutex_ritmo);
+    return intervalo;
+}